@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 template <int T>
 struct Int2Type
 {
@@ -19,4 +21,11 @@ template <typename T>
 FORCEINLINE T Aligned(T A, T Align)
 {
 	return (A + (Align - 1)) & ~(Align - 1);
+}
+
+// 여러 값의 해시를 하나로 합침 (boost::hash_combine 과 같은 방식)
+template <typename T>
+FORCEINLINE void HashCombine(size_t& seed, const T& value)
+{
+	seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 }
\ No newline at end of file
@@ -8,9 +8,21 @@ layout(binding = 1) uniform sampler2D texSampler;
 
 layout(location = 0) out vec4 outColor;
 
+// ͸  (jMaterialFeature).  鶧  Ƿ  б  ܰ迡 ŵ.
+layout(constant_id = 0) const bool USE_VERTEX_COLOR = false;
+layout(constant_id = 1) const bool USE_TEXTURE = true;
+layout(constant_id = 2) const bool USE_ALPHA_TEST = false;
+layout(constant_id = 3) const float ALPHA_CUTOFF = 0.5;
+
 void main() 
 {
-    //outColor = vec4(fragTexCoord, 0.0, 1.0);
-    outColor = vec4(texture(texSampler, fragTexCoord).rgb, 1.0);
-    //outColor = vec4(fragColor * texture(texSampler, fragTexCoord * 2.0).rgb, 1.0);
+    vec4 color = vec4(1.0);
+    if (USE_TEXTURE)
+        color = texture(texSampler, fragTexCoord);
+    if (USE_VERTEX_COLOR)
+        color.rgb *= fragColor;
+    if (USE_ALPHA_TEST && (color.a < ALPHA_CUTOFF))
+        discard;
+
+    outColor = vec4(color.rgb, 1.0);
 }
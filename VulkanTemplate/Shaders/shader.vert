@@ -3,7 +3,6 @@
 
 layout(binding = 0) uniform UniformBufferObject
 {
-    mat4 Model;
     mat4 View;
     mat4 Proj;
 } ubo;
@@ -12,6 +11,9 @@ layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 
+// νϽ    Ѿ Model  (jInstanceData). mat4  location  4(3 ~ 6) .
+layout(location = 3) in mat4 inModel;
+
 /*
 // dvec3  64Ʈ vectors  location ϳ    .
 layout(location = 0) in dvec3 inPosition;   // dvec3 is 64 bit vector.
@@ -23,7 +25,7 @@ layout(location = 1) out vec2 fragTexCoord;
 
 void main() 
 {
-    gl_Position = ubo.Proj * ubo.View * ubo.Model * vec4(inPosition, 1.0);
+    gl_Position = ubo.Proj * ubo.View * inModel * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
 }
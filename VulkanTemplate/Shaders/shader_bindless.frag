@@ -0,0 +1,32 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragTextureIndex;
+
+// ũ  ؽ 迭 (jBindlessDescriptorSet::TextureArrayBinding)
+layout(set = 1, binding = 1) uniform sampler2D textures[];
+
+layout(location = 0) out vec4 outColor;
+
+// ͸  (jMaterialFeature).  鶧  Ƿ  б  ܰ迡 ŵ.
+layout(constant_id = 0) const bool USE_VERTEX_COLOR = false;
+layout(constant_id = 1) const bool USE_TEXTURE = true;
+layout(constant_id = 2) const bool USE_ALPHA_TEST = false;
+layout(constant_id = 3) const float ALPHA_CUTOFF = 0.5;
+
+void main() 
+{
+    vec4 color = vec4(1.0);
+    //  ο ȿ ε ޶  Ƿ nonuniformEXT  ξ 
+    if (USE_TEXTURE)
+        color = texture(textures[nonuniformEXT(fragTextureIndex)], fragTexCoord);
+    if (USE_VERTEX_COLOR)
+        color.rgb *= fragColor;
+    if (USE_ALPHA_TEST && (color.a < ALPHA_CUTOFF))
+        discard;
+
+    outColor = vec4(color.rgb, 1.0);
+}
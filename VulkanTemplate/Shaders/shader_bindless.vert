@@ -0,0 +1,41 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Bindless ο ϴ ̴. Model  Push constant  Ʈ Storage buffer  .
+
+layout(set = 0, binding = 0) uniform UniformBufferObject
+{
+    mat4 View;
+    mat4 Proj;
+} ubo;
+
+// jObjectData  ƾ  (std430 stride 80 bytes)
+struct ObjectData
+{
+    mat4 Model;
+    uint TextureIndex;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer
+{
+    ObjectData objects[];
+} objectBuffer;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTextureIndex;
+
+void main() 
+{
+    // ο firstInstance  Ʈ ε Ѿ
+    ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+
+    gl_Position = ubo.Proj * ubo.View * object.Model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    fragTexCoord = inTexCoord;
+    fragTextureIndex = object.TextureIndex;
+}
@@ -0,0 +1,27 @@
+@echo off
+rem Ʈ Vulkan (lavapipe, SwiftShader)  Bindless   Instance stream η ׷.
+rem  : RunSoftwareFallback.bat <ICD json > [Release or Debug]
+rem   ex) RunSoftwareFallback.bat C:\mesa\x64\lvp_icd.x86_64.json Release
+rem VK_ICD_FILENAMES   ICD  ̹Ƿ  GPU  ־ Ʈ  õ.
+setlocal
+
+if "%~1"=="" (
+	echo ICD json ΰ ʿ
+	exit /b 1
+)
+
+set VK_ICD_FILENAMES=%~1
+set CONFIGURATION=%~2
+if "%CONFIGURATION%"=="" set CONFIGURATION=Release
+
+rem ̴ , ؽĸ  η Ƿ Ʈ  
+pushd "%~dp0.."
+"x64\%CONFIGURATION%\VulkanTemplate.exe" --no-bindless --frames 120
+set RESULT=%ERRORLEVEL%
+popd
+
+if not "%RESULT%"=="0" (
+	echo FAILED : %RESULT%
+	exit /b %RESULT%
+)
+echo PASSED
@@ -0,0 +1,34 @@
+﻿#include "jTest.h"
+
+#include <cstdlib>
+
+static int CurrentFailureCount = 0;
+
+std::vector<jTestCase>& GetTestCases()
+{
+	static std::vector<jTestCase> TestCases;
+	return TestCases;
+}
+
+void ReportTestFailure(const char* expression, const char* file, int line)
+{
+	printf("  FAILED : %s\n    %s, (line %d)\n", expression, file, line);
+	++CurrentFailureCount;
+}
+
+int main()
+{
+	int failedTestCount = 0;
+	for (const jTestCase& testCase : GetTestCases())
+	{
+		CurrentFailureCount = 0;
+		testCase.Func();
+
+		printf("[%s] %s\n", CurrentFailureCount ? "FAIL" : " OK ", testCase.Name);
+		if (CurrentFailureCount)
+			++failedTestCount;
+	}
+
+	printf("%d / %d tests passed\n", static_cast<int>(GetTestCases().size()) - failedTestCount, static_cast<int>(GetTestCases().size()));
+	return failedTestCount ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+﻿#include <pch.h>
+#include "jTest.h"
+#include "jDeviceCapabilities.h"
+#include "jMemoryAllocator.h"
+
+// 대표적인 디바이스들의 메모리 속성 테이블로 메모리 타입 우선순위와 UMA / Direct upload 판단을 확인함.
+static constexpr VkMemoryPropertyFlags DL = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+static constexpr VkMemoryPropertyFlags HV = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+static constexpr VkMemoryPropertyFlags HC = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+static constexpr VkMemoryPropertyFlags HCA = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+static constexpr VkDeviceSize MB = 1024 * 1024;
+static constexpr VkDeviceSize GB = 1024 * MB;
+
+struct jMemoryTypeDesc
+{
+	VkMemoryPropertyFlags Flags;
+	uint32_t HeapIndex;
+};
+
+struct jMemoryHeapDesc
+{
+	VkDeviceSize Size;
+	VkMemoryHeapFlags Flags;
+};
+
+struct jCandidateQuery
+{
+	uint32_t MemoryTypeBits;
+	VkMemoryPropertyFlags Required;
+	VkMemoryPropertyFlags Preferred;
+	std::vector<uint32_t> Expected;		// 우선순위 순서, 비어있으면 찾지 못해야 함
+};
+
+struct jMemoryPropertiesTable
+{
+	const char* Name;
+	std::vector<jMemoryHeapDesc> Heaps;
+	std::vector<jMemoryTypeDesc> Types;
+	bool UMA;
+	bool DirectUploadAvailable;
+	std::vector<jCandidateQuery> Queries;
+};
+
+static VkPhysicalDeviceMemoryProperties MakeMemoryProperties(const jMemoryPropertiesTable& table)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties = {};
+	memoryProperties.memoryHeapCount = static_cast<uint32_t>(table.Heaps.size());
+	for (size_t i = 0; i < table.Heaps.size(); ++i)
+	{
+		memoryProperties.memoryHeaps[i].size = table.Heaps[i].Size;
+		memoryProperties.memoryHeaps[i].flags = table.Heaps[i].Flags;
+	}
+
+	memoryProperties.memoryTypeCount = static_cast<uint32_t>(table.Types.size());
+	for (size_t i = 0; i < table.Types.size(); ++i)
+	{
+		memoryProperties.memoryTypes[i].propertyFlags = table.Types[i].Flags;
+		memoryProperties.memoryTypes[i].heapIndex = table.Types[i].HeapIndex;
+	}
+	return memoryProperties;
+}
+
+static const std::vector<jMemoryPropertiesTable>& GetMemoryPropertiesTables()
+{
+	static const std::vector<jMemoryPropertiesTable> Tables =
+	{
+		{
+			// 외장 GPU, Resizable BAR 꺼짐. DEVICE_LOCAL | HOST_VISIBLE 는 256MB BAR 영역뿐임.
+			"Discrete",
+			{ { 8 * GB, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT }, { 16 * GB, 0 }, { 256 * MB, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT } },
+			{ { DL, 0 }, { HV | HC, 1 }, { HV | HC | HCA, 1 }, { DL | HV | HC, 2 } },
+			false, false,
+			{
+				{ ~0u, DL, 0, { 0, 3 } },					// DEVICE_LOCAL 만 요청하면 BAR 영역은 뒤로 밀려야 함
+				{ ~0u, HV | HC, 0, { 1, 2, 3 } },			// Staging
+				{ ~0u, HV, HCA, { 2, 1, 3 } },				// Readback
+				{ ~0u, HV | HC, DL, { 3, 1, 2 } },			// 자주 바뀌는 Uniform
+				{ 0xe, DL, 0, { 3 } },						// memoryTypeBits 로 걸러짐
+				{ ~0u, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, 0, {} },
+			},
+		},
+		{
+			// 외장 GPU, Resizable BAR 켜짐. VRAM 전체를 CPU 에서 접근할 수 있음.
+			"ReBAR",
+			{ { 8 * GB, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT }, { 16 * GB, 0 } },
+			{ { DL, 0 }, { HV | HC, 1 }, { HV | HC | HCA, 1 }, { DL | HV | HC, 0 } },
+			false, true,
+			{
+				{ ~0u, DL, 0, { 0, 3 } },
+				{ ~0u, HV | HC, 0, { 1, 2, 3 } },
+				{ ~0u, HV | HC, DL, { 3, 1, 2 } },
+			},
+		},
+		{
+			// 통합 GPU. 모든 Heap 이 DEVICE_LOCAL 임.
+			"Integrated",
+			{ { 16 * GB, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT } },
+			{ { DL, 0 }, { DL | HV | HC, 0 }, { DL | HV | HC | HCA, 0 } },
+			true, true,
+			{
+				{ ~0u, DL, 0, { 0, 1, 2 } },
+				{ ~0u, HV | HC, 0, { 1, 2 } },
+				{ ~0u, HV, HCA, { 2, 1 } },
+				{ ~0u, HV | HC, DL, { 1, 2 } },
+			},
+		},
+		{
+			// 소프트웨어 구현(lavapipe, SwiftShader). 모든 플래그를 가진 메모리 타입 하나뿐임.
+			"Software",
+			{ { 2 * GB, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT } },
+			{ { DL | HV | HC | HCA, 0 } },
+			true, true,
+			{
+				{ ~0u, DL, 0, { 0 } },
+				{ ~0u, HV | HC, DL, { 0 } },
+				{ ~0u, HV, HCA, { 0 } },
+				{ ~0u, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, 0, {} },
+			},
+		},
+	};
+	return Tables;
+}
+
+JTEST(DeviceCapabilities_FindMemoryTypeCandidates)
+{
+	for (const jMemoryPropertiesTable& table : GetMemoryPropertiesTables())
+	{
+		const VkPhysicalDeviceMemoryProperties memoryProperties = MakeMemoryProperties(table);
+		for (const jCandidateQuery& query : table.Queries)
+		{
+			std::vector<uint32_t> candidates;
+			const bool found = jDeviceCapabilities::FindMemoryTypeCandidates(memoryProperties, query.MemoryTypeBits, query.Required, query.Preferred, candidates);
+			JTEST_CHECK(found == !query.Expected.empty());
+			JTEST_CHECK(candidates == query.Expected);
+			if (candidates != query.Expected)
+				printf("    %s : typeBits 0x%x, required 0x%x, preferred 0x%x\n", table.Name, query.MemoryTypeBits, query.Required, query.Preferred);
+		}
+	}
+}
+
+JTEST(DeviceCapabilities_GetMemoryTypeCandidatesCached)
+{
+	for (const jMemoryPropertiesTable& table : GetMemoryPropertiesTables())
+	{
+		jDeviceCapabilities capabilities;
+		capabilities.InitializeMemoryProperties(MakeMemoryProperties(table));
+
+		for (const jCandidateQuery& query : table.Queries)
+		{
+			// 두번째 요청은 캐시에서 같은 결과를 돌려줘야 함
+			const std::vector<uint32_t>& first = capabilities.GetMemoryTypeCandidates(query.MemoryTypeBits, query.Required, query.Preferred);
+			const std::vector<uint32_t>& second = capabilities.GetMemoryTypeCandidates(query.MemoryTypeBits, query.Required, query.Preferred);
+			JTEST_CHECK(&first == &second);
+			JTEST_CHECK(first == query.Expected);
+
+			uint32_t memoryTypeIndex = 0;
+			const bool found = capabilities.FindMemoryType(query.MemoryTypeBits, query.Required, memoryTypeIndex);
+			JTEST_CHECK(found == !query.Expected.empty());
+		}
+	}
+}
+
+JTEST(MemoryAllocator_DirectUploadDetection)
+{
+	for (const jMemoryPropertiesTable& table : GetMemoryPropertiesTables())
+	{
+		jDeviceCapabilities capabilities;
+		capabilities.InitializeMemoryProperties(MakeMemoryProperties(table));
+
+		// Initialize 는 메모리 속성만 읽으므로 디바이스 없이 확인 가능
+		jMemoryAllocator allocator;
+		allocator.Initialize(VK_NULL_HANDLE, capabilities);
+		JTEST_CHECK(allocator.IsUMA() == table.UMA);
+		JTEST_CHECK(allocator.IsDirectUploadAvailable() == table.DirectUploadAvailable);
+		if ((allocator.IsUMA() != table.UMA) || (allocator.IsDirectUploadAvailable() != table.DirectUploadAvailable))
+			printf("    %s\n", table.Name);
+		allocator.Release();
+	}
+}
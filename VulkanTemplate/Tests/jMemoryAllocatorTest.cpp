@@ -0,0 +1,443 @@
+﻿#include <pch.h>
+#include "jTest.h"
+#include "jMemoryAllocator.h"
+#include "jDeviceCapabilities.h"
+
+#include <vector>
+
+// jMemoryBlock 은 VkDeviceMemory 핸들을 들고만 있으므로 VK_NULL_HANDLE 로 Free list 동작만 확인함.
+static constexpr VkDeviceSize TestBlockSize = 1024;
+
+struct jTestRange
+{
+	VkDeviceSize Offset = 0;
+	VkDeviceSize RangeOffset = 0;
+	VkDeviceSize RangeSize = 0;
+};
+
+static bool Allocate(jMemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, jTestRange& outRange)
+{
+	return block.Allocate(size, alignment, outRange.Offset, outRange.RangeOffset, outRange.RangeSize);
+}
+
+static void Free(jMemoryBlock& block, const jTestRange& range)
+{
+	block.Free(range.RangeOffset, range.RangeSize);
+}
+
+JTEST(MemoryBlock_AllocateSequential)
+{
+	jMemoryBlock block(VK_NULL_HANDLE, TestBlockSize, 0, nullptr);
+
+	jTestRange a, b;
+	JTEST_CHECK(Allocate(block, 256, 1, a));
+	JTEST_CHECK(Allocate(block, 256, 1, b));
+	JTEST_CHECK(a.Offset == 0 && a.RangeOffset == 0 && a.RangeSize == 256);
+	JTEST_CHECK(b.Offset == 256 && b.RangeOffset == 256 && b.RangeSize == 256);
+	JTEST_CHECK(block.GetUsedSize() == 512);
+	JTEST_CHECK(block.GetAllocationCount() == 2);
+
+	Free(block, a);
+	Free(block, b);
+	JTEST_CHECK(block.IsEmpty());
+	JTEST_CHECK(block.GetUsedSize() == 0);
+}
+
+JTEST(MemoryBlock_ZeroSizeFails)
+{
+	jMemoryBlock block(VK_NULL_HANDLE, TestBlockSize, 0, nullptr);
+
+	jTestRange a;
+	JTEST_CHECK(!Allocate(block, 0, 1, a));
+	JTEST_CHECK(block.IsEmpty());
+}
+
+JTEST(MemoryBlock_Alignment)
+{
+	jMemoryBlock block(VK_NULL_HANDLE, TestBlockSize, 0, nullptr);
+
+	jTestRange a, b;
+	JTEST_CHECK(Allocate(block, 10, 1, a));
+	JTEST_CHECK(Allocate(block, 16, 64, b));
+
+	// 앞쪽 정렬 패딩은 사용 영역에 포함됨
+	JTEST_CHECK(b.Offset == 64);
+	JTEST_CHECK(b.RangeOffset == 10);
+	JTEST_CHECK(b.RangeSize == 70);
+	JTEST_CHECK(block.GetUsedSize() == 80);
+
+	// alignment 0 은 1 로 취급함
+	jTestRange c;
+	JTEST_CHECK(Allocate(block, 3, 0, c));
+	JTEST_CHECK(c.Offset == 80 && c.RangeSize == 3);
+
+	// 패딩까지 같이 돌아와서 전체 블럭을 다시 쓸 수 있어야 함
+	Free(block, b);
+	Free(block, a);
+	Free(block, c);
+	jTestRange whole;
+	JTEST_CHECK(Allocate(block, TestBlockSize, 256, whole));
+	JTEST_CHECK(whole.Offset == 0);
+}
+
+JTEST(MemoryBlock_CoalesceOnFree)
+{
+	// 반환 순서와 관계없이 인접한 빈 영역이 모두 합쳐져야 함
+	const int freeOrders[][3] = { { 0, 1, 2 }, { 2, 1, 0 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 } };
+	for (const auto& freeOrder : freeOrders)
+	{
+		jMemoryBlock block(VK_NULL_HANDLE, TestBlockSize, 0, nullptr);
+
+		jTestRange ranges[4];
+		for (jTestRange& range : ranges)
+			JTEST_CHECK(Allocate(block, 256, 1, range));
+
+		for (int index : freeOrder)
+			Free(block, ranges[index]);
+
+		// 마지막 영역이 남아있으므로 앞쪽 768 바이트가 하나로 합쳐져 있어야 함
+		jTestRange merged;
+		JTEST_CHECK(Allocate(block, 768, 1, merged));
+		JTEST_CHECK(merged.Offset == 0);
+
+		Free(block, merged);
+		Free(block, ranges[3]);
+		JTEST_CHECK(block.IsEmpty());
+	}
+}
+
+JTEST(MemoryBlock_OutOfSpace)
+{
+	jMemoryBlock block(VK_NULL_HANDLE, TestBlockSize, 0, nullptr);
+
+	jTestRange tooLarge;
+	JTEST_CHECK(!Allocate(block, TestBlockSize + 1, 1, tooLarge));
+
+	jTestRange whole;
+	JTEST_CHECK(Allocate(block, TestBlockSize, 1, whole));
+
+	jTestRange extra;
+	JTEST_CHECK(!Allocate(block, 1, 1, extra));
+	JTEST_CHECK(block.GetAllocationCount() == 1);
+
+	Free(block, whole);
+
+	// 전체 빈 공간은 충분해도 연속된 영역이 없으면 실패해야 함
+	jTestRange ranges[4];
+	for (jTestRange& range : ranges)
+		JTEST_CHECK(Allocate(block, 256, 1, range));
+	Free(block, ranges[1]);
+	Free(block, ranges[3]);
+
+	jTestRange fragmented;
+	JTEST_CHECK(!Allocate(block, 512, 1, fragmented));
+	JTEST_CHECK(block.GetUsedSize() == 512);
+
+	// 정렬 패딩 때문에 들어가지 못하는 경우
+	jTestRange padded;
+	JTEST_CHECK(!Allocate(block, 256, 512, padded));
+}
+
+JTEST(MemoryBlock_BestFit)
+{
+	jMemoryBlock block(VK_NULL_HANDLE, TestBlockSize, 0, nullptr);
+
+	jTestRange a, b, c, d;
+	JTEST_CHECK(Allocate(block, 512, 1, a));
+	JTEST_CHECK(Allocate(block, 128, 1, b));
+	JTEST_CHECK(Allocate(block, 128, 1, c));
+	JTEST_CHECK(Allocate(block, 256, 1, d));
+
+	// 512 와 128 크기의 빈 영역 중 남는 공간이 적은 쪽을 써야 함
+	Free(block, a);
+	Free(block, c);
+
+	jTestRange small;
+	JTEST_CHECK(Allocate(block, 100, 1, small));
+	JTEST_CHECK(small.Offset == 640);
+
+	// 딱 맞는 영역이 있으면 그 영역을 씀
+	jTestRange exact;
+	JTEST_CHECK(Allocate(block, 512, 1, exact));
+	JTEST_CHECK(exact.Offset == 0);
+}
+
+JTEST(MemoryBlock_MappedData)
+{
+	uint8_t memory[64] = {};
+	jMemoryBlock block(VK_NULL_HANDLE, sizeof(memory), 0, memory);
+	JTEST_CHECK(block.GetMappedData() == memory);
+	JTEST_CHECK(block.GetSize() == sizeof(memory));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// jMemoryAllocator 는 jMemoryDeviceFunctions 에 가짜 디바이스를 연결해서 확인함.
+struct jFakeDeviceMemory
+{
+	VkDeviceSize Size = 0;
+	uint32_t MemoryTypeIndex = 0;
+	std::vector<uint8_t> Data;
+};
+
+struct jFakeDevice
+{
+	uint32_t AllocateCount = 0;
+	uint32_t FreeCount = 0;
+	uint32_t MapCount = 0;
+	VkDeviceSize MaxAllocationSize = ~0ull;		// 이보다 큰 vkAllocateMemory 는 VK_ERROR_OUT_OF_DEVICE_MEMORY 로 실패함
+	uint32_t FullMemoryTypeBits = 0;			// 이 메모리 타입들의 Heap 은 가득찬 것으로 취급함
+
+	uint32_t GetLiveCount() const { return AllocateCount - FreeCount; }
+};
+static jFakeDevice FakeDevice;
+
+static VKAPI_ATTR VkResult VKAPI_CALL FakeAllocateMemory(VkDevice, const VkMemoryAllocateInfo* allocateInfo, const VkAllocationCallbacks*, VkDeviceMemory* outMemory)
+{
+	if ((allocateInfo->allocationSize > FakeDevice.MaxAllocationSize) || (FakeDevice.FullMemoryTypeBits & (1 << allocateInfo->memoryTypeIndex)))
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+	jFakeDeviceMemory* memory = new jFakeDeviceMemory();
+	memory->Size = allocateInfo->allocationSize;
+	memory->MemoryTypeIndex = allocateInfo->memoryTypeIndex;
+	*outMemory = reinterpret_cast<VkDeviceMemory>(memory);
+	++FakeDevice.AllocateCount;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL FakeFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*)
+{
+	delete reinterpret_cast<jFakeDeviceMemory*>(memory);
+	++FakeDevice.FreeCount;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL FakeMapMemory(VkDevice, VkDeviceMemory memory, VkDeviceSize, VkDeviceSize, VkMemoryMapFlags, void** outData)
+{
+	jFakeDeviceMemory* fakeMemory = reinterpret_cast<jFakeDeviceMemory*>(memory);
+	fakeMemory->Data.resize(static_cast<size_t>(fakeMemory->Size));
+	*outData = fakeMemory->Data.data();
+	++FakeDevice.MapCount;
+	return VK_SUCCESS;
+}
+
+static jFakeDeviceMemory* GetFakeMemory(const jMemoryAllocation& allocation)
+{
+	return reinterpret_cast<jFakeDeviceMemory*>(allocation.Memory);
+}
+
+// Type 0 : DEVICE_LOCAL (Heap 0), Type 1 : HOST_VISIBLE | HOST_COHERENT (Heap 1)
+static constexpr uint32_t TestDeviceLocalType = 0;
+static constexpr uint32_t TestHostVisibleType = 1;
+static constexpr VkDeviceSize TestHeapSize = 1024 * 1024;
+
+// jMemoryAllocator 는 Capabilities 를 포인터로 들고 있으므로 할당자보다 오래 살아있어야 함
+static jDeviceCapabilities TestCapabilities;
+
+static void InitializeTestAllocator(jMemoryAllocator& allocator)
+{
+	FakeDevice = jFakeDevice();
+
+	VkPhysicalDeviceMemoryProperties memoryProperties = {};
+	memoryProperties.memoryHeapCount = 2;
+	memoryProperties.memoryHeaps[0].size = TestHeapSize;
+	memoryProperties.memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+	memoryProperties.memoryHeaps[1].size = TestHeapSize;
+	memoryProperties.memoryTypeCount = 2;
+	memoryProperties.memoryTypes[TestDeviceLocalType].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	memoryProperties.memoryTypes[TestDeviceLocalType].heapIndex = 0;
+	memoryProperties.memoryTypes[TestHostVisibleType].propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	memoryProperties.memoryTypes[TestHostVisibleType].heapIndex = 1;
+
+	jMemoryDeviceFunctions deviceFunctions;
+	deviceFunctions.AllocateMemory = FakeAllocateMemory;
+	deviceFunctions.FreeMemory = FakeFreeMemory;
+	deviceFunctions.MapMemory = FakeMapMemory;
+	TestCapabilities = jDeviceCapabilities();
+	TestCapabilities.InitializeMemoryProperties(memoryProperties);
+	allocator.Initialize(VK_NULL_HANDLE, TestCapabilities, TestBlockSize, deviceFunctions);
+}
+
+static VkMemoryRequirements MakeRequirements(VkDeviceSize size, VkDeviceSize alignment)
+{
+	VkMemoryRequirements requirements = {};
+	requirements.size = size;
+	requirements.alignment = alignment;
+	requirements.memoryTypeBits = (1 << TestDeviceLocalType) | (1 << TestHostVisibleType);
+	return requirements;
+}
+
+JTEST(MemoryAllocator_SubAllocateFromBlock)
+{
+	jMemoryAllocator allocator;
+	InitializeTestAllocator(allocator);
+
+	jMemoryAllocation a, b;
+	JTEST_CHECK(allocator.Allocate(MakeRequirements(100, 64), TestDeviceLocalType, true, false, a));
+	JTEST_CHECK(allocator.Allocate(MakeRequirements(100, 64), TestDeviceLocalType, true, false, b));
+
+	// 두 할당이 Block 하나를 나눠 씀
+	JTEST_CHECK(FakeDevice.AllocateCount == 1);
+	JTEST_CHECK(GetFakeMemory(a)->Size == TestBlockSize);
+	JTEST_CHECK(a.Memory == b.Memory);
+	JTEST_CHECK(a.Block && (a.Block == b.Block));
+	JTEST_CHECK(a.Offset == 0 && b.Offset == 128);
+	JTEST_CHECK(a.MappedData == nullptr);
+
+	// Linear 와 Optimal 리소스는 다른 Block 을 씀
+	jMemoryAllocation image;
+	JTEST_CHECK(allocator.Allocate(MakeRequirements(100, 64), TestDeviceLocalType, false, false, image));
+	JTEST_CHECK(FakeDevice.AllocateCount == 2);
+	JTEST_CHECK(image.Memory != a.Memory);
+
+	const jMemoryHeapStats stats = allocator.GetHeapStats(0);
+	JTEST_CHECK(stats.BlockCount == 2);
+	JTEST_CHECK(stats.AllocationCount == 3);
+	JTEST_CHECK(stats.BlockBytes == TestBlockSize * 2);
+	JTEST_CHECK(stats.UsedBytes == 228 + 100);
+	JTEST_CHECK(stats.DedicatedAllocationCount == 0);
+
+	allocator.Free(a);
+	allocator.Free(b);
+	allocator.Free(image);
+	JTEST_CHECK(!a.IsValid() && !b.IsValid() && !image.IsValid());
+
+	// 리스트마다 빈 Block 하나는 다음 할당을 위해 남겨둠
+	JTEST_CHECK(FakeDevice.FreeCount == 0);
+	JTEST_CHECK(allocator.GetHeapStats(0).AllocationCount == 0);
+
+	allocator.Release();
+	JTEST_CHECK(FakeDevice.GetLiveCount() == 0);
+}
+
+JTEST(MemoryAllocator_ReleaseExtraEmptyBlocks)
+{
+	jMemoryAllocator allocator;
+	InitializeTestAllocator(allocator);
+
+	// Block 의 절반 크기는 Block 에 들어가므로 두개를 넘게 할당하면 두번째 Block 이 생김
+	jMemoryAllocation allocations[3];
+	for (jMemoryAllocation& allocation : allocations)
+		JTEST_CHECK(allocator.Allocate(MakeRequirements(TestBlockSize / 2, 1), TestDeviceLocalType, true, false, allocation));
+	JTEST_CHECK(FakeDevice.AllocateCount == 2);
+	JTEST_CHECK(allocations[2].Memory != allocations[0].Memory);
+
+	for (jMemoryAllocation& allocation : allocations)
+		allocator.Free(allocation);
+
+	// 빈 Block 이 두개가 되면 하나는 바로 해제됨
+	JTEST_CHECK(FakeDevice.FreeCount == 1);
+	JTEST_CHECK(allocator.GetHeapStats(0).BlockCount == 1);
+
+	allocator.Release();
+	JTEST_CHECK(FakeDevice.GetLiveCount() == 0);
+}
+
+JTEST(MemoryAllocator_DedicatedAllocation)
+{
+	jMemoryAllocator allocator;
+	InitializeTestAllocator(allocator);
+
+	// Block 의 절반보다 크면 Dedicated
+	jMemoryAllocation large;
+	JTEST_CHECK(allocator.Allocate(MakeRequirements(TestBlockSize / 2 + 1, 1), TestDeviceLocalType, true, false, large));
+	JTEST_CHECK(large.Block == nullptr);
+	JTEST_CHECK(large.Offset == 0);
+	JTEST_CHECK(GetFakeMemory(large)->Size == TestBlockSize / 2 + 1);
+
+	// 요청한 경우에는 작아도 Dedicated
+	jMemoryAllocation requested;
+	JTEST_CHECK(allocator.Allocate(MakeRequirements(16, 1), TestDeviceLocalType, false, true, requested));
+	JTEST_CHECK(requested.Block == nullptr);
+	JTEST_CHECK(FakeDevice.AllocateCount == 2);
+
+	jMemoryHeapStats stats = allocator.GetHeapStats(0);
+	JTEST_CHECK(stats.BlockCount == 0);
+	JTEST_CHECK(stats.DedicatedAllocationCount == 2);
+	JTEST_CHECK(stats.DedicatedBytes == TestBlockSize / 2 + 1 + 16);
+
+	// Dedicated 는 반환하면 바로 해제됨
+	allocator.Free(large);
+	JTEST_CHECK(FakeDevice.FreeCount == 1);
+	stats = allocator.GetHeapStats(0);
+	JTEST_CHECK(stats.DedicatedAllocationCount == 1);
+	JTEST_CHECK(stats.DedicatedBytes == 16);
+
+	allocator.Free(requested);
+	allocator.Release();
+	JTEST_CHECK(FakeDevice.GetLiveCount() == 0);
+}
+
+JTEST(MemoryAllocator_BlockAllocationFailureFallsBackToDedicated)
+{
+	jMemoryAllocator allocator;
+	InitializeTestAllocator(allocator);
+
+	// Block 크기 만큼은 할당이 안되지만 요청한 크기는 할당 가능한 경우
+	FakeDevice.MaxAllocationSize = 256;
+
+	jMemoryAllocation allocation;
+	JTEST_CHECK(allocator.Allocate(MakeRequirements(200, 1), TestDeviceLocalType, true, false, allocation));
+	JTEST_CHECK(allocation.Block == nullptr);
+	JTEST_CHECK(GetFakeMemory(allocation)->Size == 200);
+
+	const jMemoryHeapStats stats = allocator.GetHeapStats(0);
+	JTEST_CHECK(stats.BlockCount == 0);
+	JTEST_CHECK(stats.DedicatedAllocationCount == 1);
+
+	allocator.Free(allocation);
+	allocator.Release();
+	JTEST_CHECK(FakeDevice.GetLiveCount() == 0);
+}
+
+JTEST(MemoryAllocator_HostVisibleIsMappedOnce)
+{
+	jMemoryAllocator allocator;
+	InitializeTestAllocator(allocator);
+
+	jMemoryAllocation a, b;
+	JTEST_CHECK(allocator.Allocate(MakeRequirements(64, 16), TestHostVisibleType, true, false, a));
+	JTEST_CHECK(allocator.Allocate(MakeRequirements(64, 16), TestHostVisibleType, true, false, b));
+	JTEST_CHECK(FakeDevice.MapCount == 1);
+
+	// MappedData 는 Block 의 매핑에서 Offset 만큼 떨어진 위치
+	uint8_t* blockData = GetFakeMemory(a)->Data.data();
+	JTEST_CHECK(a.MappedData == blockData + a.Offset);
+	JTEST_CHECK(b.MappedData == blockData + b.Offset);
+
+	// Heap 별로 통계가 나뉨
+	JTEST_CHECK(allocator.GetHeapStats(0).BlockCount == 0);
+	const jMemoryHeapStats stats = allocator.GetHeapStats(1);
+	JTEST_CHECK(stats.BlockCount == 1);
+	JTEST_CHECK(stats.AllocationCount == 2);
+	JTEST_CHECK(stats.UsedBytes == 128);
+
+	allocator.Free(a);
+	allocator.Free(b);
+	allocator.Release();
+	JTEST_CHECK(FakeDevice.GetLiveCount() == 0);
+}
+
+JTEST(MemoryAllocator_FallBackToNextMemoryType)
+{
+	jMemoryAllocator allocator;
+	InitializeTestAllocator(allocator);
+
+	// DEVICE_LOCAL Heap 이 가득차면 다음 후보인 HOST_VISIBLE 타입(다른 Heap) 에서 할당함
+	FakeDevice.FullMemoryTypeBits = (1 << TestDeviceLocalType);
+	jMemoryAllocation fallback;
+	JTEST_CHECK(allocator.Allocate(MakeRequirements(64, 1), 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true, false, fallback));
+	JTEST_CHECK(fallback.MemoryTypeIndex == TestHostVisibleType);
+	JTEST_CHECK(fallback.MappedData != nullptr);
+	JTEST_CHECK(allocator.GetHeapStats(1).AllocationCount == 1);
+
+	// Block 과 Dedicated 모두 실패한 뒤에 다음 타입으로 넘어가야 함
+	JTEST_CHECK(allocator.GetHeapStats(0).DedicatedAllocationCount == 0);
+
+	// required 를 만족하는 타입이 모두 가득차면 실패
+	jMemoryAllocation failed;
+	JTEST_CHECK(!allocator.Allocate(MakeRequirements(64, 1), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, true, false, failed));
+	JTEST_CHECK(!failed.IsValid());
+
+	allocator.Free(fallback);
+	allocator.Release();
+	JTEST_CHECK(FakeDevice.GetLiveCount() == 0);
+}
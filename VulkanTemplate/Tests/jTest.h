@@ -0,0 +1,34 @@
+﻿#pragma once
+
+#include <vector>
+#include <cstdio>
+
+// 디바이스 없이 돌릴 수 있는 로직을 확인하는 최소한의 콘솔 테스트 러너.
+// JTEST 로 등록한 함수들을 main 이 등록 순서대로 실행하고, 실패한 JTEST_CHECK 를 출력함.
+struct jTestCase
+{
+	const char* Name = nullptr;
+	void(*Func)() = nullptr;
+};
+
+std::vector<jTestCase>& GetTestCases();
+void ReportTestFailure(const char* expression, const char* file, int line);
+
+struct jTestRegistrar
+{
+	jTestRegistrar(const char* name, void(*func)())
+	{
+		jTestCase testCase;
+		testCase.Name = name;
+		testCase.Func = func;
+		GetTestCases().push_back(testCase);
+	}
+};
+
+#define JTEST(Name) \
+	static void Name(); \
+	static jTestRegistrar Name##Registrar(#Name, Name); \
+	static void Name()
+
+#define JTEST_CHECK(expression) \
+	do { if (!(expression)) ReportTestFailure(#expression, __FILE__, __LINE__); } while (0)
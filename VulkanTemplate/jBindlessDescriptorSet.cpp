@@ -0,0 +1,105 @@
+﻿#include <pch.h>
+#include "jBindlessDescriptorSet.h"
+
+#include <array>
+#include "jAssert.h"
+#include "jDescriptorSetLayoutCache.h"
+
+bool jBindlessDescriptorSet::Initialize(VkDevice device, jDescriptorSetLayoutCache& layoutCache, uint32_t maxTextures)
+{
+	Device = device;
+	MaxTextures = maxTextures;
+	TextureCount = 0;
+
+	// PARTIALLY_BOUND : 쉐이더가 접근하지 않는 슬롯은 비어있어도 됨
+	// UPDATE_AFTER_BIND : 커맨드 버퍼에 바인딩 된 이후에도 (사용되지 않는 슬롯을) 업데이트 할 수 있음
+	jDescriptorSetLayoutDesc layoutDesc;
+	layoutDesc.Flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	layoutDesc.AddBinding(ObjectBufferBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT);
+	layoutDesc.AddBinding(TextureArrayBinding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxTextures, VK_SHADER_STAGE_FRAGMENT_BIT
+		, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT);
+
+	Layout = layoutCache.GetLayout(layoutDesc);
+	if (!ensure(Layout != VK_NULL_HANDLE))
+		return false;
+
+	std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[0].descriptorCount = 1;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[1].descriptorCount = maxTextures;
+
+	// Update after bind 레이아웃의 Descriptor set 은 같은 플래그로 만든 Pool 에서만 할당 가능
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = 1;
+	if (!ensure(vkCreateDescriptorPool(Device, &poolInfo, nullptr, &Pool) == VK_SUCCESS))
+		return false;
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = Pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &Layout;
+	if (!ensure(vkAllocateDescriptorSets(Device, &allocInfo, &DescriptorSet) == VK_SUCCESS))
+		return false;
+
+	return true;
+}
+
+void jBindlessDescriptorSet::Release()
+{
+	if (Pool)
+		vkDestroyDescriptorPool(Device, Pool, nullptr);
+
+	Pool = VK_NULL_HANDLE;
+	Layout = VK_NULL_HANDLE;
+	DescriptorSet = VK_NULL_HANDLE;
+	TextureCount = 0;
+}
+
+void jBindlessDescriptorSet::SetObjectBuffer(VkBuffer buffer, VkDeviceSize range)
+{
+	VkDescriptorBufferInfo bufferInfo = {};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = 0;
+	bufferInfo.range = range;
+
+	VkWriteDescriptorSet descriptorWrite = {};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = DescriptorSet;
+	descriptorWrite.dstBinding = ObjectBufferBinding;
+	descriptorWrite.dstArrayElement = 0;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(Device, 1, &descriptorWrite, 0, nullptr);
+}
+
+uint32_t jBindlessDescriptorSet::AddTexture(VkImageView imageView, VkSampler sampler)
+{
+	if (!ensure(TextureCount < MaxTextures))
+		return InvalidIndex;
+
+	const uint32_t index = TextureCount++;
+
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = imageView;
+	imageInfo.sampler = sampler;
+
+	VkWriteDescriptorSet descriptorWrite = {};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = DescriptorSet;
+	descriptorWrite.dstBinding = TextureArrayBinding;
+	descriptorWrite.dstArrayElement = index;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(Device, 1, &descriptorWrite, 0, nullptr);
+
+	return index;
+}
@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <cstddef>
+
+class jDescriptorSetLayoutCache;
+
+// Descriptor indexing (Vulkan 1.2) 을 사용하는 Bindless Descriptor set.
+// 모든 텍스쳐를 하나의 큰 배열에 넣어두고 쉐이더에서 인덱스로 접근하므로, 머터리얼이 바뀌어도 vkCmdBindDescriptorSets 를 하지 않아도 됨.
+//
+// 바인딩 구성 (쉐이더의 set 번호는 파이프라인 레이아웃에서 정해짐)
+// - ObjectBufferBinding : 오브젝트 데이터 Storage buffer. 쉐이더에서 gl_InstanceIndex 로 접근함.
+// - TextureArrayBinding : sampler2D 배열. UPDATE_AFTER_BIND | PARTIALLY_BOUND 라서 사용중에도 빈 슬롯에 텍스쳐를 추가할 수 있음.
+//
+// Update after bind 레이아웃에는 Dynamic uniform buffer 를 넣을 수 없으므로 씬 Uniform 은 다른 set 에 둬야 함.
+class jBindlessDescriptorSet
+{
+public:
+	// 레이아웃은 layoutCache 가 소유함
+	bool Initialize(VkDevice device, jDescriptorSetLayoutCache& layoutCache, uint32_t maxTextures);
+	void Release();
+
+	void SetObjectBuffer(VkBuffer buffer, VkDeviceSize range);
+
+	// 텍스쳐를 배열의 다음 슬롯에 넣고 인덱스를 돌려줌. 가득찬 경우 InvalidIndex.
+	uint32_t AddTexture(VkImageView imageView, VkSampler sampler);
+
+	VkDescriptorSetLayout GetLayout() const { return Layout; }
+	VkDescriptorSet GetDescriptorSet() const { return DescriptorSet; }
+	uint32_t GetTextureCount() const { return TextureCount; }
+	uint32_t GetMaxTextures() const { return MaxTextures; }
+
+	static constexpr uint32_t ObjectBufferBinding = 0;
+	static constexpr uint32_t TextureArrayBinding = 1;
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+private:
+	VkDevice Device = VK_NULL_HANDLE;
+	VkDescriptorSetLayout Layout = VK_NULL_HANDLE;		// jDescriptorSetLayoutCache 가 소유
+	VkDescriptorPool Pool = VK_NULL_HANDLE;
+	VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;		// Pool 이 소멸될때 같이 소멸됨
+	uint32_t MaxTextures = 0;
+	uint32_t TextureCount = 0;
+};
@@ -0,0 +1,103 @@
+﻿#include <pch.h>
+#include "jDeletionQueue.h"
+
+#include "jAssert.h"
+#include "jMemoryAllocator.h"
+
+void jDeletionQueue::Initialize(VkDevice device, jMemoryAllocator& memoryAllocator)
+{
+	JASSERT(Entries.empty());
+
+	Device = device;
+	MemoryAllocator = &memoryAllocator;
+	DeletedCount = 0;
+}
+
+void jDeletionQueue::Release()
+{
+	Flush(UINT64_MAX);
+}
+
+void jDeletionQueue::Push(uint64_t value, std::function<void()>&& deleter)
+{
+	JASSERT(deleter);
+
+	jEntry entry;
+	entry.Value = value;
+	entry.Deleter = std::move(deleter);
+	Entries.push_back(std::move(entry));
+}
+
+void jDeletionQueue::PushBuffer(uint64_t value, VkBuffer buffer, const jMemoryAllocation& memory)
+{
+	// 할당 정보는 복사해서 들고 있으므로 호출한 쪽의 jMemoryAllocation 은 바로 재사용해도 됨
+	jMemoryAllocation allocation = memory;
+	Push(value, [this, buffer, allocation]() mutable
+	{
+		vkDestroyBuffer(Device, buffer, nullptr);
+		MemoryAllocator->Free(allocation);
+	});
+}
+
+void jDeletionQueue::PushImage(uint64_t value, VkImage image, const jMemoryAllocation& memory)
+{
+	jMemoryAllocation allocation = memory;
+	Push(value, [this, image, allocation]() mutable
+	{
+		vkDestroyImage(Device, image, nullptr);
+		MemoryAllocator->Free(allocation);
+	});
+}
+
+void jDeletionQueue::PushImageView(uint64_t value, VkImageView imageView)
+{
+	Push(value, [this, imageView]() { vkDestroyImageView(Device, imageView, nullptr); });
+}
+
+void jDeletionQueue::PushFramebuffer(uint64_t value, VkFramebuffer framebuffer)
+{
+	Push(value, [this, framebuffer]() { vkDestroyFramebuffer(Device, framebuffer, nullptr); });
+}
+
+void jDeletionQueue::PushRenderPass(uint64_t value, VkRenderPass renderPass)
+{
+	Push(value, [this, renderPass]() { vkDestroyRenderPass(Device, renderPass, nullptr); });
+}
+
+void jDeletionQueue::PushPipeline(uint64_t value, VkPipeline pipeline)
+{
+	Push(value, [this, pipeline]() { vkDestroyPipeline(Device, pipeline, nullptr); });
+}
+
+void jDeletionQueue::PushPipelineLayout(uint64_t value, VkPipelineLayout pipelineLayout)
+{
+	Push(value, [this, pipelineLayout]() { vkDestroyPipelineLayout(Device, pipelineLayout, nullptr); });
+}
+
+void jDeletionQueue::PushShaderModule(uint64_t value, VkShaderModule shaderModule)
+{
+	Push(value, [this, shaderModule]() { vkDestroyShaderModule(Device, shaderModule, nullptr); });
+}
+
+uint32_t jDeletionQueue::Flush(uint64_t completedValue)
+{
+	uint32_t deletedCount = 0;
+	size_t keepCount = 0;
+	for (size_t i = 0; i < Entries.size(); ++i)
+	{
+		if (Entries[i].Value <= completedValue)
+		{
+			Entries[i].Deleter();
+			++deletedCount;
+			continue;
+		}
+
+		if (keepCount != i)
+			Entries[keepCount] = std::move(Entries[i]);
+		++keepCount;
+	}
+	Entries.resize(keepCount);
+
+	DeletedCount += deletedCount;
+	return deletedCount;
+}
@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+class jMemoryAllocator;
+struct jMemoryAllocation;
+
+// GPU 가 아직 사용중일 수 있는 리소스를 바로 지우지 않고, 마지막으로 사용한 제출의 Timeline 값과 함께 보관했다가
+// 그 값이 완료된 뒤에 지우는 큐. vkDeviceWaitIdle 없이 프레임 도중에 리소스를 교체(ex. 핫 리로드, 스트리밍) 할 수 있음.
+//
+// - value 는 리소스를 마지막으로 사용한 제출의 값. 이미 제출한 커맨드에서만 쓰였다면 GetLastSubmittedValue(),
+//   지금 기록중인 커맨드에서도 쓰인다면 그 커맨드가 제출되고 난 뒤의 값을 넘겨야 함.
+// - 값은 한 Timeline(jQueueTimeline) 기준이어야 함. 다른 Queue 에서도 쓰였다면 그 Queue 를 기다리는 제출의 값을 넘김.
+// - Vulkan 핸들은 32비트 빌드에서 모두 uint64_t 라서 오버로딩하지 않고 타입별로 이름을 나눔.
+class jDeletionQueue
+{
+public:
+	void Initialize(VkDevice device, jMemoryAllocator& memoryAllocator);
+
+	// 남은 것을 모두 즉시 지움. GPU 작업이 모두 끝난 뒤에 호출해야 함.
+	void Release();
+
+	void Push(uint64_t value, std::function<void()>&& deleter);
+	void PushBuffer(uint64_t value, VkBuffer buffer, const jMemoryAllocation& memory);
+	void PushImage(uint64_t value, VkImage image, const jMemoryAllocation& memory);
+	void PushImageView(uint64_t value, VkImageView imageView);
+	void PushFramebuffer(uint64_t value, VkFramebuffer framebuffer);
+	void PushRenderPass(uint64_t value, VkRenderPass renderPass);
+	void PushPipeline(uint64_t value, VkPipeline pipeline);
+	void PushPipelineLayout(uint64_t value, VkPipelineLayout pipelineLayout);
+	void PushShaderModule(uint64_t value, VkShaderModule shaderModule);
+
+	// completedValue 이하의 값으로 등록된 것들을 등록한 순서대로 지움. 지운 개수를 돌려줌.
+	uint32_t Flush(uint64_t completedValue);
+
+	size_t GetPendingCount() const { return Entries.size(); }
+	uint64_t GetDeletedCount() const { return DeletedCount; }
+
+private:
+	struct jEntry
+	{
+		uint64_t Value = 0;
+		std::function<void()> Deleter;
+	};
+
+	VkDevice Device = VK_NULL_HANDLE;
+	jMemoryAllocator* MemoryAllocator = nullptr;
+
+	// 보통은 값이 증가하는 순서로 들어오지만, 다른 Queue 기준으로 늦게 등록되는 경우도 있어서 전체를 확인함
+	std::vector<jEntry> Entries;
+	uint64_t DeletedCount = 0;
+};
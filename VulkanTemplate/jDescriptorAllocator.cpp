@@ -0,0 +1,129 @@
+﻿#include <pch.h>
+#include "jDescriptorAllocator.h"
+
+#include <algorithm>
+#include "jAssert.h"
+
+const std::vector<jDescriptorPoolRatio>& jDescriptorAllocator::GetDefaultRatios()
+{
+	// 현재 쓰는 레이아웃 기준 (Dynamic uniform 1개 + 텍스쳐 1개) 에 여유를 둔 값
+	static const std::vector<jDescriptorPoolRatio> DefaultRatios =
+	{
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.0f },
+	};
+	return DefaultRatios;
+}
+
+void jDescriptorAllocator::Initialize(VkDevice device, uint32_t initialSetsPerPool, const std::vector<jDescriptorPoolRatio>& ratios)
+{
+	Device = device;
+	Ratios = ratios;
+	NextSetsPerPool = std::min(std::max(initialSetsPerPool, 1u), MaxSetsPerPool);
+}
+
+void jDescriptorAllocator::Release()
+{
+	if (CurrentPool.Pool)
+		vkDestroyDescriptorPool(Device, CurrentPool.Pool, nullptr);
+	for (jPool& pool : UsedPools)
+		vkDestroyDescriptorPool(Device, pool.Pool, nullptr);
+	for (jPool& pool : FreePools)
+		vkDestroyDescriptorPool(Device, pool.Pool, nullptr);
+
+	CurrentPool = jPool();
+	UsedPools.clear();
+	FreePools.clear();
+	AllocatedSetCount = 0;
+}
+
+bool jDescriptorAllocator::Allocate(VkDescriptorSetLayout layout, VkDescriptorSet& outDescriptorSet)
+{
+	if (!CurrentPool.Pool && !GrabPool())
+		return false;
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = CurrentPool.Pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	VkResult result = vkAllocateDescriptorSets(Device, &allocInfo, &outDescriptorSet);
+	if ((result == VK_ERROR_OUT_OF_POOL_MEMORY) || (result == VK_ERROR_FRAGMENTED_POOL))
+	{
+		// 현재 Pool 이 가득 찼으므로 다음 Pool 로 넘어가서 한번만 더 시도함
+		UsedPools.push_back(CurrentPool);
+		CurrentPool = jPool();
+		if (!GrabPool())
+			return false;
+
+		allocInfo.descriptorPool = CurrentPool.Pool;
+		result = vkAllocateDescriptorSets(Device, &allocInfo, &outDescriptorSet);
+	}
+
+	if (!ensure(result == VK_SUCCESS))
+		return false;
+
+	++AllocatedSetCount;
+	return true;
+}
+
+void jDescriptorAllocator::Reset()
+{
+	// vkResetDescriptorPool 은 Pool 에서 할당한 Set 을 모두 한번에 반환함. (Set 을 개별로 Free 하는 것보다 훨씬 빠름)
+	if (CurrentPool.Pool)
+		UsedPools.push_back(CurrentPool);
+	CurrentPool = jPool();
+
+	for (jPool& pool : UsedPools)
+	{
+		vkResetDescriptorPool(Device, pool.Pool, 0);
+		FreePools.push_back(pool);
+	}
+	UsedPools.clear();
+	AllocatedSetCount = 0;
+}
+
+bool jDescriptorAllocator::GrabPool()
+{
+	if (!FreePools.empty())
+	{
+		CurrentPool = FreePools.back();
+		FreePools.pop_back();
+		return true;
+	}
+
+	if (!CreatePool(NextSetsPerPool, CurrentPool))
+		return false;
+
+	NextSetsPerPool = std::min(NextSetsPerPool * 2, MaxSetsPerPool);
+	return true;
+}
+
+bool jDescriptorAllocator::CreatePool(uint32_t maxSets, jPool& outPool) const
+{
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	poolSizes.reserve(Ratios.size());
+	for (const jDescriptorPoolRatio& ratio : Ratios)
+	{
+		VkDescriptorPoolSize poolSize = {};
+		poolSize.type = ratio.Type;
+		poolSize.descriptorCount = std::max(static_cast<uint32_t>(ratio.Ratio * maxSets), 1u);
+		poolSizes.push_back(poolSize);
+	}
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = 0;		// Set 을 개별로 Free 하지 않고 Pool 단위로 Reset 하므로 FREE_DESCRIPTOR_SET_BIT 은 필요없음
+	poolInfo.maxSets = maxSets;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	if (!ensure(vkCreateDescriptorPool(Device, &poolInfo, nullptr, &outPool.Pool) == VK_SUCCESS))
+		return false;
+
+	outPool.MaxSets = maxSets;
+	return true;
+}
@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Pool 하나를 만들때 Set 하나당 타입별로 몇개의 Descriptor 를 잡아둘지 비율
+struct jDescriptorPoolRatio
+{
+	VkDescriptorType Type;
+	float Ratio;
+};
+
+// 여러개의 VkDescriptorPool 을 들고 있으면서 Descriptor set 을 나눠주는 할당자.
+// - 사용할 Set 의 개수를 미리 알 필요 없음. Pool 이 가득차면 (VK_ERROR_OUT_OF_POOL_MEMORY) 더 큰 Pool 을 만들어서 이어서 할당함.
+// - Set 을 하나씩 반환하지 않고 Reset 으로 모든 Pool 을 한번에 비움. 비워진 Pool 은 버리지 않고 다음 할당에 재사용함.
+// - 프레임마다 쓰는 Set 은 프레임(Frame in flight) 별로 할당자를 두고, 해당 프레임의 펜스를 기다린 뒤 Reset 하면 됨.
+class jDescriptorAllocator
+{
+public:
+	// initialSetsPerPool : 첫번째 Pool 의 maxSets. 이후에 만드는 Pool 은 MaxSetsPerPool 까지 2배씩 커짐.
+	void Initialize(VkDevice device, uint32_t initialSetsPerPool = DefaultSetsPerPool, const std::vector<jDescriptorPoolRatio>& ratios = GetDefaultRatios());
+	void Release();
+
+	bool Allocate(VkDescriptorSetLayout layout, VkDescriptorSet& outDescriptorSet);
+
+	// 할당한 모든 Set 이 무효화됨. Set 을 사용하는 커맨드 버퍼의 실행이 끝난 뒤에 호출해야 함.
+	void Reset();
+
+	size_t GetPoolCount() const { return UsedPools.size() + FreePools.size(); }
+	uint32_t GetAllocatedSetCount() const { return AllocatedSetCount; }
+
+	static const std::vector<jDescriptorPoolRatio>& GetDefaultRatios();
+
+	static constexpr uint32_t DefaultSetsPerPool = 64;
+	static constexpr uint32_t MaxSetsPerPool = 4096;
+
+private:
+	struct jPool
+	{
+		VkDescriptorPool Pool = VK_NULL_HANDLE;
+		uint32_t MaxSets = 0;
+	};
+
+	bool GrabPool();
+	bool CreatePool(uint32_t maxSets, jPool& outPool) const;
+
+	VkDevice Device = VK_NULL_HANDLE;
+	std::vector<jDescriptorPoolRatio> Ratios;
+	uint32_t NextSetsPerPool = DefaultSetsPerPool;
+
+	jPool CurrentPool;
+	std::vector<jPool> UsedPools;		// 가득 찬 Pool 들
+	std::vector<jPool> FreePools;		// Reset 되어 재사용할 수 있는 Pool 들
+	uint32_t AllocatedSetCount = 0;
+};
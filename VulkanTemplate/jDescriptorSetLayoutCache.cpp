@@ -0,0 +1,107 @@
+﻿#include <pch.h>
+#include "jDescriptorSetLayoutCache.h"
+
+#include <algorithm>
+#include "jAssert.h"
+#include "Generic/TemplateUtility.h"
+
+void jDescriptorSetLayoutDesc::AddBinding(uint32_t binding, VkDescriptorType type, uint32_t count, VkShaderStageFlags stageFlags, VkDescriptorBindingFlags bindingFlags)
+{
+	VkDescriptorSetLayoutBinding layoutBinding = {};
+	layoutBinding.binding = binding;
+	layoutBinding.descriptorType = type;
+	layoutBinding.descriptorCount = count;
+	layoutBinding.stageFlags = stageFlags;
+	layoutBinding.pImmutableSamplers = nullptr;
+
+	// 바인딩 번호 순서를 유지해서 추가 순서가 달라도 같은 Desc 가 되도록 함
+	const auto it = std::upper_bound(Bindings.begin(), Bindings.end(), binding
+		, [](uint32_t value, const VkDescriptorSetLayoutBinding& element) { return value < element.binding; });
+	const size_t index = static_cast<size_t>(it - Bindings.begin());
+	Bindings.insert(it, layoutBinding);
+
+	if (bindingFlags || !BindingFlags.empty())
+	{
+		BindingFlags.resize(Bindings.size() - 1, 0);
+		BindingFlags.insert(BindingFlags.begin() + index, bindingFlags);
+	}
+}
+
+bool jDescriptorSetLayoutDesc::operator == (const jDescriptorSetLayoutDesc& other) const
+{
+	if ((Flags != other.Flags) || (Bindings.size() != other.Bindings.size()) || (BindingFlags != other.BindingFlags))
+		return false;
+
+	for (size_t i = 0; i < Bindings.size(); ++i)
+	{
+		const VkDescriptorSetLayoutBinding& a = Bindings[i];
+		const VkDescriptorSetLayoutBinding& b = other.Bindings[i];
+		if ((a.binding != b.binding) || (a.descriptorType != b.descriptorType) || (a.descriptorCount != b.descriptorCount) || (a.stageFlags != b.stageFlags))
+			return false;
+	}
+	return true;
+}
+
+size_t jDescriptorSetLayoutDesc::GetHash() const
+{
+	size_t hash = 0;
+	HashCombine(hash, Flags);
+	for (const VkDescriptorSetLayoutBinding& binding : Bindings)
+	{
+		HashCombine(hash, binding.binding);
+		HashCombine(hash, static_cast<int32_t>(binding.descriptorType));
+		HashCombine(hash, binding.descriptorCount);
+		HashCombine(hash, binding.stageFlags);
+	}
+	for (VkDescriptorBindingFlags bindingFlags : BindingFlags)
+		HashCombine(hash, bindingFlags);
+	return hash;
+}
+
+void jDescriptorSetLayoutCache::Initialize(VkDevice device)
+{
+	Device = device;
+}
+
+void jDescriptorSetLayoutCache::Release()
+{
+	for (auto& it : Layouts)
+		vkDestroyDescriptorSetLayout(Device, it.second, nullptr);
+	Layouts.clear();
+}
+
+VkDescriptorSetLayout jDescriptorSetLayoutCache::GetLayout(const jDescriptorSetLayoutDesc& desc)
+{
+	auto it = Layouts.find(desc);
+	if (it != Layouts.end())
+	{
+		++HitCount;
+		return it->second;
+	}
+	++MissCount;
+
+	if (!ensure(desc.BindingFlags.empty() || (desc.BindingFlags.size() == desc.Bindings.size())))
+		return VK_NULL_HANDLE;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.flags = desc.Flags;
+	layoutInfo.bindingCount = static_cast<uint32_t>(desc.Bindings.size());
+	layoutInfo.pBindings = desc.Bindings.data();
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+	if (!desc.BindingFlags.empty())
+	{
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = static_cast<uint32_t>(desc.BindingFlags.size());
+		bindingFlagsInfo.pBindingFlags = desc.BindingFlags.data();
+		layoutInfo.pNext = &bindingFlagsInfo;
+	}
+
+	VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+	if (!ensure(vkCreateDescriptorSetLayout(Device, &layoutInfo, nullptr, &layout) == VK_SUCCESS))
+		return VK_NULL_HANDLE;
+
+	Layouts.insert(std::make_pair(desc, layout));
+	return layout;
+}
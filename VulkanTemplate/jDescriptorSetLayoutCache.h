@@ -0,0 +1,48 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// VkDescriptorSetLayout 을 만들때 사용하는 정보. 바인딩 번호 순서로 정렬해서 비교하므로 추가하는 순서는 상관없음.
+// pImmutableSamplers 는 지원하지 않음.
+struct jDescriptorSetLayoutDesc
+{
+	VkDescriptorSetLayoutCreateFlags Flags = 0;
+	std::vector<VkDescriptorSetLayoutBinding> Bindings;
+	std::vector<VkDescriptorBindingFlags> BindingFlags;		// 비어있거나 Bindings 와 같은 수여야 함 (Descriptor indexing 용)
+
+	void AddBinding(uint32_t binding, VkDescriptorType type, uint32_t count, VkShaderStageFlags stageFlags, VkDescriptorBindingFlags bindingFlags = 0);
+
+	bool operator == (const jDescriptorSetLayoutDesc& other) const;
+	size_t GetHash() const;
+};
+
+// 같은 구성의 Descriptor set layout 은 하나만 만들어서 파이프라인 끼리 공유함.
+// 레이아웃은 캐시가 소유하므로 사용하는 쪽에서 vkDestroyDescriptorSetLayout 을 호출하면 안됨.
+class jDescriptorSetLayoutCache
+{
+public:
+	void Initialize(VkDevice device);
+	void Release();
+
+	// 실패하면 VK_NULL_HANDLE
+	VkDescriptorSetLayout GetLayout(const jDescriptorSetLayoutDesc& desc);
+
+	uint64_t GetHitCount() const { return HitCount; }
+	uint64_t GetMissCount() const { return MissCount; }
+	size_t GetLayoutCount() const { return Layouts.size(); }
+
+private:
+	struct jDescriptorSetLayoutDescHasher
+	{
+		size_t operator()(const jDescriptorSetLayoutDesc& desc) const { return desc.GetHash(); }
+	};
+
+	VkDevice Device = VK_NULL_HANDLE;
+	std::unordered_map<jDescriptorSetLayoutDesc, VkDescriptorSetLayout, jDescriptorSetLayoutDescHasher> Layouts;
+	uint64_t HitCount = 0;
+	uint64_t MissCount = 0;
+};
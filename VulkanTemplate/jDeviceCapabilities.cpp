@@ -0,0 +1,207 @@
+﻿#include <pch.h>
+#include "jDeviceCapabilities.h"
+
+#include <algorithm>
+#include <cstring>
+#include "jAssert.h"
+
+void jDeviceCapabilities::Initialize(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface)
+{
+	PhysicalDevice = physicalDevice;
+
+	vkGetPhysicalDeviceProperties(physicalDevice, &Properties);
+	vkGetPhysicalDeviceFeatures(physicalDevice, &Features);
+
+	Vulkan12Features = {};
+	Vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	Vulkan12Properties = {};
+	Vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+	if (IsVulkan12Supported())
+	{
+		VkPhysicalDeviceFeatures2 features2 = {};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &Vulkan12Features;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+		VkPhysicalDeviceProperties2 properties2 = {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &Vulkan12Properties;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+	}
+	Vulkan12Features.pNext = nullptr;
+	Vulkan12Properties.pNext = nullptr;
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	InitializeMemoryProperties(memoryProperties);
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+	QueueFamilies.resize(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, QueueFamilies.data());
+
+	PresentSupport.resize(queueFamilyCount);
+	for (uint32_t i = 0; i < queueFamilyCount; ++i)
+	{
+		VkBool32 presentSupport = false;
+		vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
+		PresentSupport[i] = !!presentSupport;
+	}
+
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+	Extensions.resize(extensionCount);
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, Extensions.data());
+
+	// VK_FORMAT_UNDEFINED(0) ~ VK_FORMAT_ASTC_12x12_SRGB_BLOCK(184) 까지가 코어 포맷
+	CoreFormatProperties.resize(VK_FORMAT_ASTC_12x12_SRGB_BLOCK + 1);
+	for (int32_t i = 0; i < static_cast<int32_t>(CoreFormatProperties.size()); ++i)
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, static_cast<VkFormat>(i), &CoreFormatProperties[i]);
+	ExtensionFormatProperties.clear();
+}
+
+void jDeviceCapabilities::InitializeMemoryProperties(const VkPhysicalDeviceMemoryProperties& memoryProperties)
+{
+	MemoryProperties = memoryProperties;
+	MemoryTypeCandidates.clear();
+}
+
+bool jDeviceCapabilities::IsExtensionSupported(const char* extensionName) const
+{
+	for (const VkExtensionProperties& extension : Extensions)
+	{
+		if (strcmp(extension.extensionName, extensionName) == 0)
+			return true;
+	}
+	return false;
+}
+
+const VkFormatProperties& jDeviceCapabilities::GetFormatProperties(VkFormat format) const
+{
+	const int32_t formatIndex = static_cast<int32_t>(format);
+	if (formatIndex >= 0 && formatIndex < static_cast<int32_t>(CoreFormatProperties.size()))
+		return CoreFormatProperties[formatIndex];
+
+	auto it = ExtensionFormatProperties.find(formatIndex);
+	if (it != ExtensionFormatProperties.end())
+		return it->second;
+
+	VkFormatProperties props = {};
+	vkGetPhysicalDeviceFormatProperties(PhysicalDevice, format, &props);
+	return ExtensionFormatProperties.insert(std::make_pair(formatIndex, props)).first->second;
+}
+
+bool jDeviceCapabilities::IsFormatSupported(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features) const
+{
+	// props.linearTilingFeatures : Linear tiling 지원여부
+	// props.optimalTilingFeatures : Optimal tiling 지원여부
+	// props.bufferFeatures : 버퍼를 지원하는 경우
+	const VkFormatProperties& props = GetFormatProperties(format);
+	if (tiling == VK_IMAGE_TILING_LINEAR)
+		return (props.linearTilingFeatures & features) == features;
+	if (tiling == VK_IMAGE_TILING_OPTIMAL)
+		return (props.optimalTilingFeatures & features) == features;
+	return false;
+}
+
+bool jDeviceCapabilities::IsBindlessSupported(uint32_t maxTextures) const
+{
+	if (!IsVulkan12Supported())
+		return false;
+
+	return Vulkan12Features.runtimeDescriptorArray
+		&& Vulkan12Features.descriptorBindingPartiallyBound
+		&& Vulkan12Features.descriptorBindingSampledImageUpdateAfterBind
+		&& Vulkan12Features.shaderSampledImageArrayNonUniformIndexing
+		&& (Vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages >= maxTextures)
+		&& (Vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages >= maxTextures);
+}
+
+VkSampleCountFlagBits jDeviceCapabilities::GetMaxUsableSampleCount() const
+{
+	VkSampleCountFlags counts = Properties.limits.framebufferColorSampleCounts & Properties.limits.framebufferDepthSampleCounts;
+	if (counts & VK_SAMPLE_COUNT_64_BIT) { return VK_SAMPLE_COUNT_64_BIT; }
+	if (counts & VK_SAMPLE_COUNT_32_BIT) { return VK_SAMPLE_COUNT_32_BIT; }
+	if (counts & VK_SAMPLE_COUNT_16_BIT) { return VK_SAMPLE_COUNT_16_BIT; }
+	if (counts & VK_SAMPLE_COUNT_8_BIT) { return VK_SAMPLE_COUNT_8_BIT; }
+	if (counts & VK_SAMPLE_COUNT_4_BIT) { return VK_SAMPLE_COUNT_4_BIT; }
+	if (counts & VK_SAMPLE_COUNT_2_BIT) { return VK_SAMPLE_COUNT_2_BIT; }
+
+	return VK_SAMPLE_COUNT_1_BIT;
+}
+
+bool jDeviceCapabilities::FindMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags properties, uint32_t& outMemoryTypeIndex) const
+{
+	// 요청하지 않은 플래그가 적은 타입이 먼저 오므로 그냥 첫번째 타입을 쓰면 됨
+	const std::vector<uint32_t>& candidates = GetMemoryTypeCandidates(memoryTypeBits, properties, 0);
+	if (candidates.empty())
+		return false;
+
+	outMemoryTypeIndex = candidates[0];
+	return true;
+}
+
+const std::vector<uint32_t>& jDeviceCapabilities::GetMemoryTypeCandidates(uint32_t memoryTypeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const
+{
+	// VkMemoryPropertyFlagBits 는 하위 16비트 안에 모두 있음
+	JASSERT(!(required & 0xffff0000) && !(preferred & 0xffff0000));
+	const uint64_t key = (static_cast<uint64_t>(memoryTypeBits) << 32) | (static_cast<uint64_t>(required & 0xffff) << 16) | (preferred & 0xffff);
+
+	auto it = MemoryTypeCandidates.find(key);
+	if (it != MemoryTypeCandidates.end())
+		return it->second;
+
+	std::vector<uint32_t> candidates;
+	FindMemoryTypeCandidates(MemoryProperties, memoryTypeBits, required, preferred, candidates);
+	return MemoryTypeCandidates.insert(std::make_pair(key, std::move(candidates))).first->second;
+}
+
+bool jDeviceCapabilities::FindMemoryTypeCandidates(const VkPhysicalDeviceMemoryProperties& memoryProperties, uint32_t memoryTypeBits
+	, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, std::vector<uint32_t>& outCandidates)
+{
+	auto CountBits = [](uint32_t bits)
+	{
+		uint32_t count = 0;
+		for (; bits; bits &= (bits - 1))
+			++count;
+		return count;
+	};
+
+	struct jCandidate
+	{
+		uint32_t MemoryTypeIndex;
+		uint32_t PreferredCount;	// 많을 수록 좋음
+		uint32_t ExtraCount;		// 요청하지 않은 플래그 수, 적을 수록 좋음
+	};
+
+	std::vector<jCandidate> candidates;
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+	{
+		if (!(memoryTypeBits & (1 << i)))
+			continue;
+
+		const VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+		if ((flags & required) != required)
+			continue;
+
+		jCandidate candidate;
+		candidate.MemoryTypeIndex = i;
+		candidate.PreferredCount = CountBits(flags & preferred);
+		candidate.ExtraCount = CountBits(flags & ~(required | preferred));
+		candidates.push_back(candidate);
+	}
+
+	// 같은 점수면 드라이버가 알려준 순서를 유지함 (스펙상 앞쪽 타입이 더 좋은 성능을 가짐)
+	std::stable_sort(candidates.begin(), candidates.end(), [](const jCandidate& a, const jCandidate& b)
+	{
+		if (a.PreferredCount != b.PreferredCount)
+			return a.PreferredCount > b.PreferredCount;
+		return a.ExtraCount < b.ExtraCount;
+	});
+
+	outCandidates.clear();
+	for (const jCandidate& candidate : candidates)
+		outCandidates.push_back(candidate.MemoryTypeIndex);
+
+	return !outCandidates.empty();
+}
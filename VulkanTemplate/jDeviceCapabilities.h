@@ -0,0 +1,71 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// PhysicalDevice 의 속성들을 한번만 조회해서 들고 있는 캐시.
+// PickPhysicalDevice 이후에 Initialize 하며, 이후로는 vkGetPhysicalDevice* 를 직접 호출하지 않고 여기서 읽음.
+// 메모리 타입 후보 목록과 확장 포맷은 처음 요청될때 채워지므로 메인 스레드에서만 사용해야 함.
+class jDeviceCapabilities
+{
+public:
+	void Initialize(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
+
+	// 실제 디바이스 없이 메모리 타입 선택만 사용하는 경우 (ex. 미리 만들어둔 메모리 속성 테이블로 확인할때)
+	void InitializeMemoryProperties(const VkPhysicalDeviceMemoryProperties& memoryProperties);
+
+	VkPhysicalDevice GetPhysicalDevice() const { return PhysicalDevice; }
+	const VkPhysicalDeviceProperties& GetProperties() const { return Properties; }
+	const VkPhysicalDeviceLimits& GetLimits() const { return Properties.limits; }
+	const VkPhysicalDeviceFeatures& GetFeatures() const { return Features; }
+	const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return MemoryProperties; }
+	const std::vector<VkQueueFamilyProperties>& GetQueueFamilies() const { return QueueFamilies; }
+	bool IsPresentSupported(uint32_t queueFamilyIndex) const { return (queueFamilyIndex < PresentSupport.size()) && PresentSupport[queueFamilyIndex]; }
+
+	// 선택적으로 켜는 디바이스 확장 지원 여부
+	bool IsExtensionSupported(const char* extensionName) const;
+
+	// Vulkan 1.2 기능과 속성. 디바이스가 1.2 미만이면 모두 0 으로 채워져 있음.
+	bool IsVulkan12Supported() const { return Properties.apiVersion >= VK_API_VERSION_1_2; }
+	const VkPhysicalDeviceVulkan12Features& GetVulkan12Features() const { return Vulkan12Features; }
+	const VkPhysicalDeviceVulkan12Properties& GetVulkan12Properties() const { return Vulkan12Properties; }
+
+	// Bindless(Descriptor indexing) 에 필요한 기능이 있고, Update after bind 텍스쳐를 maxTextures 개 이상 쓸 수 있는지 여부
+	bool IsBindlessSupported(uint32_t maxTextures) const;
+
+	const VkFormatProperties& GetFormatProperties(VkFormat format) const;
+	bool IsFormatSupported(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features) const;
+
+	VkSampleCountFlagBits GetMaxUsableSampleCount() const;
+
+	// memoryTypeBits 중 properties 를 모두 가진 첫번째 메모리 타입. 없으면 false.
+	bool FindMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags properties, uint32_t& outMemoryTypeIndex) const;
+
+	// memoryTypeBits 중 required 를 모두 가진 타입들을 우선순위 순서로 돌려줌. 결과는 (typeBits, required, preferred) 로 캐시됨.
+	const std::vector<uint32_t>& GetMemoryTypeCandidates(uint32_t memoryTypeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const;
+
+	// - required 플래그는 반드시 있어야 하고, preferred 플래그는 많이 가질수록 우선함.
+	// - 요청하지 않은 플래그가 적은 타입을 우선함. DEVICE_LOCAL 만 요청했는데 작은 BAR 영역(DEVICE_LOCAL | HOST_VISIBLE) 을 쓰지 않도록.
+	static bool FindMemoryTypeCandidates(const VkPhysicalDeviceMemoryProperties& memoryProperties, uint32_t memoryTypeBits
+		, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, std::vector<uint32_t>& outCandidates);
+
+private:
+	VkPhysicalDevice PhysicalDevice = VK_NULL_HANDLE;
+	VkPhysicalDeviceProperties Properties = {};
+	VkPhysicalDeviceFeatures Features = {};
+	VkPhysicalDeviceMemoryProperties MemoryProperties = {};
+	VkPhysicalDeviceVulkan12Features Vulkan12Features = {};
+	VkPhysicalDeviceVulkan12Properties Vulkan12Properties = {};
+	std::vector<VkQueueFamilyProperties> QueueFamilies;
+	std::vector<bool> PresentSupport;
+	std::vector<VkExtensionProperties> Extensions;
+
+	// 코어 포맷들은 Initialize 에서 모두 조회해두고, 확장 포맷(값이 큰 포맷) 은 처음 요청될때 조회함
+	std::vector<VkFormatProperties> CoreFormatProperties;
+	mutable std::unordered_map<int32_t, VkFormatProperties> ExtensionFormatProperties;
+
+	mutable std::unordered_map<uint64_t, std::vector<uint32_t>> MemoryTypeCandidates;
+};
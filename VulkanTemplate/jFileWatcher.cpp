@@ -0,0 +1,157 @@
+﻿#include <pch.h>
+#include "jFileWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#if !defined(_WIN32)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include "jAssert.h"
+
+// 알림을 기다리는 최대 시간. Release 에서 워커가 끝나는데 걸리는 시간이기도 함.
+static constexpr uint32_t WATCH_TIMEOUT_MS = 100;
+
+// 알림을 받은 뒤 저장이 끝날때까지 기다리는 시간
+static constexpr uint32_t SETTLE_DELAY_MS = 50;
+
+bool jFileWatcher::Initialize(const std::string& directory)
+{
+	JASSERT(!Worker.joinable());
+
+	std::error_code errorCode;
+	if (!std::filesystem::is_directory(directory, errorCode))
+		return false;
+
+	Directory = directory;
+	WriteTimes.clear();
+	ChangedFiles.clear();
+	Scan(false);
+
+#if defined(_WIN32)
+	ChangeHandle = FindFirstChangeNotificationA(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE);
+	if (ChangeHandle == INVALID_HANDLE_VALUE)
+		ChangeHandle = nullptr;
+#else
+	InotifyFd = inotify_init1(IN_NONBLOCK);
+	if ((InotifyFd >= 0) && (inotify_add_watch(InotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0))
+	{
+		close(InotifyFd);
+		InotifyFd = -1;
+	}
+#endif
+
+	ExitRequested = false;
+	Worker = std::thread(&jFileWatcher::WorkerMain, this);
+	return true;
+}
+
+void jFileWatcher::Release()
+{
+	if (Worker.joinable())
+	{
+		ExitRequested = true;
+		Worker.join();
+	}
+
+#if defined(_WIN32)
+	if (ChangeHandle)
+	{
+		FindCloseChangeNotification(ChangeHandle);
+		ChangeHandle = nullptr;
+	}
+#else
+	if (InotifyFd >= 0)
+	{
+		close(InotifyFd);
+		InotifyFd = -1;
+	}
+#endif
+}
+
+bool jFileWatcher::ConsumeChanges(std::vector<std::string>& outChangedFiles)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	outChangedFiles.swap(ChangedFiles);
+	ChangedFiles.clear();
+	return !outChangedFiles.empty();
+}
+
+void jFileWatcher::WorkerMain()
+{
+	while (!ExitRequested)
+	{
+		if (!WaitForNotification(WATCH_TIMEOUT_MS))
+			continue;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_DELAY_MS));
+		Scan(true);
+	}
+}
+
+bool jFileWatcher::WaitForNotification(uint32_t timeoutMs)
+{
+#if defined(_WIN32)
+	if (ChangeHandle)
+	{
+		if (WaitForSingleObject(ChangeHandle, timeoutMs) != WAIT_OBJECT_0)
+			return false;
+
+		FindNextChangeNotification(ChangeHandle);
+		return true;
+	}
+#else
+	if (InotifyFd >= 0)
+	{
+		pollfd pollFd = {};
+		pollFd.fd = InotifyFd;
+		pollFd.events = POLLIN;
+		if (poll(&pollFd, 1, static_cast<int>(timeoutMs)) <= 0)
+			return false;
+
+		// 이벤트 내용은 쓰지 않으므로 비우기만 함
+		char buffer[4096];
+		while (read(InotifyFd, buffer, sizeof(buffer)) > 0) {}
+		return true;
+	}
+#endif
+
+	// 알림을 쓸 수 없으면 주기적으로 확인함
+	std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+	return true;
+}
+
+void jFileWatcher::Scan(bool reportChanges)
+{
+	std::vector<std::string> changedFiles;
+
+	std::error_code errorCode;
+	for (std::filesystem::directory_iterator it(Directory, errorCode), end; !errorCode && (it != end); it.increment(errorCode))
+	{
+		if (!it->is_regular_file(errorCode))
+			continue;
+
+		const std::filesystem::file_time_type writeTime = it->last_write_time(errorCode);
+		if (errorCode)
+			continue;
+
+		const std::string filename = it->path().filename().string();
+		auto writeTimeIt = WriteTimes.find(filename);
+		if ((writeTimeIt != WriteTimes.end()) && (writeTimeIt->second == writeTime))
+			continue;
+
+		WriteTimes[filename] = writeTime;
+		changedFiles.push_back(Directory + "/" + filename);
+	}
+
+	if (!reportChanges || changedFiles.empty())
+		return;
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	for (std::string& changedFile : changedFiles)
+	{
+		if (std::find(ChangedFiles.begin(), ChangedFiles.end(), changedFile) == ChangedFiles.end())
+			ChangedFiles.push_back(std::move(changedFile));
+	}
+}
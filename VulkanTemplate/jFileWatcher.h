@@ -0,0 +1,48 @@
+﻿#pragma once
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+// 디렉토리 하나(하위 디렉토리 제외) 의 파일이 수정되는 것을 백그라운드 스레드에서 감시함. 쉐이더 Hot reload 용.
+//
+// - OS 알림(Windows 는 FindFirstChangeNotification, Linux 는 inotify) 으로 깨어난 뒤 파일들의 수정 시간을 비교해서 바뀐 파일을 찾음.
+//   에디터마다 저장하는 방식(덮어쓰기, 임시 파일 후 이름 바꾸기 등) 이 달라도 같은 결과가 나오도록 알림 내용은 쓰지 않음.
+// - 알림을 만들 수 없으면 주기적으로 수정 시간을 비교함.
+// - 저장 한번에 알림이 여러번 오므로 잠깐 기다렸다가 한번에 모아서 확인함.
+class jFileWatcher
+{
+public:
+	~jFileWatcher() { Release(); }
+
+	bool Initialize(const std::string& directory);
+	void Release();
+
+	// 지난 호출 이후에 수정되거나 새로 생긴 파일들. 경로는 "directory/filename" 형식. 메인 스레드에서 호출.
+	bool ConsumeChanges(std::vector<std::string>& outChangedFiles);
+
+private:
+	void WorkerMain();
+	bool WaitForNotification(uint32_t timeoutMs);
+	void Scan(bool reportChanges);
+
+	std::string Directory;
+	std::thread Worker;
+	std::atomic<bool> ExitRequested{ false };
+
+#if defined(_WIN32)
+	void* ChangeHandle = nullptr;		// HANDLE
+#else
+	int InotifyFd = -1;
+#endif
+
+	// 워커 스레드에서만 사용
+	std::unordered_map<std::string, std::filesystem::file_time_type> WriteTimes;
+
+	std::mutex Mutex;
+	std::vector<std::string> ChangedFiles;		// Mutex 로 보호됨
+};
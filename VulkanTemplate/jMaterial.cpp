@@ -0,0 +1,43 @@
+﻿#include <pch.h>
+#include "jMaterial.h"
+
+#include <cstring>
+
+void jMaterial::AppendSpecializationConstants(std::vector<jSpecializationConstant>& outConstants) const
+{
+	// 꺼진 기능도 상수를 넘겨야 쉐이더의 기본값(Texture 만 켜짐) 대신 이 값이 쓰임
+	for (uint32_t i = 0; i < jMaterialFeatureCount; ++i)
+	{
+		jSpecializationConstant constant;
+		constant.Stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		constant.ConstantID = i;
+		constant.Value = (Features & (1u << i)) ? VK_TRUE : VK_FALSE;
+		outConstants.push_back(constant);
+	}
+
+	// AlphaTest 가 아니면 쓰이지 않는 값이므로 넣지 않아야 값만 다른 같은 파이프라인이 생기지 않음
+	if (Features & jMaterialFeature::AlphaTest)
+	{
+		jSpecializationConstant constant;
+		constant.Stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		constant.ConstantID = jMaterialFeatureCount;
+		memcpy(&constant.Value, &AlphaCutoff, sizeof(float));
+		outConstants.push_back(constant);
+	}
+}
+
+std::string jMaterial::GetFeatureString() const
+{
+	static const char* FeatureNames[jMaterialFeatureCount] = { "VertexColor", "Texture", "AlphaTest" };
+
+	std::string result;
+	for (uint32_t i = 0; i < jMaterialFeatureCount; ++i)
+	{
+		if (!(Features & (1u << i)))
+			continue;
+		if (!result.empty())
+			result += "|";
+		result += FeatureNames[i];
+	}
+	return result.empty() ? "None" : result;
+}
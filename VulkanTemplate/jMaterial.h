@@ -0,0 +1,35 @@
+﻿#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "jPipelineStateCache.h"
+
+// 머터리얼 기능 토글. 프래그먼트 쉐이더는 이 값들을 Specialization constant 로 받으므로
+// 파이프라인을 만들때 분기가 상수로 접혀서, 머터리얼마다 GLSL 파일을 따로 두지 않아도 분기 없는 코드가 실행됨.
+// 비트 인덱스가 쉐이더의 constant_id 와 같아야 함 (Shaders/shader.frag, Shaders/shader_bindless.frag).
+namespace jMaterialFeature
+{
+	enum Type : uint32_t
+	{
+		VertexColor = 1 << 0,		// constant_id = 0 : 버텍스 컬러를 곱함
+		Texture = 1 << 1,			// constant_id = 1 : 텍스쳐를 샘플링함
+		AlphaTest = 1 << 2			// constant_id = 2 : 알파가 AlphaCutoff 보다 작으면 discard
+	};
+}
+
+// jMaterialFeature 비트 수. AlphaCutoff 는 이 다음 constant_id 를 씀.
+constexpr uint32_t jMaterialFeatureCount = 3;
+
+// Features 조합마다 파이프라인 변형이 하나씩 만들어지며, 같은 조합의 머터리얼은 jPipelineStateCache 에서 파이프라인을 공유함.
+struct jMaterial
+{
+	uint32_t Features = jMaterialFeature::Texture;
+	float AlphaCutoff = 0.5f;		// constant_id = 3 : AlphaTest 일때만 파이프라인 상태에 포함됨
+
+	// 프래그먼트 쉐이더용 Specialization constant 들을 추가함
+	void AppendSpecializationConstants(std::vector<jSpecializationConstant>& outConstants) const;
+
+	// 디버그 출력용 (ex. "Texture|AlphaTest")
+	std::string GetFeatureString() const;
+};
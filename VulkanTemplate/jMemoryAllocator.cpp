@@ -0,0 +1,357 @@
+﻿#include <pch.h>
+#include "jMemoryAllocator.h"
+#include "jDeviceCapabilities.h"
+
+#include <algorithm>
+#include "jAssert.h"
+#include "Generic/TemplateUtility.h"
+
+//////////////////////////////////////////////////////////////////////////
+// jMemoryBlock
+jMemoryBlock::jMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, void* mappedData)
+	: Memory(memory), Size(size), MemoryTypeIndex(memoryTypeIndex), MappedData(static_cast<uint8_t*>(mappedData))
+{
+	jFreeRange range;
+	range.Offset = 0;
+	range.Size = size;
+	FreeRanges.push_back(range);
+}
+
+bool jMemoryBlock::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset, VkDeviceSize& outRangeOffset, VkDeviceSize& outRangeSize)
+{
+	if (size == 0)
+		return false;
+
+	// Aligned 는 2의 승수만 처리가능, Vulkan 의 alignment 는 항상 2의 승수임
+	alignment = std::max<VkDeviceSize>(alignment, 1);
+	JASSERT((alignment & (alignment - 1)) == 0);
+
+	// 남는 공간이 가장 적은 빈 영역을 선택 (Best fit)
+	size_t bestIndex = FreeRanges.size();
+	VkDeviceSize bestLeftover = 0;
+	for (size_t i = 0; i < FreeRanges.size(); ++i)
+	{
+		const jFreeRange& range = FreeRanges[i];
+		const VkDeviceSize alignedOffset = Aligned(range.Offset, alignment);
+		const VkDeviceSize required = (alignedOffset - range.Offset) + size;
+		if (required > range.Size)
+			continue;
+
+		const VkDeviceSize leftover = range.Size - required;
+		if (bestIndex == FreeRanges.size() || leftover < bestLeftover)
+		{
+			bestIndex = i;
+			bestLeftover = leftover;
+			if (leftover == 0)
+				break;
+		}
+	}
+
+	if (bestIndex == FreeRanges.size())
+		return false;
+
+	// 앞쪽의 정렬 패딩은 할당 영역에 포함시킴. 반환될때 같이 돌아오므로 따로 관리하지 않아도 됨.
+	jFreeRange& range = FreeRanges[bestIndex];
+	outRangeOffset = range.Offset;
+	outOffset = Aligned(range.Offset, alignment);
+	outRangeSize = (outOffset - range.Offset) + size;
+
+	if (range.Size == outRangeSize)
+	{
+		FreeRanges.erase(FreeRanges.begin() + bestIndex);
+	}
+	else
+	{
+		range.Offset += outRangeSize;
+		range.Size -= outRangeSize;
+	}
+
+	UsedSize += outRangeSize;
+	++AllocationCount;
+	return true;
+}
+
+void jMemoryBlock::Free(VkDeviceSize rangeOffset, VkDeviceSize rangeSize)
+{
+	JASSERT(AllocationCount > 0);
+	JASSERT((rangeOffset + rangeSize) <= Size);
+
+	// Offset 순서를 유지하도록 들어갈 위치를 찾음
+	auto it = std::lower_bound(FreeRanges.begin(), FreeRanges.end(), rangeOffset
+		, [](const jFreeRange& range, VkDeviceSize offset) { return range.Offset < offset; });
+
+	// 뒤쪽 빈 영역과 합침
+	const bool mergeNext = (it != FreeRanges.end()) && ((rangeOffset + rangeSize) == it->Offset);
+
+	// 앞쪽 빈 영역과 합침
+	const bool mergePrev = (it != FreeRanges.begin()) && (((it - 1)->Offset + (it - 1)->Size) == rangeOffset);
+
+	if (mergePrev && mergeNext)
+	{
+		(it - 1)->Size += rangeSize + it->Size;
+		FreeRanges.erase(it);
+	}
+	else if (mergePrev)
+	{
+		(it - 1)->Size += rangeSize;
+	}
+	else if (mergeNext)
+	{
+		it->Offset = rangeOffset;
+		it->Size += rangeSize;
+	}
+	else
+	{
+		jFreeRange range;
+		range.Offset = rangeOffset;
+		range.Size = rangeSize;
+		FreeRanges.insert(it, range);
+	}
+
+	UsedSize -= rangeSize;
+	--AllocationCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// jMemoryAllocator
+void jMemoryAllocator::Initialize(VkDevice device, const jDeviceCapabilities& capabilities, VkDeviceSize preferredBlockSize
+	, const jMemoryDeviceFunctions& deviceFunctions)
+{
+	Device = device;
+	Capabilities = &capabilities;
+	MemoryProperties = capabilities.GetMemoryProperties();
+	const VkPhysicalDeviceMemoryProperties& memoryProperties = MemoryProperties;
+	PreferredBlockSize = preferredBlockSize;
+	DeviceFunctions = deviceFunctions;
+
+	UMA = (memoryProperties.memoryHeapCount > 0);
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+	{
+		if (!(memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+			UMA = false;
+	}
+
+	DirectUploadAvailable = false;
+	const VkMemoryPropertyFlags directUploadFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+	{
+		if ((memoryProperties.memoryTypes[i].propertyFlags & directUploadFlags) != directUploadFlags)
+			continue;
+
+		const VkMemoryHeap& heap = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex];
+		if (UMA || (heap.size > DirectUploadMinHeapSize))
+		{
+			DirectUploadAvailable = true;
+			break;
+		}
+	}
+}
+
+void jMemoryAllocator::Release()
+{
+	for (jBlockList& blockList : BlockLists)
+	{
+		for (auto& block : blockList)
+		{
+			// 아직 반환되지 않은 할당이 있다면 리소스가 해제되지 않은 것임
+			JASSERT(block->IsEmpty());
+			DeviceFunctions.FreeMemory(Device, block->GetMemory(), nullptr);
+		}
+		blockList.clear();
+	}
+
+	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+	{
+		JASSERT(DedicatedCount[i] == 0);
+		DedicatedCount[i] = 0;
+		DedicatedBytes[i] = 0;
+	}
+}
+
+bool jMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred
+	, bool isLinear, bool dedicated, jMemoryAllocation& outAllocation)
+{
+	const std::vector<uint32_t>& candidates = Capabilities->GetMemoryTypeCandidates(requirements.memoryTypeBits, required, preferred);
+	if (!ensure(!candidates.empty()))
+		return false;
+
+	// 우선순위가 높은 타입의 Heap 이 가득찼으면 다음 타입으로 넘어감
+	for (uint32_t memoryTypeIndex : candidates)
+	{
+		if (Allocate(requirements, memoryTypeIndex, isLinear, dedicated, outAllocation))
+			return true;
+	}
+	return false;
+}
+
+bool jMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, bool isLinear, bool dedicated, jMemoryAllocation& outAllocation)
+{
+	if (!ensure(memoryTypeIndex < MemoryProperties.memoryTypeCount))
+		return false;
+
+	const VkDeviceSize blockSize = GetBlockSize(memoryTypeIndex);
+
+	// Block 에 비해 너무 큰 리소스는 Block 에 넣으면 낭비되는 공간이 커지므로 따로 할당
+	if (dedicated || (requirements.size > blockSize / 2))
+		return AllocateDedicated(requirements, memoryTypeIndex, outAllocation);
+
+	jBlockList& blockList = GetBlockList(memoryTypeIndex, isLinear);
+
+	jMemoryBlock* targetBlock = nullptr;
+	VkDeviceSize offset = 0;
+	VkDeviceSize rangeOffset = 0;
+	VkDeviceSize rangeSize = 0;
+	for (auto& block : blockList)
+	{
+		if (block->Allocate(requirements.size, requirements.alignment, offset, rangeOffset, rangeSize))
+		{
+			targetBlock = block.get();
+			break;
+		}
+	}
+
+	if (!targetBlock)
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		void* mappedData = nullptr;
+		if (!AllocateDeviceMemory(blockSize, memoryTypeIndex, memory, mappedData))
+		{
+			// Block 크기 만큼 할당할 공간이 없다면 필요한 만큼만이라도 할당해봄
+			return AllocateDedicated(requirements, memoryTypeIndex, outAllocation);
+		}
+
+		blockList.push_back(std::make_unique<jMemoryBlock>(memory, blockSize, memoryTypeIndex, mappedData));
+		targetBlock = blockList.back().get();
+		if (!ensure(targetBlock->Allocate(requirements.size, requirements.alignment, offset, rangeOffset, rangeSize)))
+			return false;
+	}
+
+	outAllocation.Memory = targetBlock->GetMemory();
+	outAllocation.Offset = offset;
+	outAllocation.Size = requirements.size;
+	outAllocation.MemoryTypeIndex = memoryTypeIndex;
+	outAllocation.MappedData = targetBlock->GetMappedData() ? (targetBlock->GetMappedData() + offset) : nullptr;
+	outAllocation.Block = targetBlock;
+	outAllocation.RangeOffset = rangeOffset;
+	outAllocation.RangeSize = rangeSize;
+	return true;
+}
+
+void jMemoryAllocator::Free(jMemoryAllocation& allocation)
+{
+	if (!allocation.IsValid())
+		return;
+
+	if (!allocation.Block)
+	{
+		// Map 되어있어도 vkFreeMemory 가 같이 Unmap 해줌
+		DeviceFunctions.FreeMemory(Device, allocation.Memory, nullptr);
+		--DedicatedCount[allocation.MemoryTypeIndex];
+		DedicatedBytes[allocation.MemoryTypeIndex] -= allocation.Size;
+		allocation = jMemoryAllocation();
+		return;
+	}
+
+	jMemoryBlock* block = allocation.Block;
+	block->Free(allocation.RangeOffset, allocation.RangeSize);
+
+	// 빈 Block 은 하나만 남겨두고 해제함. 할당과 해제가 반복될때 매번 vkAllocateMemory 하지 않도록.
+	if (block->IsEmpty())
+	{
+		for (uint32_t i = 0; i < 2; ++i)
+		{
+			jBlockList& blockList = GetBlockList(block->GetMemoryTypeIndex(), (i == 1));
+			auto it = std::find_if(blockList.begin(), blockList.end(), [block](const std::unique_ptr<jMemoryBlock>& item) { return item.get() == block; });
+			if (it == blockList.end())
+				continue;
+
+			const size_t emptyCount = std::count_if(blockList.begin(), blockList.end(), [](const std::unique_ptr<jMemoryBlock>& item) { return item->IsEmpty(); });
+			if (emptyCount > 1)
+			{
+				DeviceFunctions.FreeMemory(Device, block->GetMemory(), nullptr);
+				blockList.erase(it);
+			}
+			break;
+		}
+	}
+
+	allocation = jMemoryAllocation();
+}
+
+jMemoryHeapStats jMemoryAllocator::GetHeapStats(uint32_t heapIndex) const
+{
+	jMemoryHeapStats stats;
+	for (uint32_t i = 0; i < MemoryProperties.memoryTypeCount; ++i)
+	{
+		if (MemoryProperties.memoryTypes[i].heapIndex != heapIndex)
+			continue;
+
+		for (uint32_t k = 0; k < 2; ++k)
+		{
+			for (const auto& block : BlockLists[i * 2 + k])
+			{
+				++stats.BlockCount;
+				stats.AllocationCount += block->GetAllocationCount();
+				stats.BlockBytes += block->GetSize();
+				stats.UsedBytes += block->GetUsedSize();
+			}
+		}
+
+		stats.DedicatedAllocationCount += DedicatedCount[i];
+		stats.DedicatedBytes += DedicatedBytes[i];
+	}
+	return stats;
+}
+
+VkDeviceSize jMemoryAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+{
+	// 작은 Heap (ex. 256MB 의 BAR 영역) 에서 Block 하나가 Heap 을 다 차지하지 않도록 Heap 크기의 1/8 까지로 제한함
+	const uint32_t heapIndex = MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+	const VkDeviceSize heapSize = MemoryProperties.memoryHeaps[heapIndex].size;
+	return std::min(PreferredBlockSize, std::max<VkDeviceSize>(heapSize / 8, 1));
+}
+
+bool jMemoryAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, VkDeviceMemory& outMemory, void*& outMappedData)
+{
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+	if (DeviceFunctions.AllocateMemory(Device, &allocInfo, nullptr, &outMemory) != VK_SUCCESS)
+		return false;
+
+	// HOST_VISIBLE 메모리는 해제될때까지 Map 된 상태로 유지함
+	outMappedData = nullptr;
+	if (MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		if (!ensure(DeviceFunctions.MapMemory(Device, outMemory, 0, VK_WHOLE_SIZE, 0, &outMappedData) == VK_SUCCESS))
+		{
+			DeviceFunctions.FreeMemory(Device, outMemory, nullptr);
+			outMemory = VK_NULL_HANDLE;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool jMemoryAllocator::AllocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, jMemoryAllocation& outAllocation)
+{
+	// 실패하면 호출한 쪽에서 다른 Heap 의 메모리 타입으로 다시 시도할 수 있으므로 여기서는 ensure 하지 않음
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	void* mappedData = nullptr;
+	if (!AllocateDeviceMemory(requirements.size, memoryTypeIndex, memory, mappedData))
+		return false;
+
+	++DedicatedCount[memoryTypeIndex];
+	DedicatedBytes[memoryTypeIndex] += requirements.size;
+
+	outAllocation.Memory = memory;
+	outAllocation.Offset = 0;
+	outAllocation.Size = requirements.size;
+	outAllocation.MemoryTypeIndex = memoryTypeIndex;
+	outAllocation.MappedData = mappedData;
+	outAllocation.Block = nullptr;
+	outAllocation.RangeOffset = 0;
+	outAllocation.RangeSize = requirements.size;
+	return true;
+}
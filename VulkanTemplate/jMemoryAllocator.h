@@ -0,0 +1,140 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+class jMemoryBlock;
+class jDeviceCapabilities;
+
+// jMemoryAllocator 에서 받은 메모리 영역. 리소스는 Memory 의 Offset 위치에 바인딩 해야 함.
+struct jMemoryAllocation
+{
+	VkDeviceMemory Memory = VK_NULL_HANDLE;
+	VkDeviceSize Offset = 0;
+	VkDeviceSize Size = 0;
+	uint32_t MemoryTypeIndex = 0;
+	void* MappedData = nullptr;			// HOST_VISIBLE 메모리인 경우 Offset 위치를 가리킴, 아니면 nullptr
+
+	jMemoryBlock* Block = nullptr;		// nullptr 이면 Dedicated allocation
+	VkDeviceSize RangeOffset = 0;		// Block 안에서 정렬 패딩을 포함해 실제로 차지하는 영역
+	VkDeviceSize RangeSize = 0;
+
+	bool IsValid() const { return Memory != VK_NULL_HANDLE; }
+};
+
+// 하나의 VkDeviceMemory 를 Free list 로 나눠 씀.
+// 빈 영역들은 Offset 순서로 정렬되어 있고, 반환될때 인접한 빈 영역과 합쳐짐.
+class jMemoryBlock
+{
+public:
+	jMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, void* mappedData);
+
+	// 성공하면 outOffset 은 alignment 가 맞춰진 위치, outRangeOffset / outRangeSize 는 패딩을 포함한 사용 영역.
+	bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset, VkDeviceSize& outRangeOffset, VkDeviceSize& outRangeSize);
+	void Free(VkDeviceSize rangeOffset, VkDeviceSize rangeSize);
+
+	VkDeviceMemory GetMemory() const { return Memory; }
+	VkDeviceSize GetSize() const { return Size; }
+	VkDeviceSize GetUsedSize() const { return UsedSize; }
+	uint32_t GetMemoryTypeIndex() const { return MemoryTypeIndex; }
+	uint32_t GetAllocationCount() const { return AllocationCount; }
+	uint8_t* GetMappedData() const { return MappedData; }
+	bool IsEmpty() const { return AllocationCount == 0; }
+
+private:
+	struct jFreeRange
+	{
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+	};
+
+	VkDeviceMemory Memory = VK_NULL_HANDLE;
+	VkDeviceSize Size = 0;
+	uint32_t MemoryTypeIndex = 0;
+	uint8_t* MappedData = nullptr;
+
+	VkDeviceSize UsedSize = 0;
+	uint32_t AllocationCount = 0;
+	std::vector<jFreeRange> FreeRanges;
+};
+
+// Heap 별 메모리 사용량
+struct jMemoryHeapStats
+{
+	uint32_t BlockCount = 0;
+	uint32_t AllocationCount = 0;				// Block 에서 나눠준 할당 수
+	uint32_t DedicatedAllocationCount = 0;
+	VkDeviceSize BlockBytes = 0;				// Block 으로 잡아둔 전체 크기
+	VkDeviceSize UsedBytes = 0;					// Block 중 사용중인 크기 (정렬 패딩 포함)
+	VkDeviceSize DedicatedBytes = 0;
+};
+
+// jMemoryAllocator 가 사용하는 Vulkan 메모리 함수들. 테스트에서는 가짜 디바이스의 함수로 바꿔서 디바이스 없이 돌림.
+struct jMemoryDeviceFunctions
+{
+	PFN_vkAllocateMemory AllocateMemory = vkAllocateMemory;
+	PFN_vkFreeMemory FreeMemory = vkFreeMemory;
+	PFN_vkMapMemory MapMemory = vkMapMemory;
+};
+
+// 리소스마다 vkAllocateMemory 를 하지 않고, 메모리 타입별로 큰 Block 을 잡아서 나눠주는 할당자.
+// - 드라이버의 최대 할당 개수 제한(maxMemoryAllocationCount, 보통 4096) 에 걸리지 않고, 느린 vkAllocateMemory 호출을 줄임.
+// - Buffer(Linear) 와 Optimal 타일링 이미지는 서로 다른 Block 을 쓰므로 bufferImageGranularity 를 신경쓰지 않아도 됨.
+// - Block 크기의 절반보다 큰 리소스나 요청한 경우에는 Dedicated allocation 으로 따로 할당함.
+// - HOST_VISIBLE 메모리는 Block 을 만들때 한번만 Map 해두며 jMemoryAllocation::MappedData 로 바로 접근함.
+//   같은 VkDeviceMemory 를 여러번 Map 할 수 없으므로 할당받은 메모리에 vkMapMemory 를 호출하면 안됨.
+//
+// 메모리 타입 선택
+// - jDeviceCapabilities::GetMemoryTypeCandidates 의 우선순위를 따름.
+// - 선택한 타입의 Heap 에 공간이 없으면 다음 후보 타입(다른 Heap) 으로 넘어감.
+class jMemoryAllocator
+{
+public:
+	// capabilities 는 할당자보다 오래 살아있어야 함
+	void Initialize(VkDevice device, const jDeviceCapabilities& capabilities, VkDeviceSize preferredBlockSize = DefaultBlockSize
+		, const jMemoryDeviceFunctions& deviceFunctions = jMemoryDeviceFunctions());
+	void Release();
+
+	// isLinear : Buffer 이거나 VK_IMAGE_TILING_LINEAR 이미지인 경우 true
+	bool Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred
+		, bool isLinear, bool dedicated, jMemoryAllocation& outAllocation);
+	bool Allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, bool isLinear, bool dedicated, jMemoryAllocation& outAllocation);
+	void Free(jMemoryAllocation& allocation);
+
+	uint32_t GetHeapCount() const { return MemoryProperties.memoryHeapCount; }
+	jMemoryHeapStats GetHeapStats(uint32_t heapIndex) const;
+
+	// DEVICE_LOCAL 메모리에 CPU 가 바로 쓸 수 있는지 여부. (Staging 버퍼 없이 바로 업로드 가능)
+	// - UMA : 통합 GPU 나 소프트웨어 구현처럼 모든 Heap 이 DEVICE_LOCAL 인 경우
+	// - ReBAR : 외장 GPU 에서 Resizable BAR 가 켜져서 DEVICE_LOCAL | HOST_VISIBLE Heap 이 충분히 큰 경우
+	//   (꺼져있으면 보통 256MB 라서 큰 데이터를 넣으면 금방 부족해짐)
+	bool IsUMA() const { return UMA; }
+	bool IsDirectUploadAvailable() const { return DirectUploadAvailable; }
+
+	static constexpr VkDeviceSize DirectUploadMinHeapSize = 256 * 1024 * 1024;
+
+	static constexpr VkDeviceSize DefaultBlockSize = 64 * 1024 * 1024;
+
+private:
+	VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+	bool AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, VkDeviceMemory& outMemory, void*& outMappedData);
+	bool AllocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, jMemoryAllocation& outAllocation);
+
+	using jBlockList = std::vector<std::unique_ptr<jMemoryBlock>>;
+	jBlockList& GetBlockList(uint32_t memoryTypeIndex, bool isLinear) { return BlockLists[memoryTypeIndex * 2 + (isLinear ? 1 : 0)]; }
+
+	VkDevice Device = VK_NULL_HANDLE;
+	const jDeviceCapabilities* Capabilities = nullptr;
+	VkPhysicalDeviceMemoryProperties MemoryProperties = {};
+	VkDeviceSize PreferredBlockSize = DefaultBlockSize;
+	jMemoryDeviceFunctions DeviceFunctions;
+	bool UMA = false;
+	bool DirectUploadAvailable = false;
+
+	jBlockList BlockLists[VK_MAX_MEMORY_TYPES * 2];
+	uint32_t DedicatedCount[VK_MAX_MEMORY_TYPES] = {};
+	VkDeviceSize DedicatedBytes[VK_MAX_MEMORY_TYPES] = {};
+};
@@ -0,0 +1,212 @@
+﻿#include <pch.h>
+#include "jPipelineCache.h"
+
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "jAssert.h"
+
+bool jPipelineCache::Initialize(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& filename, bool useCreationFeedback)
+{
+	JASSERT(!Cache);
+
+	Device = device;
+	Filename = filename;
+	CreationFeedbackEnabled = useCreationFeedback;
+	VendorID = properties.vendorID;
+	DeviceID = properties.deviceID;
+	memcpy(PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+	LoadedSize = 0;
+
+	// 파일이 없는 것은 처음 실행한 경우이므로 오류가 아님
+	std::vector<char> data;
+	std::ifstream file(filename, std::ios::ate | std::ios::binary);
+	if (file.is_open())
+	{
+		data.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(data.data(), data.size());
+		if (!file)
+			data.clear();
+	}
+
+	// 드라이버나 GPU 가 바뀌었으면 호환되지 않는 데이터이므로 버림. 드라이버도 확인하지만 잘못된 데이터를 넘기지 않도록 먼저 걸러냄.
+	if (!data.empty() && !IsCompatible(data.data(), data.size()))
+		data.clear();
+
+	VkPipelineCacheCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.empty() ? nullptr : data.data();
+	if (vkCreatePipelineCache(device, &createInfo, nullptr, &Cache) != VK_SUCCESS)
+	{
+		// 데이터를 받아주지 않으면 빈 캐시로 다시 시도함
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+		data.clear();
+		if (!ensure(vkCreatePipelineCache(device, &createInfo, nullptr, &Cache) == VK_SUCCESS))
+			return false;
+	}
+
+	LoadedSize = data.size();
+	return true;
+}
+
+void jPipelineCache::Release()
+{
+	if (Cache)
+	{
+		vkDestroyPipelineCache(Device, Cache, nullptr);
+		Cache = VK_NULL_HANDLE;
+	}
+}
+
+bool jPipelineCache::Save()
+{
+	if (!ensure(Cache))
+		return false;
+
+	size_t size = GetDataSize();
+	if (size == 0)
+		return false;
+
+	std::vector<char> data(size);
+	if (!ensure(vkGetPipelineCacheData(Device, Cache, &size, data.data()) == VK_SUCCESS))
+		return false;
+	data.resize(size);
+
+	const std::string tempFilename = Filename + ".tmp";
+	{
+		std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false;
+		file.write(data.data(), data.size());
+		if (!file)
+			return false;
+	}
+
+	// Windows 의 rename 은 대상 파일이 있으면 실패하므로 먼저 지움
+	std::remove(Filename.c_str());
+	return std::rename(tempFilename.c_str(), Filename.c_str()) == 0;
+}
+
+static uint32_t GetStageCount(const VkGraphicsPipelineCreateInfo& createInfo) { return createInfo.stageCount; }
+static uint32_t GetStageCount(const VkComputePipelineCreateInfo&) { return 1; }
+
+template <typename T>
+const T* jPipelineCache::ChainCreationFeedbacks(uint32_t createInfoCount, const T* createInfos, std::vector<T>& outChainedInfos, jCreationFeedbacks& outFeedbacks) const
+{
+	if (!CreationFeedbackEnabled)
+		return createInfos;
+
+	uint32_t totalStageCount = 0;
+	for (uint32_t i = 0; i < createInfoCount; ++i)
+		totalStageCount += GetStageCount(createInfos[i]);
+
+	// 포인터를 넘기므로 먼저 크기를 잡아두고 채움
+	outChainedInfos.assign(createInfos, createInfos + createInfoCount);
+	outFeedbacks.CreateInfos.resize(createInfoCount);
+	outFeedbacks.Pipelines.resize(createInfoCount);
+	outFeedbacks.Stages.resize(totalStageCount);
+
+	uint32_t stageOffset = 0;
+	for (uint32_t i = 0; i < createInfoCount; ++i)
+	{
+		// 스테이지별 결과는 쓰지 않지만 확장 스펙상 stageCount 만큼 넘겨야 함
+		VkPipelineCreationFeedbackCreateInfoEXT& feedbackInfo = outFeedbacks.CreateInfos[i];
+		feedbackInfo = {};
+		feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+		feedbackInfo.pNext = outChainedInfos[i].pNext;
+		feedbackInfo.pPipelineCreationFeedback = &outFeedbacks.Pipelines[i];
+		feedbackInfo.pipelineStageCreationFeedbackCount = GetStageCount(createInfos[i]);
+		feedbackInfo.pPipelineStageCreationFeedbacks = outFeedbacks.Stages.data() + stageOffset;
+		stageOffset += feedbackInfo.pipelineStageCreationFeedbackCount;
+
+		outChainedInfos[i].pNext = &feedbackInfo;
+	}
+	return outChainedInfos.data();
+}
+
+VkResult jPipelineCache::CreateGraphicsPipelines(uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* createInfos, VkPipeline* outPipelines)
+{
+	JASSERT(Cache);
+
+	std::vector<VkGraphicsPipelineCreateInfo> chainedInfos;
+	jCreationFeedbacks feedbacks;
+	createInfos = ChainCreationFeedbacks(createInfoCount, createInfos, chainedInfos, feedbacks);
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	const VkResult result = vkCreateGraphicsPipelines(Device, Cache, createInfoCount, createInfos, nullptr, outPipelines);
+	const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	if (result == VK_SUCCESS)
+		AddCreateTime(createInfoCount, feedbacks, elapsedMs);
+	return result;
+}
+
+VkResult jPipelineCache::CreateComputePipelines(uint32_t createInfoCount, const VkComputePipelineCreateInfo* createInfos, VkPipeline* outPipelines)
+{
+	JASSERT(Cache);
+
+	std::vector<VkComputePipelineCreateInfo> chainedInfos;
+	jCreationFeedbacks feedbacks;
+	createInfos = ChainCreationFeedbacks(createInfoCount, createInfos, chainedInfos, feedbacks);
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+	const VkResult result = vkCreateComputePipelines(Device, Cache, createInfoCount, createInfos, nullptr, outPipelines);
+	const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	if (result == VK_SUCCESS)
+		AddCreateTime(createInfoCount, feedbacks, elapsedMs);
+	return result;
+}
+
+void jPipelineCache::AddCreateTime(uint32_t createInfoCount, const jCreationFeedbacks& feedbacks, double elapsedMs)
+{
+	std::lock_guard<std::mutex> lock(StatsMutex);
+	CreateCount += createInfoCount;
+	CreateTotalMs += elapsedMs;
+
+	for (const VkPipelineCreationFeedbackEXT& feedback : feedbacks.Pipelines)
+	{
+		if (!(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT))
+			continue;
+
+		const double durationMs = static_cast<double>(feedback.duration) / 1000000.0;		// ns
+		if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT)
+		{
+			++WarmCount;
+			WarmTotalMs += durationMs;
+		}
+		else
+		{
+			++ColdCount;
+			ColdTotalMs += durationMs;
+		}
+	}
+}
+
+bool jPipelineCache::IsCompatible(const char* data, size_t size) const
+{
+	jHeader header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+
+	return (header.HeaderSize >= sizeof(header))
+		&& (header.HeaderSize <= size)
+		&& (header.HeaderVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+		&& (header.VendorID == VendorID)
+		&& (header.DeviceID == DeviceID)
+		&& (memcmp(header.PipelineCacheUUID, PipelineCacheUUID, VK_UUID_SIZE) == 0);
+}
+
+size_t jPipelineCache::GetDataSize() const
+{
+	size_t size = 0;
+	if (vkGetPipelineCacheData(Device, Cache, &size, nullptr) != VK_SUCCESS)
+		return 0;
+	return size;
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+// 디스크에 저장되는 VkPipelineCache.
+// 시작할때 파일을 읽어서 헤더(vendorID, deviceID, pipelineCacheUUID) 가 현재 디바이스와 같으면 초기 데이터로 쓰고,
+// 다르거나 깨진 파일이면 빈 캐시로 시작함. 종료할때 Save 로 다시 저장하므로 다음 실행부터는 쉐이더 컴파일을 건너뛸 수 있음.
+//
+// 모든 파이프라인은 CreateGraphicsPipelines / CreateComputePipelines 를 통해 만들어야 같은 캐시를 공유하고 생성 시간이 집계됨.
+// VkPipelineCache 는 내부적으로 동기화되므로 여러 스레드에서 동시에 호출해도 됨.
+class jPipelineCache
+{
+public:
+	// useCreationFeedback : VK_EXT_pipeline_creation_feedback 를 켠 디바이스인 경우 true
+	bool Initialize(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& filename, bool useCreationFeedback);
+	void Release();
+
+	// 드라이버가 돌려주는 캐시 데이터를 그대로 파일에 씀. 쓰는 도중 종료되어도 이전 파일이 깨지지 않도록 임시 파일을 거침.
+	bool Save();
+
+	VkResult CreateGraphicsPipelines(uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* createInfos, VkPipeline* outPipelines);
+	VkResult CreateComputePipelines(uint32_t createInfoCount, const VkComputePipelineCreateInfo* createInfos, VkPipeline* outPipelines);
+
+	VkPipelineCache GetCache() const { return Cache; }
+	bool IsLoadedFromDisk() const { return LoadedSize > 0; }
+	size_t GetLoadedSize() const { return LoadedSize; }
+
+	// 전체 생성 수와 vkCreate*Pipelines 호출에 걸린 시간. 항상 집계됨.
+	uint32_t GetCreateCount() const { return CreateCount; }
+	double GetCreateTotalMs() const { return CreateTotalMs; }
+
+	// 드라이버가 VK_EXT_pipeline_creation_feedback 으로 알려준 결과로 파이프라인마다 캐시에서 찾은 것(Warm) 과
+	// 새로 컴파일된 것(Cold) 을 나눔. 시간도 드라이버가 알려준 파이프라인별 생성 시간임.
+	// 확장을 쓸 수 없거나 드라이버가 결과를 주지 않은 파이프라인은 어느 쪽에도 세지 않음.
+	bool IsCreationFeedbackEnabled() const { return CreationFeedbackEnabled; }
+	uint32_t GetColdCount() const { return ColdCount; }
+	uint32_t GetWarmCount() const { return WarmCount; }
+	double GetColdTotalMs() const { return ColdTotalMs; }
+	double GetWarmTotalMs() const { return WarmTotalMs; }
+
+private:
+	// vkGetPipelineCacheData 가 돌려주는 데이터의 맨 앞에 있는 헤더 (VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+	struct jHeader
+	{
+		uint32_t HeaderSize;
+		uint32_t HeaderVersion;
+		uint32_t VendorID;
+		uint32_t DeviceID;
+		uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+	};
+	// 파이프라인마다 pNext 에 연결하는 VkPipelineCreationFeedbackCreateInfoEXT 와 결과를 받을 곳
+	struct jCreationFeedbacks
+	{
+		std::vector<VkPipelineCreationFeedbackCreateInfoEXT> CreateInfos;
+		std::vector<VkPipelineCreationFeedbackEXT> Pipelines;
+		std::vector<VkPipelineCreationFeedbackEXT> Stages;
+	};
+	template <typename T>
+	const T* ChainCreationFeedbacks(uint32_t createInfoCount, const T* createInfos, std::vector<T>& outChainedInfos, jCreationFeedbacks& outFeedbacks) const;
+
+	bool IsCompatible(const char* data, size_t size) const;
+	size_t GetDataSize() const;
+	void AddCreateTime(uint32_t createInfoCount, const jCreationFeedbacks& feedbacks, double elapsedMs);
+
+	VkDevice Device = VK_NULL_HANDLE;
+	VkPipelineCache Cache = VK_NULL_HANDLE;
+	std::string Filename;
+	uint32_t VendorID = 0;
+	uint32_t DeviceID = 0;
+	uint8_t PipelineCacheUUID[VK_UUID_SIZE] = {};
+	size_t LoadedSize = 0;
+	bool CreationFeedbackEnabled = false;
+
+	std::mutex StatsMutex;
+	uint32_t CreateCount = 0;
+	double CreateTotalMs = 0.0;
+	uint32_t ColdCount = 0;
+	uint32_t WarmCount = 0;
+	double ColdTotalMs = 0.0;
+	double WarmTotalMs = 0.0;
+};
@@ -0,0 +1,543 @@
+﻿#include <pch.h>
+#include "jPipelineStateCache.h"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include "jAssert.h"
+#include "jPipelineCache.h"
+#include "jShaderCache.h"
+#include "jDeletionQueue.h"
+#include "Generic/TemplateUtility.h"
+
+bool jGraphicsPipelineDesc::operator == (const jGraphicsPipelineDesc& other) const
+{
+	if ((VertexShader != other.VertexShader) || (FragmentShader != other.FragmentShader) || (ShaderDefines != other.ShaderDefines)
+		|| (SpecializationConstants.size() != other.SpecializationConstants.size())
+		|| (VertexBindings.size() != other.VertexBindings.size()) || (VertexAttributes.size() != other.VertexAttributes.size()))
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < SpecializationConstants.size(); ++i)
+	{
+		const jSpecializationConstant& a = SpecializationConstants[i];
+		const jSpecializationConstant& b = other.SpecializationConstants[i];
+		if ((a.Stage != b.Stage) || (a.ConstantID != b.ConstantID) || (a.Value != b.Value))
+			return false;
+	}
+
+	for (size_t i = 0; i < VertexBindings.size(); ++i)
+	{
+		const VkVertexInputBindingDescription& a = VertexBindings[i];
+		const VkVertexInputBindingDescription& b = other.VertexBindings[i];
+		if ((a.binding != b.binding) || (a.stride != b.stride) || (a.inputRate != b.inputRate))
+			return false;
+	}
+
+	for (size_t i = 0; i < VertexAttributes.size(); ++i)
+	{
+		const VkVertexInputAttributeDescription& a = VertexAttributes[i];
+		const VkVertexInputAttributeDescription& b = other.VertexAttributes[i];
+		if ((a.location != b.location) || (a.binding != b.binding) || (a.format != b.format) || (a.offset != b.offset))
+			return false;
+	}
+
+	return (Topology == other.Topology) && (PolygonMode == other.PolygonMode) && (CullMode == other.CullMode) && (FrontFace == other.FrontFace)
+		&& (SampleCount == other.SampleCount) && (MinSampleShading == other.MinSampleShading)
+		&& (DepthTestEnable == other.DepthTestEnable) && (DepthWriteEnable == other.DepthWriteEnable) && (DepthCompareOp == other.DepthCompareOp)
+		&& (Blend.blendEnable == other.Blend.blendEnable)
+		&& (Blend.srcColorBlendFactor == other.Blend.srcColorBlendFactor) && (Blend.dstColorBlendFactor == other.Blend.dstColorBlendFactor)
+		&& (Blend.colorBlendOp == other.Blend.colorBlendOp)
+		&& (Blend.srcAlphaBlendFactor == other.Blend.srcAlphaBlendFactor) && (Blend.dstAlphaBlendFactor == other.Blend.dstAlphaBlendFactor)
+		&& (Blend.alphaBlendOp == other.Blend.alphaBlendOp) && (Blend.colorWriteMask == other.Blend.colorWriteMask)
+		&& (Layout == other.Layout) && (RenderPass == other.RenderPass) && (Subpass == other.Subpass);
+}
+
+size_t jGraphicsPipelineDesc::GetHash() const
+{
+	size_t hash = 0;
+	HashCombine(hash, VertexShader);
+	HashCombine(hash, FragmentShader);
+	for (const std::string& define : ShaderDefines)
+		HashCombine(hash, define);
+	for (const jSpecializationConstant& constant : SpecializationConstants)
+	{
+		HashCombine(hash, static_cast<int32_t>(constant.Stage));
+		HashCombine(hash, constant.ConstantID);
+		HashCombine(hash, constant.Value);
+	}
+	for (const VkVertexInputBindingDescription& binding : VertexBindings)
+	{
+		HashCombine(hash, binding.binding);
+		HashCombine(hash, binding.stride);
+		HashCombine(hash, static_cast<int32_t>(binding.inputRate));
+	}
+	for (const VkVertexInputAttributeDescription& attribute : VertexAttributes)
+	{
+		HashCombine(hash, attribute.location);
+		HashCombine(hash, attribute.binding);
+		HashCombine(hash, static_cast<int32_t>(attribute.format));
+		HashCombine(hash, attribute.offset);
+	}
+	HashCombine(hash, static_cast<int32_t>(Topology));
+	HashCombine(hash, static_cast<int32_t>(PolygonMode));
+	HashCombine(hash, CullMode);
+	HashCombine(hash, static_cast<int32_t>(FrontFace));
+	HashCombine(hash, static_cast<int32_t>(SampleCount));
+	HashCombine(hash, MinSampleShading);
+	HashCombine(hash, DepthTestEnable);
+	HashCombine(hash, DepthWriteEnable);
+	HashCombine(hash, static_cast<int32_t>(DepthCompareOp));
+	HashCombine(hash, Blend.blendEnable);
+	HashCombine(hash, static_cast<int32_t>(Blend.srcColorBlendFactor));
+	HashCombine(hash, static_cast<int32_t>(Blend.dstColorBlendFactor));
+	HashCombine(hash, static_cast<int32_t>(Blend.colorBlendOp));
+	HashCombine(hash, static_cast<int32_t>(Blend.srcAlphaBlendFactor));
+	HashCombine(hash, static_cast<int32_t>(Blend.dstAlphaBlendFactor));
+	HashCombine(hash, static_cast<int32_t>(Blend.alphaBlendOp));
+	HashCombine(hash, Blend.colorWriteMask);
+	HashCombine(hash, reinterpret_cast<uint64_t>(Layout));
+	HashCombine(hash, reinterpret_cast<uint64_t>(RenderPass));
+	HashCombine(hash, Subpass);
+	return hash;
+}
+
+bool jPipelineStateCache::Initialize(VkDevice device, jPipelineCache& pipelineCache, jShaderCache& shaderCache, uint32_t workerCount)
+{
+	JASSERT(Workers.empty() && Entries.empty());
+
+	Device = device;
+	PipelineCache = &pipelineCache;
+	ShaderCache = &shaderCache;
+
+	ExitRequested = false;
+	Workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; ++i)
+		Workers.emplace_back(&jPipelineStateCache::WorkerMain, this);
+	return true;
+}
+
+void jPipelineStateCache::Release()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Jobs.clear();
+		ExitRequested = true;
+	}
+	WorkCondition.notify_all();
+
+	for (std::thread& worker : Workers)
+		worker.join();
+	Workers.clear();
+
+	// 워커가 끝나기 전에 완료한 것들도 지워야 함
+	ApplyResults();
+	for (jEntry& entry : Entries)
+	{
+		if (entry.Pipeline)
+			vkDestroyPipeline(Device, entry.Pipeline, nullptr);
+	}
+	for (VkPipeline pipeline : RetiredPipelines)
+		vkDestroyPipeline(Device, pipeline, nullptr);
+	RetiredPipelines.clear();
+	Entries.clear();
+	Handles.clear();
+}
+
+jPipelineHandle jPipelineStateCache::Request(const jGraphicsPipelineDesc& desc, jPipelineHandle fallback)
+{
+	auto it = Handles.find(desc);
+	if (it != Handles.end())
+	{
+		++HitCount;
+		return it->second;
+	}
+	++MissCount;
+
+	// 워커가 없으면 백그라운드 컴파일을 할 수 없으므로 바로 만듬
+	if (Workers.empty())
+	{
+		const jPipelineHandle handle = static_cast<jPipelineHandle>(Entries.size());
+		jEntry entry;
+		entry.Pipeline = Compile(desc);
+		entry.Fallback = fallback;
+		Entries.push_back(entry);
+		Handles.insert(std::make_pair(desc, handle));
+		return handle;
+	}
+
+	const jPipelineHandle handle = static_cast<jPipelineHandle>(Entries.size());
+	jEntry entry;
+	entry.Fallback = fallback;
+	entry.Pending = true;
+	Entries.push_back(entry);
+	Handles.insert(std::make_pair(desc, handle));
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		jCompileJob job;
+		job.Handle = handle;
+		job.Desc = desc;
+		Jobs.push_back(std::move(job));
+	}
+	WorkCondition.notify_one();
+	return handle;
+}
+
+jPipelineHandle jPipelineStateCache::RequestImmediate(const jGraphicsPipelineDesc& desc)
+{
+	auto it = Handles.find(desc);
+	if (it != Handles.end())
+	{
+		// 이미 백그라운드에서 컴파일 중이면 끝날때까지 기다림
+		if (Entries[it->second].Pending)
+		{
+			WaitIdle();
+			ApplyResults();
+		}
+
+		++HitCount;
+		return Entries[it->second].Pipeline ? it->second : INVALID_PIPELINE_HANDLE;
+	}
+	++MissCount;
+
+	const VkPipeline pipeline = Compile(desc);
+	if (!pipeline)
+		return INVALID_PIPELINE_HANDLE;
+
+	const jPipelineHandle handle = static_cast<jPipelineHandle>(Entries.size());
+	jEntry entry;
+	entry.Pipeline = pipeline;
+	Entries.push_back(entry);
+	Handles.insert(std::make_pair(desc, handle));
+	return handle;
+}
+
+void jPipelineStateCache::Update(jDeletionQueue& deletionQueue, uint64_t lastUsedValue)
+{
+	ApplyResults();
+
+	// 이전 파이프라인은 이미 제출된 커맨드 버퍼에서 쓰고 있을 수 있음. 이번 프레임부터는 새 파이프라인으로 기록됨.
+	for (VkPipeline pipeline : RetiredPipelines)
+		deletionQueue.PushPipeline(lastUsedValue, pipeline);
+	RetiredPipelines.clear();
+
+	// 소스가 바뀌어서 대체된 쉐이더 모듈은 그 모듈로 컴파일 중인 워커가 없을 때만 넘길 수 있음.
+	// 잠근 동안에는 워커가 새 작업을 시작하지 않으므로 확인한 뒤에 이전 모듈을 가져가는 워커가 생기지 않음.
+	std::lock_guard<std::mutex> lock(Mutex);
+	if (ActiveJobCount == 0)
+		ShaderCache->RetireOutdatedModules(deletionQueue, lastUsedValue);
+}
+
+uint32_t jPipelineStateCache::Reload(const std::string& shaderPath)
+{
+	std::vector<jCompileJob> jobs;
+	for (auto& it : Handles)
+	{
+		const jGraphicsPipelineDesc& desc = it.first;
+		if ((desc.VertexShader != shaderPath) && (desc.FragmentShader != shaderPath))
+			continue;
+
+		jCompileJob job;
+		job.Handle = it.second;
+		job.Version = ++Entries[it.second].Version;
+		job.Desc = desc;
+		jobs.push_back(std::move(job));
+	}
+
+	const uint32_t jobCount = static_cast<uint32_t>(jobs.size());
+	ReloadCount += jobCount;
+	if (jobCount == 0)
+		return 0;
+
+	if (Workers.empty())
+	{
+		for (const jCompileJob& job : jobs)
+		{
+			jCompileResult result;
+			result.Handle = job.Handle;
+			result.Version = job.Version;
+			result.Pipeline = Compile(job.Desc);
+			ApplyResult(result);
+		}
+		return jobCount;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		for (jCompileJob& job : jobs)
+			Jobs.push_back(std::move(job));
+	}
+	WorkCondition.notify_all();
+	return jobCount;
+}
+
+void jPipelineStateCache::ApplyResults()
+{
+	std::vector<jCompileResult> results;
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		results.swap(Results);
+	}
+
+	for (const jCompileResult& result : results)
+	{
+		ApplyResult(result);
+
+		++AsyncCompileCount;
+		AsyncCompileTotalMs += result.ElapsedMs;
+	}
+}
+
+void jPipelineStateCache::ApplyResult(const jCompileResult& result)
+{
+	JASSERT(result.Handle < Entries.size());
+	jEntry& entry = Entries[result.Handle];
+	if (result.Version == 0)
+		entry.Pending = false;
+
+	if (!result.Pipeline)
+	{
+		// 처음 컴파일이 실패한 경우는 계속 Fallback 으로 그림.
+		// Reload 는 쉐이더를 고치는 중이라 실패할 수 있으므로 이전 파이프라인을 계속 쓰고, 오류는 Shader cache 가 출력함.
+		if (result.Version == 0)
+			ensure(result.Pipeline);
+		else
+			std::cout << "Pipeline reload failed, keeps the previous pipeline" << std::endl;
+		return;
+	}
+
+	// 더 새로운 버전이 이미 반영되었으면 이 결과는 버림
+	if (entry.Pipeline && (result.Version < entry.AppliedVersion))
+	{
+		RetiredPipelines.push_back(result.Pipeline);
+		return;
+	}
+
+	if (entry.Pipeline)
+		RetiredPipelines.push_back(entry.Pipeline);
+	entry.Pipeline = result.Pipeline;
+	entry.AppliedVersion = result.Version;
+}
+
+VkPipeline jPipelineStateCache::GetPipeline(jPipelineHandle handle) const
+{
+	// Fallback 도 아직 준비되지 않았을 수 있으므로 준비된 것이 나올때까지 따라감
+	while (handle < Entries.size())
+	{
+		const jEntry& entry = Entries[handle];
+		if (entry.Pipeline)
+			return entry.Pipeline;
+		handle = entry.Fallback;
+	}
+	return VK_NULL_HANDLE;
+}
+
+void jPipelineStateCache::Clear(jDeletionQueue& deletionQueue, uint64_t lastUsedValue)
+{
+	// 예전 RenderPass 나 Layout 으로 컴파일 중인 것이 있을 수 있으므로 모두 끝난 뒤에 넘겨야 함
+	WaitIdle();
+	ApplyResults();
+
+	for (jEntry& entry : Entries)
+	{
+		if (entry.Pipeline)
+			deletionQueue.PushPipeline(lastUsedValue, entry.Pipeline);
+	}
+	for (VkPipeline pipeline : RetiredPipelines)
+		deletionQueue.PushPipeline(lastUsedValue, pipeline);
+	RetiredPipelines.clear();
+	Entries.clear();
+	Handles.clear();
+}
+
+VkPipeline jPipelineStateCache::Compile(const jGraphicsPipelineDesc& desc) const
+{
+	// 1. Create Shader
+	// 모듈은 Shader cache 가 소유하고 같은 소스를 쓰는 파이프라인끼리 공유하므로 여기서 지우지 않음
+	VkShaderModule vertShaderModule = ShaderCache->GetShaderModule(desc.VertexShader, desc.ShaderDefines);
+	VkShaderModule fragShaderModule = ShaderCache->GetShaderModule(desc.FragmentShader, desc.ShaderDefines);
+	if (!vertShaderModule || !fragShaderModule)
+		return VK_NULL_HANDLE;
+
+	// pSpecializationInfo 을 통해 쉐이더에서 사용하는 상수값을 설정해줄 수 있음. 이 상수 값에 따라 if 분기문에 없어지거나 하는 최적화가 일어날 수 있음.
+	// 상수는 모두 4바이트이므로 스테이지별로 Value 를 모아서 offset 을 4 씩 증가시킴.
+	VkShaderStageFlagBits stages[] = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT };
+	std::vector<VkSpecializationMapEntry> mapEntries[2];
+	std::vector<uint32_t> specializationData[2];
+	VkSpecializationInfo specializationInfos[2] = {};
+	for (int32_t i = 0; i < 2; ++i)
+	{
+		for (const jSpecializationConstant& constant : desc.SpecializationConstants)
+		{
+			if (constant.Stage != stages[i])
+				continue;
+
+			VkSpecializationMapEntry mapEntry = {};
+			mapEntry.constantID = constant.ConstantID;
+			mapEntry.offset = static_cast<uint32_t>(specializationData[i].size() * sizeof(uint32_t));
+			mapEntry.size = sizeof(uint32_t);
+			mapEntries[i].push_back(mapEntry);
+			specializationData[i].push_back(constant.Value);
+		}
+		specializationInfos[i].mapEntryCount = static_cast<uint32_t>(mapEntries[i].size());
+		specializationInfos[i].pMapEntries = mapEntries[i].data();
+		specializationInfos[i].dataSize = specializationData[i].size() * sizeof(uint32_t);
+		specializationInfos[i].pData = specializationData[i].data();
+	}
+
+	VkPipelineShaderStageCreateInfo shaderStage[2] = {};
+	const VkShaderModule shaderModules[] = { vertShaderModule, fragShaderModule };
+	for (int32_t i = 0; i < 2; ++i)
+	{
+		shaderStage[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStage[i].stage = stages[i];
+		shaderStage[i].module = shaderModules[i];
+		shaderStage[i].pName = "main";
+		shaderStage[i].pSpecializationInfo = mapEntries[i].empty() ? nullptr : &specializationInfos[i];
+	}
+
+	// 2. Vertex Input
+	// 1). Bindings : 데이터 사이의 간격과 버택스당 or 인스턴스당(인스턴싱 사용시) 데이터인지 여부
+	// 2). Attribute descriptions : 버택스 쉐이더 전달되는 attributes 의 타입. 그것을 로드할 바인딩과 오프셋
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(desc.VertexBindings.size());
+	vertexInputInfo.pVertexBindingDescriptions = desc.VertexBindings.data();
+	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(desc.VertexAttributes.size());
+	vertexInputInfo.pVertexAttributeDescriptions = desc.VertexAttributes.data();
+
+	// 3. Input Assembly
+	// primitiveRestartEnable 옵션이 VK_TRUE 이면, 인덱스버퍼의 특수한 index 0xFFFF or 0xFFFFFFFF 를 사용해서 line 과 triangle topology mode를 사용할 수 있다.
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = desc.Topology;
+	inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+	// 4. Viewports and scissors
+	// Viewport 와 Scissor 는 Dynamic state 로 커맨드 버퍼에 기록하므로 여기서는 개수만 정함.
+	// 파이프라인에 스왑체인 크기가 들어가지 않으므로 창 크기가 바뀌어도 파이프라인을 다시 만들 필요가 없음.
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.pViewports = nullptr;			// Dynamic state 라 무시됨
+	viewportState.scissorCount = 1;
+	viewportState.pScissors = nullptr;			// Dynamic state 라 무시됨
+
+	// 5. Rasterizer
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.depthClampEnable = VK_FALSE;		// 이 값이 VK_TRUE 면 Near나 Far을 벗어나는 영역을 [0.0 ~ 1.0]으로 Clamp 시켜줌.(쉐도우맵에서 유용)
+	rasterizer.rasterizerDiscardEnable = VK_FALSE;	// 이 값이 VK_TRUE 면, 레스터라이저 스테이지를 통과할 수 없음. 즉 Framebuffer 로 결과가 넘어가지 않음.
+	rasterizer.polygonMode = desc.PolygonMode;		// FILL, LINE, POINT 세가지가 있음. FILL 이외에는 fillModeNonSolid 기능이 필요함
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = desc.CullMode;
+	rasterizer.frontFace = desc.FrontFace;
+	rasterizer.depthBiasEnable = VK_FALSE;			// 쉐도우맵 용
+
+	// 6. Multisampling
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.rasterizationSamples = desc.SampleCount;
+	multisampling.sampleShadingEnable = (desc.MinSampleShading > 0.0f) ? VK_TRUE : VK_FALSE;	// 텍스쳐 내부에 있는 aliasing 도 완화 해줌
+	multisampling.minSampleShading = desc.MinSampleShading;
+
+	// 7. Depth and stencil testing
+	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = desc.DepthTestEnable;
+	depthStencil.depthWriteEnable = desc.DepthWriteEnable;
+	depthStencil.depthCompareOp = desc.DepthCompareOp;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.minDepthBounds = 0.0f;		// Optional
+	depthStencil.maxDepthBounds = 1.0f;		// Optional
+
+	// 8. Color blending
+	// 2가지 방식의 blending 이 있음
+	// 1). 기존과 새로운 값을 섞어서 최종색을 만들어낸다. (desc.Blend)
+	//		finalColor.rgb = (srcColorBlendFactor * newColor.rgb) <colorBlendOp> (dstColorBlendFactor * oldColor.rgb);
+	//		finalColor.a = (srcAlphaBlendFactor * newColor.a) <alphaBlendOp> (dstAlphaBlendFactor * oldColor.a);
+	//		일반적인 알파 블랜드는 SRC_ALPHA, ONE_MINUS_SRC_ALPHA, ADD 로 설정하면 됨.
+	// 2). 기존과 새로운 값을 비트 연산으로 결합한다.
+	//		모든 framebuffer에 사용하는 blendEnable을 VK_FALSE로 했다면 자동으로 logicOpEnable은 꺼진다.
+	VkPipelineColorBlendStateCreateInfo colorBlending = {};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlending.logicOpEnable = VK_FALSE;
+	colorBlending.logicOp = VK_LOGIC_OP_COPY;		// Optional
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &desc.Blend;
+
+	// 9. Dynamic state
+	// 이경우 Pipeline에 설정된 값은 무시되고, 매 렌더링시에 새로 설정해줘야 함.
+	const VkDynamicState dynamicStates[] = {
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = static_cast<uint32_t>(std::size(dynamicStates));
+	dynamicState.pDynamicStates = dynamicStates;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = shaderStage;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.pDynamicState = &dynamicState;
+	pipelineInfo.layout = desc.Layout;
+	pipelineInfo.renderPass = desc.RenderPass;
+	pipelineInfo.subpass = desc.Subpass;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
+
+	// VkPipelineCache 는 내부적으로 동기화되므로 여러 워커에서 동시에 생성해도 됨
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	if (PipelineCache->CreateGraphicsPipelines(1, &pipelineInfo, &pipeline) != VK_SUCCESS)
+		pipeline = VK_NULL_HANDLE;
+	return pipeline;
+}
+
+void jPipelineStateCache::WorkerMain()
+{
+	while (true)
+	{
+		jCompileJob job;
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			WorkCondition.wait(lock, [this]() { return ExitRequested || !Jobs.empty(); });
+			if (ExitRequested)
+				return;
+
+			job = std::move(Jobs.front());
+			Jobs.pop_front();
+			++ActiveJobCount;
+		}
+
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		jCompileResult result;
+		result.Handle = job.Handle;
+		result.Version = job.Version;
+		result.Pipeline = Compile(job.Desc);
+		result.ElapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Results.push_back(result);
+			--ActiveJobCount;
+		}
+		DoneCondition.notify_all();
+	}
+}
+
+void jPipelineStateCache::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	DoneCondition.wait(lock, [this]() { return Jobs.empty() && (ActiveJobCount == 0); });
+}
@@ -0,0 +1,177 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+
+class jPipelineCache;
+class jShaderCache;
+class jDeletionQueue;
+
+// 쉐이더의 Specialization constant 하나. 값은 모두 4바이트(int, uint, float, bool) 로 넘김.
+struct jSpecializationConstant
+{
+	VkShaderStageFlagBits Stage = VK_SHADER_STAGE_VERTEX_BIT;
+	uint32_t ConstantID = 0;
+	uint32_t Value = 0;
+};
+
+// 그래픽스 파이프라인 하나를 만드는데 필요한 모든 상태. 같은 Desc 는 같은 파이프라인을 공유함.
+// 쉐이더는 GLSL 소스 경로와 defines 로 구분하며, Viewport 와 Scissor 는 항상 Dynamic state 라서 들어있지 않음.
+// 소스 내용이 바뀐 것은 Desc 로 구분되지 않으므로 소스를 고친 뒤에는 Reload 로 파이프라인을 다시 만들어야 함.
+struct jGraphicsPipelineDesc
+{
+	std::string VertexShader;
+	std::string FragmentShader;
+	std::vector<std::string> ShaderDefines;			// 두 스테이지 모두에 적용됨. "NAME" 또는 "NAME=VALUE"
+	std::vector<jSpecializationConstant> SpecializationConstants;
+
+	std::vector<VkVertexInputBindingDescription> VertexBindings;
+	std::vector<VkVertexInputAttributeDescription> VertexAttributes;
+	VkPrimitiveTopology Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	VkPolygonMode PolygonMode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags CullMode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	VkSampleCountFlagBits SampleCount = VK_SAMPLE_COUNT_1_BIT;
+	float MinSampleShading = 0.0f;			// 0 이면 Sample shading 사용안함
+
+	VkBool32 DepthTestEnable = VK_TRUE;
+	VkBool32 DepthWriteEnable = VK_TRUE;
+	VkCompareOp DepthCompareOp = VK_COMPARE_OP_LESS;
+
+	VkPipelineColorBlendAttachmentState Blend = { VK_FALSE, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD
+		, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD
+		, VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT };
+
+	VkPipelineLayout Layout = VK_NULL_HANDLE;
+	VkRenderPass RenderPass = VK_NULL_HANDLE;
+	uint32_t Subpass = 0;
+
+	bool operator == (const jGraphicsPipelineDesc& other) const;
+	size_t GetHash() const;
+};
+
+using jPipelineHandle = uint32_t;
+static constexpr jPipelineHandle INVALID_PIPELINE_HANDLE = UINT32_MAX;
+
+// jGraphicsPipelineDesc 별로 파이프라인을 하나만 만들어서 공유하는 캐시.
+// 처음 요청된 Desc 는 백그라운드 스레드에서 컴파일하고, 끝날때까지는 요청할때 넘긴 Fallback 파이프라인으로 그리므로
+// 새로운 머터리얼(파이프라인 조합) 이 처음 쓰이는 프레임에도 쉐이더 컴파일로 멈추지 않음.
+//
+// - 쉐이더 소스가 바뀌면 Reload 로 그 소스를 쓰는 파이프라인만 백그라운드에서 다시 만들고, 끝나면 Update 에서 같은 핸들로 교체함.
+//   교체된 이전 파이프라인은 삭제 큐로 넘기므로 디바이스를 기다리지 않음.
+// - Request, Reload, Update, Clear 는 메인 스레드에서만 호출해야 함.
+// - GetPipeline 은 커맨드 기록 중에 여러 스레드에서 호출해도 되지만 Request, Update 와 동시에 호출하면 안됨.
+// - 파이프라인은 캐시가 소유하므로 사용하는 쪽에서 vkDestroyPipeline 을 호출하면 안됨.
+class jPipelineStateCache
+{
+public:
+	~jPipelineStateCache() { Release(); }
+
+	bool Initialize(VkDevice device, jPipelineCache& pipelineCache, jShaderCache& shaderCache, uint32_t workerCount);
+
+	// 진행중인 컴파일을 기다린 뒤 모든 파이프라인을 바로 지움. GPU 작업이 모두 끝난 뒤에 호출해야 함.
+	void Release();
+
+	// 같은 Desc 가 이미 있으면 그 핸들을 돌려주고, 없으면 백그라운드 컴파일을 예약함.
+	// fallback : 컴파일이 끝나기 전(또는 실패한 경우) 에 대신 쓸 파이프라인. 보통 RequestImmediate 로 만든 것.
+	jPipelineHandle Request(const jGraphicsPipelineDesc& desc, jPipelineHandle fallback);
+
+	// 바로 컴파일해서 끝날때까지 기다림. Fallback 처럼 처음부터 반드시 있어야 하는 파이프라인에 사용. 실패하면 INVALID_PIPELINE_HANDLE.
+	jPipelineHandle RequestImmediate(const jGraphicsPipelineDesc& desc);
+
+	// 백그라운드에서 끝난 파이프라인들을 반영함. 프레임마다 커맨드 기록 전에 호출.
+	// Reload 로 교체된 이전 파이프라인과 소스가 바뀌어서 더 이상 쓰지 않는 쉐이더 모듈은 lastUsedValue 가 끝나면 지워지도록 삭제 큐로 넘김.
+	void Update(jDeletionQueue& deletionQueue, uint64_t lastUsedValue);
+
+	// shaderPath(Desc 에 넣은 경로 그대로) 를 쓰는 파이프라인들을 백그라운드에서 다시 컴파일함. 다시 만들 파이프라인 수를 돌려줌.
+	// 끝날때까지는 이전 파이프라인으로 그리고, 컴파일에 실패하면 이전 파이프라인을 계속 씀.
+	uint32_t Reload(const std::string& shaderPath);
+
+	// 컴파일이 끝나지 않았으면 Fallback 의 파이프라인을 돌려줌
+	VkPipeline GetPipeline(jPipelineHandle handle) const;
+	bool IsReady(jPipelineHandle handle) const { return (handle < Entries.size()) && Entries[handle].Pipeline; }
+
+	// 모든 파이프라인을 삭제 큐로 넘기고 비움 (ex. RenderPass 가 바뀐 경우). 이전에 받은 핸들은 모두 무효가 됨.
+	void Clear(jDeletionQueue& deletionQueue, uint64_t lastUsedValue);
+
+	size_t GetPipelineCount() const { return Entries.size(); }
+	uint64_t GetHitCount() const { return HitCount; }
+	uint64_t GetMissCount() const { return MissCount; }
+	uint32_t GetAsyncCompileCount() const { return AsyncCompileCount; }
+	double GetAsyncCompileTotalMs() const { return AsyncCompileTotalMs; }
+	uint32_t GetReloadCount() const { return ReloadCount; }
+
+private:
+	struct jGraphicsPipelineDescHasher
+	{
+		size_t operator()(const jGraphicsPipelineDesc& desc) const { return desc.GetHash(); }
+	};
+
+	struct jEntry
+	{
+		VkPipeline Pipeline = VK_NULL_HANDLE;
+		jPipelineHandle Fallback = INVALID_PIPELINE_HANDLE;
+		bool Pending = false;
+
+		// Reload 할때마다 Version 이 올라감. 워커가 여러개면 결과가 순서대로 오지 않으므로 이전 버전의 결과가 새 것을 덮지 않도록 함.
+		uint32_t Version = 0;
+		uint32_t AppliedVersion = 0;
+	};
+
+	struct jCompileJob
+	{
+		jPipelineHandle Handle = INVALID_PIPELINE_HANDLE;
+		uint32_t Version = 0;
+		jGraphicsPipelineDesc Desc;
+	};
+
+	struct jCompileResult
+	{
+		jPipelineHandle Handle = INVALID_PIPELINE_HANDLE;
+		uint32_t Version = 0;
+		VkPipeline Pipeline = VK_NULL_HANDLE;
+		double ElapsedMs = 0.0;
+	};
+
+	VkPipeline Compile(const jGraphicsPipelineDesc& desc) const;
+	void ApplyResult(const jCompileResult& result);
+	void ApplyResults();
+	void WorkerMain();
+	void WaitIdle();
+
+	VkDevice Device = VK_NULL_HANDLE;
+	jPipelineCache* PipelineCache = nullptr;
+	jShaderCache* ShaderCache = nullptr;
+
+	std::unordered_map<jGraphicsPipelineDesc, jPipelineHandle, jGraphicsPipelineDescHasher> Handles;
+	std::vector<jEntry> Entries;
+	uint64_t HitCount = 0;
+	uint64_t MissCount = 0;
+	uint32_t AsyncCompileCount = 0;
+	double AsyncCompileTotalMs = 0.0;
+	uint32_t ReloadCount = 0;
+
+	// 교체되어 다음 Update 에서 삭제 큐로 넘길 파이프라인들
+	std::vector<VkPipeline> RetiredPipelines;
+
+	std::vector<std::thread> Workers;
+	std::mutex Mutex;
+	std::condition_variable WorkCondition;
+	std::condition_variable DoneCondition;
+
+	// 아래는 Mutex 로 보호됨
+	std::deque<jCompileJob> Jobs;
+	std::vector<jCompileResult> Results;
+	uint32_t ActiveJobCount = 0;
+	bool ExitRequested = false;
+};
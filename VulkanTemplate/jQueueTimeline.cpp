@@ -0,0 +1,109 @@
+﻿#include <pch.h>
+#include "jQueueTimeline.h"
+
+#include "jAssert.h"
+
+bool jQueueTimeline::Initialize(VkDevice device, VkQueue queue)
+{
+	Device = device;
+	Queue = queue;
+	LastSubmittedValue = 0;
+	CompletedValue = 0;
+
+	VkSemaphoreTypeCreateInfo typeInfo = {};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &typeInfo;
+	return ensure(vkCreateSemaphore(Device, &semaphoreInfo, nullptr, &Semaphore) == VK_SUCCESS);
+}
+
+void jQueueTimeline::Release()
+{
+	if (!Semaphore)
+		return;
+
+	WaitIdle();
+	vkDestroySemaphore(Device, Semaphore, nullptr);
+	Semaphore = VK_NULL_HANDLE;
+}
+
+uint64_t jQueueTimeline::Submit(const jQueueSubmitInfo& submitInfo)
+{
+	WaitSemaphores.clear();
+	WaitValues.clear();
+	WaitStages.clear();
+	for (uint32_t i = 0; i < submitInfo.WaitCount; ++i)
+	{
+		WaitSemaphores.push_back(submitInfo.Waits[i].Semaphore);
+		WaitValues.push_back(submitInfo.Waits[i].Value);
+		WaitStages.push_back(submitInfo.Waits[i].Stage);
+	}
+
+	const uint64_t signalValue = LastSubmittedValue + 1;
+	SignalSemaphores.clear();
+	SignalValues.clear();
+	SignalSemaphores.push_back(Semaphore);
+	SignalValues.push_back(signalValue);
+	for (uint32_t i = 0; i < submitInfo.BinarySignalCount; ++i)
+	{
+		SignalSemaphores.push_back(submitInfo.BinarySignals[i]);
+		SignalValues.push_back(0);
+	}
+
+	// 바이너리 세마포어와 섞여 있어도 되며, 바이너리 세마포어의 값은 무시됨
+	VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(WaitValues.size());
+	timelineInfo.pWaitSemaphoreValues = WaitValues.data();
+	timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(SignalValues.size());
+	timelineInfo.pSignalSemaphoreValues = SignalValues.data();
+
+	VkSubmitInfo vkSubmitInfo = {};
+	vkSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	vkSubmitInfo.pNext = &timelineInfo;
+	vkSubmitInfo.waitSemaphoreCount = static_cast<uint32_t>(WaitSemaphores.size());
+	vkSubmitInfo.pWaitSemaphores = WaitSemaphores.data();
+	vkSubmitInfo.pWaitDstStageMask = WaitStages.data();
+	vkSubmitInfo.commandBufferCount = submitInfo.CommandBufferCount;
+	vkSubmitInfo.pCommandBuffers = submitInfo.CommandBuffers;
+	vkSubmitInfo.signalSemaphoreCount = static_cast<uint32_t>(SignalSemaphores.size());
+	vkSubmitInfo.pSignalSemaphores = SignalSemaphores.data();
+
+	if (!ensure(vkQueueSubmit(Queue, 1, &vkSubmitInfo, VK_NULL_HANDLE) == VK_SUCCESS))
+		return 0;
+
+	LastSubmittedValue = signalValue;
+	return signalValue;
+}
+
+uint64_t jQueueTimeline::GetCompletedValue()
+{
+	uint64_t value = 0;
+	if (vkGetSemaphoreCounterValue(Device, Semaphore, &value) == VK_SUCCESS)
+		CompletedValue = value;
+	return CompletedValue;
+}
+
+bool jQueueTimeline::Wait(uint64_t value, uint64_t timeoutNs)
+{
+	if (value <= CompletedValue)
+		return true;
+
+	// 아직 제출하지 않은 값을 기다리면 영원히 끝나지 않음
+	JASSERT(value <= LastSubmittedValue);
+
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &Semaphore;
+	waitInfo.pValues = &value;
+	if (vkWaitSemaphores(Device, &waitInfo, timeoutNs) != VK_SUCCESS)
+		return false;
+
+	CompletedValue = value;
+	return true;
+}
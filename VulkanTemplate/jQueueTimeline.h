@@ -0,0 +1,63 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+
+// Submit 에서 기다릴 세마포어. 바이너리 세마포어(ex. vkAcquireNextImageKHR 용) 는 Value 가 무시됨.
+struct jSemaphoreWait
+{
+	VkSemaphore Semaphore = VK_NULL_HANDLE;
+	uint64_t Value = 0;
+	VkPipelineStageFlags Stage = 0;
+};
+
+struct jQueueSubmitInfo
+{
+	const VkCommandBuffer* CommandBuffers = nullptr;
+	uint32_t CommandBufferCount = 0;
+	const jSemaphoreWait* Waits = nullptr;
+	uint32_t WaitCount = 0;
+	const VkSemaphore* BinarySignals = nullptr;		// Present 처럼 Timeline semaphore 를 쓸 수 없는 곳에 넘길 세마포어
+	uint32_t BinarySignalCount = 0;
+};
+
+// Queue 하나에 대한 Timeline semaphore (Vulkan 1.2).
+// 제출할때마다 값을 1씩 증가시켜 Signal 하므로, 제출 값 하나로 그 제출과 이전 제출들이 GPU 에서 끝났는지 알 수 있음.
+// 프레임, 업로드, 리소스 삭제가 모두 이 값을 기준으로 기다리거나 재사용 시점을 정하므로 펜스를 따로 관리하지 않아도 됨.
+// 같은 Queue 에 제출하는 것은 모두 이 클래스를 거쳐야 값의 순서가 제출 순서와 일치함.
+class jQueueTimeline
+{
+public:
+	bool Initialize(VkDevice device, VkQueue queue);
+	void Release();
+
+	// 제출이 성공하면 이 제출이 Signal 할 값을 돌려줌. 실패하면 0.
+	uint64_t Submit(const jQueueSubmitInfo& submitInfo);
+
+	// 완료된 가장 큰 값을 GPU 에서 읽어옴
+	uint64_t GetCompletedValue();
+	uint64_t GetLastSubmittedValue() const { return LastSubmittedValue; }
+
+	bool IsComplete(uint64_t value) { return (value <= CompletedValue) || (value <= GetCompletedValue()); }
+	bool Wait(uint64_t value, uint64_t timeoutNs = UINT64_MAX);
+	bool WaitIdle() { return Wait(LastSubmittedValue); }
+
+	VkQueue GetQueue() const { return Queue; }
+	VkSemaphore GetSemaphore() const { return Semaphore; }
+
+private:
+	VkDevice Device = VK_NULL_HANDLE;
+	VkQueue Queue = VK_NULL_HANDLE;
+	VkSemaphore Semaphore = VK_NULL_HANDLE;
+
+	uint64_t LastSubmittedValue = 0;
+	uint64_t CompletedValue = 0;
+
+	// 제출마다 할당하지 않도록 재사용하는 배열들
+	std::vector<VkSemaphore> WaitSemaphores;
+	std::vector<uint64_t> WaitValues;
+	std::vector<VkPipelineStageFlags> WaitStages;
+	std::vector<VkSemaphore> SignalSemaphores;
+	std::vector<uint64_t> SignalValues;
+};
@@ -0,0 +1,88 @@
+﻿#include <pch.h>
+#include "jSamplerCache.h"
+
+#include <algorithm>
+#include "jAssert.h"
+#include "Generic/TemplateUtility.h"
+
+bool jSamplerStateDesc::operator == (const jSamplerStateDesc& other) const
+{
+	return (MagFilter == other.MagFilter) && (MinFilter == other.MinFilter) && (MipmapMode == other.MipmapMode)
+		&& (AddressModeU == other.AddressModeU) && (AddressModeV == other.AddressModeV) && (AddressModeW == other.AddressModeW)
+		&& (MipLodBias == other.MipLodBias) && (MinLod == other.MinLod) && (MaxLod == other.MaxLod)
+		&& (MaxAnisotropy == other.MaxAnisotropy) && (CompareEnable == other.CompareEnable) && (CompareOp == other.CompareOp)
+		&& (BorderColor == other.BorderColor) && (UnnormalizedCoordinates == other.UnnormalizedCoordinates);
+}
+
+size_t jSamplerStateDesc::GetHash() const
+{
+	size_t hash = 0;
+	HashCombine(hash, static_cast<int32_t>(MagFilter));
+	HashCombine(hash, static_cast<int32_t>(MinFilter));
+	HashCombine(hash, static_cast<int32_t>(MipmapMode));
+	HashCombine(hash, static_cast<int32_t>(AddressModeU));
+	HashCombine(hash, static_cast<int32_t>(AddressModeV));
+	HashCombine(hash, static_cast<int32_t>(AddressModeW));
+	HashCombine(hash, MipLodBias);
+	HashCombine(hash, MinLod);
+	HashCombine(hash, MaxLod);
+	HashCombine(hash, MaxAnisotropy);
+	HashCombine(hash, CompareEnable);
+	HashCombine(hash, static_cast<int32_t>(CompareOp));
+	HashCombine(hash, static_cast<int32_t>(BorderColor));
+	HashCombine(hash, UnnormalizedCoordinates);
+	return hash;
+}
+
+void jSamplerCache::Initialize(VkDevice device, float maxSupportedAnisotropy)
+{
+	Device = device;
+	MaxSupportedAnisotropy = maxSupportedAnisotropy;
+}
+
+void jSamplerCache::Release()
+{
+	for (auto& it : Samplers)
+		vkDestroySampler(Device, it.second, nullptr);
+	Samplers.clear();
+}
+
+VkSampler jSamplerCache::GetSampler(const jSamplerStateDesc& desc)
+{
+	// 디바이스가 지원하는 범위로 먼저 맞춘 뒤 찾아야 결과적으로 같은 Sampler 가 중복되어 만들어지지 않음.
+	jSamplerStateDesc key = desc;
+	key.MaxAnisotropy = (key.MaxAnisotropy > 1.0f) ? std::min(key.MaxAnisotropy, MaxSupportedAnisotropy) : 0.0f;
+
+	auto it = Samplers.find(key);
+	if (it != Samplers.end())
+	{
+		++HitCount;
+		return it->second;
+	}
+	++MissCount;
+
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = key.MagFilter;
+	samplerInfo.minFilter = key.MinFilter;
+	samplerInfo.mipmapMode = key.MipmapMode;
+	samplerInfo.addressModeU = key.AddressModeU;
+	samplerInfo.addressModeV = key.AddressModeV;
+	samplerInfo.addressModeW = key.AddressModeW;
+	samplerInfo.mipLodBias = key.MipLodBias;
+	samplerInfo.minLod = key.MinLod;
+	samplerInfo.maxLod = key.MaxLod;
+	samplerInfo.anisotropyEnable = (key.MaxAnisotropy > 1.0f) ? VK_TRUE : VK_FALSE;
+	samplerInfo.maxAnisotropy = (key.MaxAnisotropy > 1.0f) ? key.MaxAnisotropy : 1.0f;
+	samplerInfo.compareEnable = key.CompareEnable;
+	samplerInfo.compareOp = key.CompareOp;
+	samplerInfo.borderColor = key.BorderColor;
+	samplerInfo.unnormalizedCoordinates = key.UnnormalizedCoordinates;
+
+	VkSampler sampler = VK_NULL_HANDLE;
+	if (!ensure(vkCreateSampler(Device, &samplerInfo, nullptr, &sampler) == VK_SUCCESS))
+		return VK_NULL_HANDLE;
+
+	Samplers.insert(std::make_pair(key, sampler));
+	return sampler;
+}
@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// VkSampler 를 만들때 사용하는 상태값. 같은 상태의 Sampler 는 하나만 만들어서 여러 머터리얼이 공유함.
+struct jSamplerStateDesc
+{
+	VkFilter MagFilter = VK_FILTER_LINEAR;
+	VkFilter MinFilter = VK_FILTER_LINEAR;
+	VkSamplerMipmapMode MipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	VkSamplerAddressMode AddressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	VkSamplerAddressMode AddressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	VkSamplerAddressMode AddressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	float MipLodBias = 0.0f;
+	float MinLod = 0.0f;
+	float MaxLod = VK_LOD_CLAMP_NONE;
+	float MaxAnisotropy = 0.0f;				// 1.0 이하면 Anisotropy 사용안함
+	VkBool32 CompareEnable = VK_FALSE;
+	VkCompareOp CompareOp = VK_COMPARE_OP_ALWAYS;
+	VkBorderColor BorderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	VkBool32 UnnormalizedCoordinates = VK_FALSE;
+
+	bool operator == (const jSamplerStateDesc& other) const;
+	size_t GetHash() const;
+};
+
+class jSamplerCache
+{
+public:
+	// maxSupportedAnisotropy : VkPhysicalDeviceLimits::maxSamplerAnisotropy
+	void Initialize(VkDevice device, float maxSupportedAnisotropy);
+	void Release();
+
+	// 같은 상태의 Sampler 가 있으면 재사용하고, 없으면 새로 만듬. 실패하면 VK_NULL_HANDLE.
+	VkSampler GetSampler(const jSamplerStateDesc& desc);
+
+	uint64_t GetHitCount() const { return HitCount; }
+	uint64_t GetMissCount() const { return MissCount; }
+	size_t GetSamplerCount() const { return Samplers.size(); }
+
+private:
+	struct jSamplerStateDescHasher
+	{
+		size_t operator()(const jSamplerStateDesc& desc) const { return desc.GetHash(); }
+	};
+
+	VkDevice Device = VK_NULL_HANDLE;
+	float MaxSupportedAnisotropy = 1.0f;
+	std::unordered_map<jSamplerStateDesc, VkSampler, jSamplerStateDescHasher> Samplers;
+	uint64_t HitCount = 0;
+	uint64_t MissCount = 0;
+};
@@ -0,0 +1,285 @@
+﻿#include <pch.h>
+#include "jShaderCache.h"
+
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <cstdio>
+#include <cstring>
+#include "jAssert.h"
+#include "jDeletionQueue.h"
+
+// 컴파일 옵션이나 shaderc 버전이 바뀌어서 이전 캐시를 버려야 하면 올림
+static constexpr uint64_t SHADER_CACHE_VERSION = 1;
+
+static bool ReadFileContents(const std::string& filename, std::vector<char>& outData)
+{
+	std::ifstream file(filename, std::ios::ate | std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	outData.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(outData.data(), outData.size());
+	return !!file;
+}
+
+// 쓰는 도중 종료되어도 이전 파일이 깨지지 않도록 임시 파일에 쓴 뒤 이름을 바꿈 (jPipelineCache::Save 와 같은 방식)
+static bool WriteFileContents(const std::string& filename, const std::vector<char>& data)
+{
+	const std::string tempFilename = filename + ".tmp";
+	{
+		std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false;
+		file.write(data.data(), data.size());
+		if (!file)
+			return false;
+	}
+
+	// Windows 의 rename 은 대상 파일이 있으면 실패하므로 먼저 지움
+	std::remove(filename.c_str());
+	return std::rename(tempFilename.c_str(), filename.c_str()) == 0;
+}
+
+// 디스크 캐시가 잘렸거나 다른 파일인 경우를 걸러냄. 내용까지는 확인하지 않으므로 나머지는 vkCreateShaderModule 에 맡김.
+static bool IsSpirv(const std::vector<char>& data)
+{
+	static constexpr uint32_t SpirvMagic = 0x07230203;
+
+	if (data.size() < sizeof(uint32_t) || (data.size() % sizeof(uint32_t)) != 0)
+		return false;
+
+	uint32_t magic;
+	memcpy(&magic, data.data(), sizeof(magic));
+	return magic == SpirvMagic;
+}
+
+// 파일 이름에 쓰는 값이라 std::hash 처럼 구현마다 달라지지 않는 FNV-1a 를 사용함
+static void HashBytes(uint64_t& hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+}
+
+bool jShaderCache::Initialize(VkDevice device, const std::string& cacheDirectory)
+{
+	JASSERT(!Compiler);
+
+	Device = device;
+	CacheDirectory = cacheDirectory;
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(cacheDirectory, errorCode);
+
+	Compiler = shaderc_compiler_initialize();
+	return !!Compiler;
+}
+
+void jShaderCache::Release()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	for (auto& it : Modules)
+		vkDestroyShaderModule(Device, it.second.Module, nullptr);
+	Modules.clear();
+	for (VkShaderModule shaderModule : OutdatedModules)
+		vkDestroyShaderModule(Device, shaderModule, nullptr);
+	OutdatedModules.clear();
+	LatestHashes.clear();
+
+	if (Compiler)
+	{
+		shaderc_compiler_release(Compiler);
+		Compiler = nullptr;
+	}
+}
+
+VkShaderModule jShaderCache::GetShaderModule(const std::string& sourcePath, const std::vector<std::string>& defines)
+{
+	jShaderModule shaderModule;
+	return FindOrCreateModule(sourcePath, defines, shaderModule) ? shaderModule.Module : VK_NULL_HANDLE;
+}
+
+bool jShaderCache::GetReflection(const std::string& sourcePath, const std::vector<std::string>& defines, jShaderReflection& outReflection)
+{
+	jShaderModule shaderModule;
+	if (!FindOrCreateModule(sourcePath, defines, shaderModule) || !shaderModule.Reflected)
+		return false;
+
+	outReflection = std::move(shaderModule.Reflection);
+	return true;
+}
+
+bool jShaderCache::FindOrCreateModule(const std::string& sourcePath, const std::vector<std::string>& defines, jShaderModule& outModule)
+{
+	shaderc_shader_kind kind;
+	if (!ensure(GetShaderKind(sourcePath, kind)))
+		return false;
+
+	std::vector<char> source;
+	if (!ReadFileContents(sourcePath, source))
+	{
+		std::cout << "Shader : failed to read " << sourcePath << std::endl;
+		return false;
+	}
+
+	uint64_t hash = 0xcbf29ce484222325ull;
+	HashBytes(hash, &SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION));
+	HashBytes(hash, &kind, sizeof(kind));
+	HashBytes(hash, source.data(), source.size());
+	for (const std::string& define : defines)
+		HashBytes(hash, define.c_str(), define.size() + 1);		// 구분을 위해 '\0' 까지 포함
+
+	// 같은 소스와 defines 의 이전 버전 모듈을 찾기 위한 키
+	std::string sourceKey = sourcePath;
+	for (const std::string& define : defines)
+		sourceKey += '\0' + define;
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		auto it = Modules.find(hash);
+		if (it != Modules.end())
+		{
+			++ModuleHitCount;
+			outModule = it->second;
+			return true;
+		}
+	}
+
+	// 컴파일은 오래 걸리므로 잠그지 않고 진행함. shaderc_compiler_t 는 여러 스레드에서 동시에 써도 되므로 워커들이 각자 컴파일함.
+	// 같은 쉐이더를 여러 스레드에서 동시에 요청하면 중복으로 만들어질 수 있지만, 먼저 등록된 모듈을 쓰고 나머지는 버림.
+	char hashString[17];
+	snprintf(hashString, sizeof(hashString), "%016llx", static_cast<unsigned long long>(hash));
+	const std::string cachePath = CacheDirectory + "/" + std::filesystem::path(sourcePath).filename().string() + "." + hashString + ".spv";
+
+	std::vector<char> spirv;
+	const bool diskHit = ReadFileContents(cachePath, spirv) && IsSpirv(spirv);
+	if (!diskHit && !Compile(sourcePath, std::string(source.begin(), source.end()), kind, defines, spirv))
+		return false;
+
+	VkShaderModuleCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = spirv.size();
+
+	// pCode 가 uint32_t* 형이라서 4 byte aligned 된 메모리를 넘겨줘야 함.
+	// 다행히 std::vector의 default allocator가 가 메모리 할당시 4 byte aligned 을 이미 하고있어서 그대로 씀.
+	createInfo.pCode = reinterpret_cast<const uint32_t*>(spirv.data());
+
+	jShaderModule shaderModule;
+	if (!ensure(vkCreateShaderModule(Device, &createInfo, nullptr, &shaderModule.Module) == VK_SUCCESS))
+		return false;
+
+	// Reflection 에 실패해도 모듈은 쓸 수 있으므로 실패만 기록해둠
+	shaderModule.Reflected = shaderModule.Reflection.Parse(createInfo.pCode, spirv.size() / sizeof(uint32_t));
+	if (!shaderModule.Reflected)
+		std::cout << "Shader : failed to reflect " << sourcePath << std::endl;
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (diskHit)
+			++DiskHitCount;
+		else
+			++CompileCount;
+
+		auto it = Modules.find(hash);
+		if (it != Modules.end())
+		{
+			vkDestroyShaderModule(Device, shaderModule.Module, nullptr);
+			outModule = it->second;
+			return true;
+		}
+		outModule = shaderModule;
+		Modules.insert(std::make_pair(hash, std::move(shaderModule)));
+
+		// 소스가 바뀌어서 새로 만든 경우 이전 모듈은 더 이상 요청되지 않으므로 RetireOutdatedModules 에서 지우도록 옮겨둠
+		auto latestIt = LatestHashes.find(sourceKey);
+		if (latestIt == LatestHashes.end())
+		{
+			LatestHashes.insert(std::make_pair(std::move(sourceKey), hash));
+		}
+		else
+		{
+			auto outdatedIt = Modules.find(latestIt->second);
+			if (outdatedIt != Modules.end())
+			{
+				OutdatedModules.push_back(outdatedIt->second.Module);
+				Modules.erase(outdatedIt);
+			}
+			latestIt->second = hash;
+		}
+	}
+
+	// 캐시 저장에 실패해도 다음 실행에서 다시 컴파일할 뿐이므로 무시함. 모듈을 등록한 스레드만 쓰므로 임시 파일이 겹치지 않음.
+	if (!diskHit)
+		WriteFileContents(cachePath, spirv);
+
+	return true;
+}
+
+void jShaderCache::RetireOutdatedModules(jDeletionQueue& deletionQueue, uint64_t lastUsedValue)
+{
+	std::vector<VkShaderModule> outdatedModules;
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		outdatedModules.swap(OutdatedModules);
+	}
+
+	for (VkShaderModule shaderModule : outdatedModules)
+		deletionQueue.PushShaderModule(lastUsedValue, shaderModule);
+	RetiredCount += static_cast<uint32_t>(outdatedModules.size());
+}
+
+bool jShaderCache::GetShaderKind(const std::string& sourcePath, shaderc_shader_kind& outKind)
+{
+	const std::string extension = std::filesystem::path(sourcePath).extension().string();
+	if (extension == ".vert")
+		outKind = shaderc_vertex_shader;
+	else if (extension == ".frag")
+		outKind = shaderc_fragment_shader;
+	else if (extension == ".comp")
+		outKind = shaderc_compute_shader;
+	else
+		return false;
+	return true;
+}
+
+bool jShaderCache::Compile(const std::string& sourcePath, const std::string& source, shaderc_shader_kind kind
+	, const std::vector<std::string>& defines, std::vector<char>& outSpirv)
+{
+	shaderc_compile_options_t options = shaderc_compile_options_initialize();
+	shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+	shaderc_compile_options_set_optimization_level(options, shaderc_optimization_level_performance);
+	for (const std::string& define : defines)
+	{
+		const size_t separator = define.find('=');
+		if (separator == std::string::npos)
+		{
+			shaderc_compile_options_add_macro_definition(options, define.c_str(), define.size(), nullptr, 0);
+		}
+		else
+		{
+			shaderc_compile_options_add_macro_definition(options, define.c_str(), separator
+				, define.c_str() + separator + 1, define.size() - separator - 1);
+		}
+	}
+
+	shaderc_compilation_result_t result = shaderc_compile_into_spv(Compiler, source.c_str(), source.size(), kind, sourcePath.c_str(), "main", options);
+	const bool succeeded = (shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success);
+	if (succeeded)
+	{
+		const char* bytes = shaderc_result_get_bytes(result);
+		outSpirv.assign(bytes, bytes + shaderc_result_get_length(result));
+	}
+	else
+	{
+		std::cout << "Shader : failed to compile " << sourcePath << std::endl << shaderc_result_get_error_message(result) << std::endl;
+	}
+
+	shaderc_result_release(result);
+	shaderc_compile_options_release(options);
+	return succeeded;
+}
@@ -0,0 +1,71 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <shaderc/shaderc.h>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include "jShaderReflection.h"
+
+class jDeletionQueue;
+
+// GLSL 소스(.vert, .frag, .comp) 를 실행중에 SPIR-V 로 컴파일하고 VkShaderModule 을 만들어서 재사용하는 캐시.
+//
+// - 컴파일 결과는 (소스 내용, 스테이지, defines) 의 해시를 이름으로 디스크에 저장하므로 소스가 바뀌지 않았으면 다음 실행에서 컴파일을 건너뜀.
+// - 소스를 매번 읽어서 해시를 비교하므로 파일을 수정하면 다음 요청에서 새로 컴파일됨. 이전 모듈은 RetireOutdatedModules 에서 지움.
+// - #include 는 지원하지 않음.
+// - 파이프라인 컴파일 워커에서 동시에 호출하므로 내부적으로 동기화함.
+// - 모듈을 만들때 SPIR-V reflection 도 같이 해두므로 레이아웃을 만들때 SPIR-V 를 다시 읽지 않아도 됨.
+// - 모듈은 캐시가 소유하므로 사용하는 쪽에서 vkDestroyShaderModule 을 호출하면 안됨.
+class jShaderCache
+{
+public:
+	bool Initialize(VkDevice device, const std::string& cacheDirectory);
+	void Release();
+
+	// defines : "NAME" 또는 "NAME=VALUE". 실패하면(파일이 없거나 컴파일 오류) VK_NULL_HANDLE 이고 오류는 콘솔에 출력함.
+	VkShaderModule GetShaderModule(const std::string& sourcePath, const std::vector<std::string>& defines);
+
+	// 쉐이더가 사용하는 리소스 인터페이스. 모듈이 없으면 먼저 만듬.
+	bool GetReflection(const std::string& sourcePath, const std::vector<std::string>& defines, jShaderReflection& outReflection);
+
+	// 소스가 바뀌어서 새 모듈로 대체된 이전 모듈들을 삭제 큐로 넘김.
+	// 이전 모듈로 파이프라인을 만드는 중인 스레드가 없을 때(모든 파이프라인 컴파일이 끝난 뒤) 호출해야 함.
+	void RetireOutdatedModules(jDeletionQueue& deletionQueue, uint64_t lastUsedValue);
+
+	uint32_t GetCompileCount() const { return CompileCount; }
+	uint32_t GetDiskHitCount() const { return DiskHitCount; }
+	uint64_t GetModuleHitCount() const { return ModuleHitCount; }
+	size_t GetModuleCount() const { return Modules.size(); }
+	uint32_t GetRetiredCount() const { return RetiredCount; }
+
+private:
+	struct jShaderModule
+	{
+		VkShaderModule Module = VK_NULL_HANDLE;
+		jShaderReflection Reflection;
+		bool Reflected = false;
+	};
+
+	// 소스가 바뀌면 이전 모듈은 다른 스레드에서 맵에서 빠질 수 있으므로 포인터 대신 잠근 상태에서 복사해서 돌려줌
+	bool FindOrCreateModule(const std::string& sourcePath, const std::vector<std::string>& defines, jShaderModule& outModule);
+
+	static bool GetShaderKind(const std::string& sourcePath, shaderc_shader_kind& outKind);
+	bool Compile(const std::string& sourcePath, const std::string& source, shaderc_shader_kind kind
+		, const std::vector<std::string>& defines, std::vector<char>& outSpirv);
+
+	VkDevice Device = VK_NULL_HANDLE;
+	std::string CacheDirectory;
+	shaderc_compiler_t Compiler = nullptr;
+
+	std::mutex Mutex;
+	std::unordered_map<uint64_t, jShaderModule> Modules;		// (소스 내용, 스테이지, defines) 해시 -> 모듈
+	std::unordered_map<std::string, uint64_t> LatestHashes;		// (소스 경로, defines) -> 가장 최근에 만든 모듈의 해시
+	std::vector<VkShaderModule> OutdatedModules;				// 소스가 바뀌어서 더 이상 요청되지 않는 모듈들
+	uint32_t CompileCount = 0;
+	uint32_t DiskHitCount = 0;
+	uint64_t ModuleHitCount = 0;
+	uint32_t RetiredCount = 0;
+};
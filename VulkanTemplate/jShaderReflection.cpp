@@ -0,0 +1,503 @@
+﻿#include <pch.h>
+#include "jShaderReflection.h"
+
+#include <algorithm>
+#include <iostream>
+#include "jAssert.h"
+#include "jDescriptorSetLayoutCache.h"
+
+// 사용하는 SPIR-V 명령어와 값들만 정의함. (https://www.khronos.org/registry/SPIR-V/specs/unified1/SPIRV.html)
+namespace jSpirv
+{
+	static constexpr uint32_t MagicNumber = 0x07230203;
+	static constexpr uint32_t HeaderWordCount = 5;
+
+	enum Op : uint32_t
+	{
+		OpName = 5,
+		OpMemberName = 6,
+		OpEntryPoint = 15,
+		OpTypeBool = 20,
+		OpTypeInt = 21,
+		OpTypeFloat = 22,
+		OpTypeVector = 23,
+		OpTypeMatrix = 24,
+		OpTypeImage = 25,
+		OpTypeSampler = 26,
+		OpTypeSampledImage = 27,
+		OpTypeArray = 28,
+		OpTypeRuntimeArray = 29,
+		OpTypeStruct = 30,
+		OpTypePointer = 32,
+		OpConstant = 43,
+		OpSpecConstant = 50,
+		OpVariable = 59,
+		OpDecorate = 71,
+		OpMemberDecorate = 72,
+	};
+
+	enum Decoration : uint32_t
+	{
+		Block = 2,
+		BufferBlock = 3,
+		ArrayStride = 6,
+		MatrixStride = 7,
+		Binding = 33,
+		DescriptorSet = 34,
+		Offset = 35,
+	};
+
+	enum StorageClass : uint32_t
+	{
+		UniformConstant = 0,
+		Uniform = 2,
+		PushConstant = 9,
+		StorageBuffer = 12,
+	};
+
+	enum ExecutionModel : uint32_t
+	{
+		Vertex = 0,
+		TessellationControl = 1,
+		TessellationEvaluation = 2,
+		Geometry = 3,
+		Fragment = 4,
+		GLCompute = 5,
+	};
+
+	// OpTypeImage 의 Dim
+	static constexpr uint32_t DimBuffer = 5;
+	static constexpr uint32_t DimSubpassData = 6;
+}
+
+// ID 하나에 대해 모아둔 정보. 명령어는 원본 SPIR-V 를 가리키므로 Parse 하는 동안만 유효함.
+struct jSpirvId
+{
+	uint32_t Opcode = 0;
+	const uint32_t* Words = nullptr;		// 명령어 시작 (Words[0] 은 opcode 와 길이)
+	uint32_t WordCount = 0;
+
+	std::string Name;
+	uint32_t Set = 0;
+	uint32_t Binding = UINT32_MAX;
+	uint32_t ArrayStride = 0;
+	bool Block = false;
+	bool BufferBlock = false;
+
+	std::vector<std::string> MemberNames;
+	std::vector<uint32_t> MemberOffsets;
+	std::vector<uint32_t> MemberMatrixStrides;
+};
+
+class jSpirvModule
+{
+public:
+	explicit jSpirvModule(uint32_t bound) : Ids(bound) {}
+
+	jSpirvId* Find(uint32_t id) { return (id < Ids.size()) ? &Ids[id] : nullptr; }
+	const jSpirvId* Find(uint32_t id) const { return (id < Ids.size()) ? &Ids[id] : nullptr; }
+
+	uint32_t GetConstantValue(uint32_t id) const
+	{
+		const jSpirvId* constant = Find(id);
+		if (!constant || ((constant->Opcode != jSpirv::OpConstant) && (constant->Opcode != jSpirv::OpSpecConstant)) || (constant->WordCount < 4))
+			return 0;
+		return constant->Words[3];
+	}
+
+	// matrixStride : 행렬 멤버인 경우 부모 구조체에 있는 MatrixStride 데코레이션 값
+	uint32_t GetTypeSize(uint32_t typeId, uint32_t matrixStride) const
+	{
+		const jSpirvId* type = Find(typeId);
+		if (!type || !type->Words)
+			return 0;
+
+		switch (type->Opcode)
+		{
+		case jSpirv::OpTypeBool:
+			return 4;
+		case jSpirv::OpTypeInt:
+		case jSpirv::OpTypeFloat:
+			return type->Words[2] / 8;
+		case jSpirv::OpTypeVector:
+			return type->Words[3] * GetTypeSize(type->Words[2], 0);
+		case jSpirv::OpTypeMatrix:
+			return type->Words[3] * (matrixStride ? matrixStride : GetTypeSize(type->Words[2], 0));
+		case jSpirv::OpTypeArray:
+			return GetConstantValue(type->Words[3]) * (type->ArrayStride ? type->ArrayStride : GetTypeSize(type->Words[2], matrixStride));
+		case jSpirv::OpTypeStruct:
+			return ReadBlock(typeId).Size;
+		default:
+			return 0;		// Runtime array 등 크기를 알 수 없는 것
+		}
+	}
+
+	jReflectedBlock ReadBlock(uint32_t structId) const
+	{
+		jReflectedBlock block;
+		const jSpirvId* type = Find(structId);
+		if (!type || (type->Opcode != jSpirv::OpTypeStruct))
+			return block;
+
+		block.Name = type->Name;
+		const uint32_t memberCount = type->WordCount - 2;
+		for (uint32_t i = 0; i < memberCount; ++i)
+		{
+			const uint32_t memberTypeId = type->Words[2 + i];
+			const uint32_t matrixStride = (i < type->MemberMatrixStrides.size()) ? type->MemberMatrixStrides[i] : 0;
+
+			jReflectedMember member;
+			member.Name = (i < type->MemberNames.size()) ? type->MemberNames[i] : std::string();
+			member.Offset = (i < type->MemberOffsets.size()) ? type->MemberOffsets[i] : 0;
+			member.Size = GetTypeSize(memberTypeId, matrixStride);
+			if (const jSpirvId* memberType = Find(memberTypeId))
+			{
+				if ((memberType->Opcode == jSpirv::OpTypeArray) || (memberType->Opcode == jSpirv::OpTypeRuntimeArray))
+					member.ArrayStride = memberType->ArrayStride;
+			}
+
+			block.Size = std::max(block.Size, member.Offset + member.Size);
+			block.Members.push_back(std::move(member));
+		}
+		return block;
+	}
+
+	std::vector<jSpirvId> Ids;
+};
+
+static std::string ReadString(const uint32_t* words, uint32_t wordCount)
+{
+	const char* chars = reinterpret_cast<const char*>(words);
+	const size_t maxLength = wordCount * sizeof(uint32_t);
+	size_t length = 0;
+	while ((length < maxLength) && chars[length])
+		++length;
+	return std::string(chars, length);
+}
+
+static VkShaderStageFlags ToShaderStage(uint32_t executionModel)
+{
+	switch (executionModel)
+	{
+	case jSpirv::Vertex: return VK_SHADER_STAGE_VERTEX_BIT;
+	case jSpirv::TessellationControl: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+	case jSpirv::TessellationEvaluation: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+	case jSpirv::Geometry: return VK_SHADER_STAGE_GEOMETRY_BIT;
+	case jSpirv::Fragment: return VK_SHADER_STAGE_FRAGMENT_BIT;
+	case jSpirv::GLCompute: return VK_SHADER_STAGE_COMPUTE_BIT;
+	default: return 0;
+	}
+}
+
+template <typename T>
+static void SetAt(std::vector<T>& values, uint32_t index, const T& value)
+{
+	if (values.size() <= index)
+		values.resize(index + 1);
+	values[index] = value;
+}
+
+static void InsertSorted(std::vector<jReflectedBinding>& bindings, jReflectedBinding&& binding)
+{
+	const auto it = std::upper_bound(bindings.begin(), bindings.end(), binding, [](const jReflectedBinding& a, const jReflectedBinding& b)
+	{
+		return (a.Set != b.Set) ? (a.Set < b.Set) : (a.Binding < b.Binding);
+	});
+	bindings.insert(it, std::move(binding));
+}
+
+bool jReflectedBlock::Validate(const char* cppTypeName, const std::vector<jReflectedMember>& cppMembers, size_t cppSize) const
+{
+	bool valid = true;
+	if (cppMembers.size() > Members.size())
+	{
+		std::cout << "Shader layout : " << cppTypeName << " has " << cppMembers.size() << " members but shader block " << Name << " has " << Members.size() << std::endl;
+		valid = false;
+	}
+
+	const size_t memberCount = std::min(cppMembers.size(), Members.size());
+	for (size_t i = 0; i < memberCount; ++i)
+	{
+		const jReflectedMember& cppMember = cppMembers[i];
+		const jReflectedMember& shaderMember = Members[i];
+
+		// 크기 없는 배열은 원소 하나의 크기를 비교함
+		const uint32_t shaderSize = shaderMember.Size ? shaderMember.Size : shaderMember.ArrayStride;
+		if ((cppMember.Offset != shaderMember.Offset) || (cppMember.Size != shaderSize))
+		{
+			std::cout << "Shader layout : " << cppTypeName << "::" << cppMember.Name << " (offset " << cppMember.Offset << ", size " << cppMember.Size << ") != "
+				<< Name << "." << shaderMember.Name << " (offset " << shaderMember.Offset << ", size " << shaderSize << ")" << std::endl;
+			valid = false;
+		}
+	}
+
+	if (cppSize < Size)
+	{
+		std::cout << "Shader layout : sizeof(" << cppTypeName << ") = " << cppSize << " is smaller than shader block " << Name << " (" << Size << ")" << std::endl;
+		valid = false;
+	}
+	return valid;
+}
+
+bool jShaderReflection::Parse(const uint32_t* code, size_t wordCount)
+{
+	StageFlags = 0;
+	Bindings.clear();
+	PushConstantBlock = jReflectedBlock();
+	PushConstantStageFlags = 0;
+
+	if (!code || (wordCount < jSpirv::HeaderWordCount) || (code[0] != jSpirv::MagicNumber))
+		return false;
+
+	// 헤더의 Bound : 모든 ID 는 이 값보다 작음
+	jSpirvModule module(code[3]);
+	std::vector<uint32_t> variables;
+
+	for (size_t i = jSpirv::HeaderWordCount; i < wordCount; )
+	{
+		const uint32_t* words = code + i;
+		const uint32_t opcode = words[0] & 0xffff;
+		const uint32_t count = words[0] >> 16;
+		if ((count == 0) || (i + count > wordCount))
+			return false;
+		i += count;
+
+		switch (opcode)
+		{
+		case jSpirv::OpEntryPoint:
+			if (count >= 2)
+				StageFlags |= ToShaderStage(words[1]);
+			break;
+		case jSpirv::OpName:
+			if (jSpirvId* target = (count >= 3) ? module.Find(words[1]) : nullptr)
+				target->Name = ReadString(words + 2, count - 2);
+			break;
+		case jSpirv::OpMemberName:
+			if (jSpirvId* target = (count >= 4) ? module.Find(words[1]) : nullptr)
+				SetAt(target->MemberNames, words[2], ReadString(words + 3, count - 3));
+			break;
+		case jSpirv::OpDecorate:
+			if (jSpirvId* target = (count >= 3) ? module.Find(words[1]) : nullptr)
+			{
+				const uint32_t value = (count >= 4) ? words[3] : 0;
+				switch (words[2])
+				{
+				case jSpirv::Block: target->Block = true; break;
+				case jSpirv::BufferBlock: target->BufferBlock = true; break;
+				case jSpirv::ArrayStride: target->ArrayStride = value; break;
+				case jSpirv::Binding: target->Binding = value; break;
+				case jSpirv::DescriptorSet: target->Set = value; break;
+				}
+			}
+			break;
+		case jSpirv::OpMemberDecorate:
+			if (jSpirvId* target = (count >= 5) ? module.Find(words[1]) : nullptr)
+			{
+				if (words[3] == jSpirv::Offset)
+					SetAt(target->MemberOffsets, words[2], words[4]);
+				else if (words[3] == jSpirv::MatrixStride)
+					SetAt(target->MemberMatrixStrides, words[2], words[4]);
+			}
+			break;
+		case jSpirv::OpTypeBool:
+		case jSpirv::OpTypeInt:
+		case jSpirv::OpTypeFloat:
+		case jSpirv::OpTypeVector:
+		case jSpirv::OpTypeMatrix:
+		case jSpirv::OpTypeImage:
+		case jSpirv::OpTypeSampler:
+		case jSpirv::OpTypeSampledImage:
+		case jSpirv::OpTypeArray:
+		case jSpirv::OpTypeRuntimeArray:
+		case jSpirv::OpTypeStruct:
+		case jSpirv::OpTypePointer:
+			// 타입 명령어는 Words[1] 이 결과 ID
+			if (jSpirvId* target = (count >= 2) ? module.Find(words[1]) : nullptr)
+			{
+				target->Opcode = opcode;
+				target->Words = words;
+				target->WordCount = count;
+			}
+			break;
+		case jSpirv::OpConstant:
+		case jSpirv::OpSpecConstant:
+		case jSpirv::OpVariable:
+			// Words[1] 이 결과 타입, Words[2] 가 결과 ID
+			if (jSpirvId* target = (count >= 4) ? module.Find(words[2]) : nullptr)
+			{
+				target->Opcode = opcode;
+				target->Words = words;
+				target->WordCount = count;
+				if (opcode == jSpirv::OpVariable)
+					variables.push_back(words[2]);
+			}
+			break;
+		}
+	}
+
+	for (uint32_t variableId : variables)
+	{
+		const jSpirvId& variable = *module.Find(variableId);
+		const uint32_t storageClass = variable.Words[3];
+
+		const jSpirvId* pointer = module.Find(variable.Words[1]);
+		if (!pointer || (pointer->Opcode != jSpirv::OpTypePointer) || (pointer->WordCount < 4))
+			continue;
+
+		if (storageClass == jSpirv::PushConstant)
+		{
+			PushConstantBlock = module.ReadBlock(pointer->Words[3]);
+			PushConstantStageFlags = StageFlags;
+			continue;
+		}
+
+		if ((storageClass != jSpirv::UniformConstant) && (storageClass != jSpirv::Uniform) && (storageClass != jSpirv::StorageBuffer))
+			continue;
+
+		// 배열이면 원소 타입까지 내려가면서 Descriptor 개수를 구함
+		uint32_t typeId = pointer->Words[3];
+		uint32_t descriptorCount = 1;
+		const jSpirvId* type = module.Find(typeId);
+		while (type && ((type->Opcode == jSpirv::OpTypeArray) || (type->Opcode == jSpirv::OpTypeRuntimeArray)))
+		{
+			descriptorCount = (type->Opcode == jSpirv::OpTypeArray) ? (descriptorCount * module.GetConstantValue(type->Words[3])) : 0;
+			typeId = type->Words[2];
+			type = module.Find(typeId);
+		}
+		if (!type || (variable.Binding == UINT32_MAX))
+			continue;
+
+		jReflectedBinding binding;
+		binding.Set = variable.Set;
+		binding.Binding = variable.Binding;
+		binding.DescriptorCount = descriptorCount;
+		binding.StageFlags = StageFlags;
+		binding.Name = variable.Name;
+
+		switch (type->Opcode)
+		{
+		case jSpirv::OpTypeSampledImage:
+			binding.DescriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			break;
+		case jSpirv::OpTypeSampler:
+			binding.DescriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+			break;
+		case jSpirv::OpTypeImage:
+		{
+			if (type->WordCount < 9)
+				continue;
+
+			// Words[3] : Dim, Words[7] : Sampled (1 이면 샘플링용, 2 면 Storage 용)
+			const bool storage = (type->Words[7] == 2);
+			if (type->Words[3] == jSpirv::DimBuffer)
+				binding.DescriptorType = storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			else if (type->Words[3] == jSpirv::DimSubpassData)
+				binding.DescriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			else
+				binding.DescriptorType = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			break;
+		}
+		case jSpirv::OpTypeStruct:
+			// SPIR-V 1.3 이전에는 Storage buffer 를 Uniform + BufferBlock 으로 표현함
+			if ((storageClass == jSpirv::StorageBuffer) || type->BufferBlock)
+				binding.DescriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			else
+				binding.DescriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			binding.Block = module.ReadBlock(typeId);
+			if (binding.Name.empty())
+				binding.Name = binding.Block.Name;
+			break;
+		default:
+			continue;		// Acceleration structure 등은 아직 사용하지 않음
+		}
+
+		InsertSorted(Bindings, std::move(binding));
+	}
+
+	return StageFlags != 0;
+}
+
+bool jShaderReflection::Merge(const jShaderReflection& other)
+{
+	StageFlags |= other.StageFlags;
+
+	bool compatible = true;
+	for (const jReflectedBinding& otherBinding : other.Bindings)
+	{
+		auto it = std::find_if(Bindings.begin(), Bindings.end(), [&otherBinding](const jReflectedBinding& binding)
+		{
+			return (binding.Set == otherBinding.Set) && (binding.Binding == otherBinding.Binding);
+		});
+		if (it == Bindings.end())
+		{
+			jReflectedBinding binding = otherBinding;
+			InsertSorted(Bindings, std::move(binding));
+			continue;
+		}
+
+		if ((it->DescriptorType != otherBinding.DescriptorType) || (it->DescriptorCount != otherBinding.DescriptorCount))
+		{
+			std::cout << "Shader reflection : set " << otherBinding.Set << ", binding " << otherBinding.Binding << " is declared differently in each stage" << std::endl;
+			compatible = false;
+		}
+		it->StageFlags |= otherBinding.StageFlags;
+	}
+
+	if (other.PushConstantStageFlags)
+	{
+		// 스테이지마다 사용하는 멤버만 남아있을 수 있으므로 더 큰 쪽을 씀
+		if (other.PushConstantBlock.Size > PushConstantBlock.Size)
+			PushConstantBlock = other.PushConstantBlock;
+		PushConstantStageFlags |= other.PushConstantStageFlags;
+	}
+	return compatible;
+}
+
+bool jShaderReflection::SetDynamicBuffer(uint32_t set, uint32_t binding)
+{
+	for (jReflectedBinding& reflectedBinding : Bindings)
+	{
+		if ((reflectedBinding.Set != set) || (reflectedBinding.Binding != binding))
+			continue;
+
+		if (reflectedBinding.DescriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+			reflectedBinding.DescriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		else if (reflectedBinding.DescriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+			reflectedBinding.DescriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+		else
+			return false;
+		return true;
+	}
+	return false;
+}
+
+const jReflectedBinding* jShaderReflection::FindBinding(uint32_t set, uint32_t binding) const
+{
+	for (const jReflectedBinding& reflectedBinding : Bindings)
+	{
+		if ((reflectedBinding.Set == set) && (reflectedBinding.Binding == binding))
+			return &reflectedBinding;
+	}
+	return nullptr;
+}
+
+void jShaderReflection::GetDescriptorSetLayoutDesc(uint32_t set, jDescriptorSetLayoutDesc& outDesc, uint32_t maxRuntimeArrayCount) const
+{
+	for (const jReflectedBinding& binding : Bindings)
+	{
+		if (binding.Set != set)
+			continue;
+
+		const uint32_t count = binding.DescriptorCount ? binding.DescriptorCount : maxRuntimeArrayCount;
+		outDesc.AddBinding(binding.Binding, binding.DescriptorType, count, binding.StageFlags);
+	}
+}
+
+VkPushConstantRange jShaderReflection::GetPushConstantRange() const
+{
+	VkPushConstantRange range = {};
+	range.stageFlags = PushConstantStageFlags;
+	range.offset = 0;
+	range.size = PushConstantBlock.Size;
+	return range;
+}
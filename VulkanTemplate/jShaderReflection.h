@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+struct jDescriptorSetLayoutDesc;
+
+// 블럭(Uniform buffer, Storage buffer, Push constant) 멤버 하나의 위치와 크기
+struct jReflectedMember
+{
+	std::string Name;
+	uint32_t Offset = 0;
+	uint32_t Size = 0;				// 크기 없는 배열(runtime array) 이면 0
+	uint32_t ArrayStride = 0;		// 배열인 경우 원소 사이의 간격
+};
+
+// C++ 구조체의 멤버를 jReflectedMember 로 만듬. ex) JREFLECT_MEMBER(jUniformBufferObject, View)
+#define JREFLECT_MEMBER(Type, Member) jReflectedMember{ #Member, static_cast<uint32_t>(offsetof(Type, Member)), static_cast<uint32_t>(sizeof(Type::Member)), 0 }
+
+struct jReflectedBlock
+{
+	std::string Name;				// 블럭 타입 이름 (ex. UniformBufferObject)
+	uint32_t Size = 0;				// 마지막 멤버의 끝. 크기 없는 배열은 포함하지 않음
+	std::vector<jReflectedMember> Members;
+
+	// C++ 구조체가 쉐이더의 블럭과 같은 레이아웃인지 확인함. 다르면 차이를 콘솔에 출력하고 false.
+	// - cppMembers 는 선언 순서대로 넘겨야 하며 쉐이더 블럭의 앞쪽 멤버들과 순서대로 비교함.
+	// - 크기 없는 배열 멤버는 C++ 쪽 Size 를 원소 하나의 크기로 보고 ArrayStride 와 비교함.
+	bool Validate(const char* cppTypeName, const std::vector<jReflectedMember>& cppMembers, size_t cppSize) const;
+};
+
+struct jReflectedBinding
+{
+	uint32_t Set = 0;
+	uint32_t Binding = 0;
+	VkDescriptorType DescriptorType = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+	uint32_t DescriptorCount = 1;	// 크기 없는 배열(ex. sampler2D textures[]) 이면 0
+	VkShaderStageFlags StageFlags = 0;
+	std::string Name;
+	jReflectedBlock Block;			// Uniform buffer, Storage buffer 인 경우
+};
+
+// SPIR-V 에서 쉐이더가 사용하는 리소스 인터페이스를 읽음. 외부 라이브러리 없이 필요한 명령어만 해석함.
+// Descriptor set layout, Push constant range 를 쉐이더에서 만들고, C++ 구조체의 메모리 레이아웃을 검증하는데 사용.
+//
+// - Dynamic buffer 인지 여부는 쉐이더에서 알 수 없으므로 SetDynamicBuffer 로 직접 지정해야 함.
+// - Immutable sampler, Update after bind 같은 레이아웃 플래그도 쉐이더에서 알 수 없으므로 그런 set 은 직접 만들어야 함.
+class jShaderReflection
+{
+public:
+	// 실패하면(SPIR-V 가 아니거나 지원하지 않는 형식) false
+	bool Parse(const uint32_t* code, size_t wordCount);
+
+	// 다른 스테이지의 결과를 합침. 같은 바인딩은 StageFlags 만 합쳐지며, 타입이 다르면 false.
+	bool Merge(const jShaderReflection& other);
+
+	// UNIFORM_BUFFER -> UNIFORM_BUFFER_DYNAMIC, STORAGE_BUFFER -> STORAGE_BUFFER_DYNAMIC
+	bool SetDynamicBuffer(uint32_t set, uint32_t binding);
+
+	VkShaderStageFlags GetStageFlags() const { return StageFlags; }
+	const std::vector<jReflectedBinding>& GetBindings() const { return Bindings; }
+	const jReflectedBinding* FindBinding(uint32_t set, uint32_t binding) const;
+
+	// 크기 없는 배열은 maxRuntimeArrayCount 개로 만듬
+	void GetDescriptorSetLayoutDesc(uint32_t set, jDescriptorSetLayoutDesc& outDesc, uint32_t maxRuntimeArrayCount = 0) const;
+
+	bool HasPushConstants() const { return PushConstantStageFlags != 0; }
+	const jReflectedBlock& GetPushConstantBlock() const { return PushConstantBlock; }
+	VkPushConstantRange GetPushConstantRange() const;
+
+private:
+	VkShaderStageFlags StageFlags = 0;
+	std::vector<jReflectedBinding> Bindings;		// (Set, Binding) 순서로 정렬됨
+	jReflectedBlock PushConstantBlock;
+	VkShaderStageFlags PushConstantStageFlags = 0;
+};
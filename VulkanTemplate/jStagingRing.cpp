@@ -0,0 +1,136 @@
+﻿#include <pch.h>
+#include "jStagingRing.h"
+
+#include <cstdlib>
+#include <cstring>
+#include "Generic/TemplateUtility.h"
+
+void jStagingRing::Initialize(VkBuffer buffer, void* mappedData, VkDeviceSize size)
+{
+	Buffer = buffer;
+	MappedData = static_cast<uint8_t*>(mappedData);
+	Size = size;
+
+	Head = 0;
+	Tail = 0;
+	UsedSize = 0;
+	PendingBytes = 0;
+	RetiredRanges.clear();
+}
+
+bool jStagingRing::Allocate(VkDeviceSize size, VkDeviceSize alignment, jStagingAllocation& outAllocation)
+{
+	if (size == 0 || size > Size)
+		return false;
+
+	// 모두 반환된 상태라면 처음부터 사용하여 최대한 큰 연속 공간을 확보함
+	if (UsedSize == 0)
+	{
+		Head = 0;
+		Tail = 0;
+	}
+
+	// Head 가 Tail 을 넘어서 한바퀴 돌았는지 여부, Head == Tail 이면서 사용중인 영역이 있으면 가득찬 상태
+	const bool wrapped = (Head < Tail) || ((Head == Tail) && (UsedSize > 0));
+
+	VkDeviceSize offset = Aligned(Head, alignment);
+	VkDeviceSize padding = offset - Head;
+	if (wrapped)
+	{
+		if ((offset + size) > Tail)
+			return false;
+	}
+	else if ((offset + size) > Size)
+	{
+		// 버퍼의 끝에 공간이 부족하면 끝부분은 버리고 처음부터 할당
+		if (size > Tail)
+			return false;
+
+		offset = 0;
+		padding = Size - Head;
+	}
+
+	Head = offset + size;
+	UsedSize += padding + size;
+	PendingBytes += padding + size;
+
+	outAllocation.Buffer = Buffer;
+	outAllocation.Offset = offset;
+	outAllocation.Size = size;
+	outAllocation.MappedData = MappedData + offset;
+	return true;
+}
+
+void jStagingRing::Retire(uint64_t value)
+{
+	if (PendingBytes == 0)
+		return;
+
+	jRetiredRange range;
+	range.Value = value;
+	range.End = Head;
+	range.Bytes = PendingBytes;
+	RetiredRanges.push_back(range);
+	PendingBytes = 0;
+}
+
+void jStagingRing::Release(uint64_t completedValue)
+{
+	while (!RetiredRanges.empty() && (RetiredRanges.front().Value <= completedValue))
+	{
+		Tail = RetiredRanges.front().End;
+		UsedSize -= RetiredRanges.front().Bytes;
+		RetiredRanges.pop_front();
+	}
+}
+
+namespace jImageDecodeTarget
+{
+	// 여러 스레드에서 디코딩 할 수 있도록 스레드별로 target 을 가짐
+	thread_local void* Target = nullptr;
+	thread_local size_t TargetSize = 0;
+	thread_local bool TargetUsed = false;
+
+	void SetTarget(void* target, size_t size)
+	{
+		Target = target;
+		TargetSize = size;
+		TargetUsed = false;
+	}
+
+	void ClearTarget()
+	{
+		SetTarget(nullptr, 0);
+	}
+
+	void* Malloc(size_t size)
+	{
+		if (Target && !TargetUsed && (size == TargetSize))
+		{
+			TargetUsed = true;
+			return Target;
+		}
+		return malloc(size);
+	}
+
+	void* Realloc(void* ptr, size_t newSize)
+	{
+		if (ptr && (ptr == Target))
+		{
+			// target 영역은 크기를 바꿀 수 없으므로 일반 메모리로 옮김. 이 경우 stbi_load 의 반환값은 target 과 달라짐.
+			void* newPtr = malloc(newSize);
+			if (newPtr)
+				memcpy(newPtr, ptr, (newSize < TargetSize) ? newSize : TargetSize);
+			return newPtr;
+		}
+		return realloc(ptr, newSize);
+	}
+
+	void Free(void* ptr)
+	{
+		// target 영역은 Staging ring 의 메모리이므로 해제하지 않음
+		if (ptr && (ptr == Target))
+			return;
+		free(ptr);
+	}
+}
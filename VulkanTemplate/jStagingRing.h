@@ -0,0 +1,67 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+
+// 계속 Map 되어있는 하나의 Staging 버퍼를 Ring 형태로 나눠쓰는 클래스.
+// 업로드마다 vkAllocateMemory / vkMapMemory / vkFreeMemory 를 하지 않아도 됨.
+//
+// 사용법
+// 1. Allocate 로 영역을 얻어서 MappedData 에 바로 씀.
+// 2. 해당 영역을 사용하는 커맨드를 제출한 뒤 Retire(value) 로 지금까지 할당한 영역들을 value 에 묶어줌.
+// 3. value 에 해당하는 작업이 GPU 에서 완료되면 Release(completedValue) 로 영역을 반환함.
+struct jStagingAllocation
+{
+	VkBuffer Buffer = VK_NULL_HANDLE;
+	VkDeviceSize Offset = 0;
+	VkDeviceSize Size = 0;
+	void* MappedData = nullptr;		// Buffer 의 Offset 위치를 가리키는 포인터
+};
+
+class jStagingRing
+{
+public:
+	void Initialize(VkBuffer buffer, void* mappedData, VkDeviceSize size);
+
+	bool Allocate(VkDeviceSize size, VkDeviceSize alignment, jStagingAllocation& outAllocation);
+	void Retire(uint64_t value);
+	void Release(uint64_t completedValue);
+
+	VkBuffer GetBuffer() const { return Buffer; }
+	VkDeviceSize GetSize() const { return Size; }
+	VkDeviceSize GetUsedSize() const { return UsedSize; }
+
+private:
+	struct jRetiredRange
+	{
+		uint64_t Value = 0;
+		VkDeviceSize End = 0;		// 이 범위가 반환되면 Tail 이 이동할 위치
+		VkDeviceSize Bytes = 0;		// 패딩을 포함한 크기
+	};
+
+	VkBuffer Buffer = VK_NULL_HANDLE;
+	uint8_t* MappedData = nullptr;
+	VkDeviceSize Size = 0;
+
+	VkDeviceSize Head = 0;			// 다음 할당 위치
+	VkDeviceSize Tail = 0;			// 아직 사용중인 가장 오래된 위치
+	VkDeviceSize UsedSize = 0;
+	VkDeviceSize PendingBytes = 0;	// 아직 Retire 되지 않은 할당 크기
+	std::deque<jRetiredRange> RetiredRanges;
+};
+
+// stb_image 가 최종 결과 이미지를 Staging ring 에 바로 디코딩 하도록 하기 위한 할당자.
+// STBI_MALLOC / STBI_REALLOC / STBI_FREE 로 연결해서 사용함.
+// 디코딩 전에 SetTarget 으로 결과 이미지 크기와 같은 영역을 지정해두면, 그 크기의 할당 요청에 대해 해당 영역을 돌려줌.
+// stbi_load 의 반환값이 target 과 같다면 추가적인 memcpy 없이 디코딩이 끝난 것임.
+namespace jImageDecodeTarget
+{
+	void SetTarget(void* target, size_t size);
+	void ClearTarget();
+
+	void* Malloc(size_t size);
+	void* Realloc(void* ptr, size_t newSize);
+	void Free(void* ptr);
+}
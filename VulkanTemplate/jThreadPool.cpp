@@ -0,0 +1,105 @@
+﻿#include <pch.h>
+#include "jThreadPool.h"
+
+#include "jAssert.h"
+
+void jThreadPool::Initialize(uint32_t workerCount)
+{
+	JASSERT(Workers.empty());
+
+	ExitRequested = false;
+	Workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; ++i)
+		Workers.emplace_back(&jThreadPool::WorkerMain, this);
+}
+
+void jThreadPool::Release()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		ExitRequested = true;
+	}
+	WorkCondition.notify_all();
+
+	for (std::thread& worker : Workers)
+		worker.join();
+	Workers.clear();
+}
+
+void jThreadPool::ParallelFor(uint32_t jobCount, const std::function<void(uint32_t)>& job)
+{
+	if (jobCount == 0)
+		return;
+
+	// 작업이 하나 뿐이면 워커를 깨우는 비용이 더 큼
+	if (Workers.empty() || (jobCount == 1))
+	{
+		for (uint32_t i = 0; i < jobCount; ++i)
+			job(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		JASSERT(!Job && !ActiveWorkers);
+		Job = &job;
+		JobCount = jobCount;
+		RemainingJobs = jobCount;
+		NextJobIndex.store(0);
+		++Generation;
+	}
+	WorkCondition.notify_all();
+
+	// 호출한 스레드도 같이 처리함
+	RunJobs(job, jobCount);
+
+	// 워커가 작업 인덱스를 가져가는 도중에 다음 ParallelFor 가 NextJobIndex 를 초기화하면 안되므로 워커가 모두 빠져나올때까지 기다림
+	std::unique_lock<std::mutex> lock(Mutex);
+	DoneCondition.wait(lock, [this]() { return (RemainingJobs == 0) && (ActiveWorkers == 0); });
+	Job = nullptr;
+	JobCount = 0;
+}
+
+void jThreadPool::WorkerMain()
+{
+	uint64_t lastGeneration = 0;
+	while (true)
+	{
+		const std::function<void(uint32_t)>* job = nullptr;
+		uint32_t jobCount = 0;
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			WorkCondition.wait(lock, [&]() { return ExitRequested || (Job && (Generation != lastGeneration)); });
+			if (ExitRequested)
+				return;
+
+			lastGeneration = Generation;
+			job = Job;
+			jobCount = JobCount;
+			++ActiveWorkers;
+		}
+
+		RunJobs(*job, jobCount);
+
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			--ActiveWorkers;
+		}
+		DoneCondition.notify_one();
+	}
+}
+
+void jThreadPool::RunJobs(const std::function<void(uint32_t)>& job, uint32_t jobCount)
+{
+	while (true)
+	{
+		const uint32_t jobIndex = NextJobIndex.fetch_add(1);
+		if (jobIndex >= jobCount)
+			break;
+
+		job(jobIndex);
+
+		std::lock_guard<std::mutex> lock(Mutex);
+		--RemainingJobs;
+	}
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+// 고정된 수의 워커 스레드를 미리 만들어두고, 여러개의 작업을 나눠서 실행하는 스레드 풀.
+// 매번 std::thread 를 만들지 않으므로 프레임마다 호출해도 됨.
+//
+// - ParallelFor 를 호출한 스레드도 작업을 같이 처리하므로 워커가 0 개여도 동작함.
+// - 작업 인덱스는 [0, jobCount) 이고 각 인덱스는 정확히 한번만 실행됨. 어느 스레드에서 실행될지는 정해져 있지 않으므로
+//   스레드별 리소스(ex. Command pool) 는 스레드가 아니라 작업 인덱스 별로 준비해야 함.
+// - ParallelFor 는 한 스레드에서만 호출해야 함.
+class jThreadPool
+{
+public:
+	~jThreadPool() { Release(); }
+
+	void Initialize(uint32_t workerCount);
+	void Release();
+
+	// 모든 작업이 끝날때까지 기다림
+	void ParallelFor(uint32_t jobCount, const std::function<void(uint32_t)>& job);
+
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(Workers.size()); }
+
+private:
+	void WorkerMain();
+	void RunJobs(const std::function<void(uint32_t)>& job, uint32_t jobCount);
+
+	std::vector<std::thread> Workers;
+	std::mutex Mutex;
+	std::condition_variable WorkCondition;
+	std::condition_variable DoneCondition;
+
+	// 아래는 Mutex 로 보호됨
+	const std::function<void(uint32_t)>* Job = nullptr;
+	uint32_t JobCount = 0;
+	uint32_t RemainingJobs = 0;
+	uint32_t ActiveWorkers = 0;		// 작업 인덱스를 가져가고 있는 워커 수. 0 이 되어야 다음 ParallelFor 를 시작할 수 있음
+	uint64_t Generation = 0;
+	bool ExitRequested = false;
+
+	std::atomic<uint32_t> NextJobIndex{ 0 };
+};
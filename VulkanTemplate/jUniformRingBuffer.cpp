@@ -0,0 +1,49 @@
+﻿#include <pch.h>
+#include "jUniformRingBuffer.h"
+
+#include <algorithm>
+#include "jAssert.h"
+#include "Generic/TemplateUtility.h"
+
+void jUniformRingBuffer::Initialize(VkBuffer buffer, void* mappedData, VkDeviceSize frameSize, uint32_t frameCount, VkDeviceSize minOffsetAlignment)
+{
+	// Aligned 는 2의 승수만 처리가능, minUniformBufferOffsetAlignment 는 항상 2의 승수임
+	Alignment = std::max<VkDeviceSize>(minOffsetAlignment, 1);
+	JASSERT((Alignment & (Alignment - 1)) == 0);
+
+	Buffer = buffer;
+	MappedData = static_cast<uint8_t*>(mappedData);
+	FrameSize = Aligned(frameSize, Alignment);
+	FrameCount = frameCount;
+
+	FrameBase = 0;
+	FrameOffset = 0;
+}
+
+void jUniformRingBuffer::BeginFrame(uint32_t frameIndex)
+{
+	JASSERT(frameIndex < FrameCount);
+	FrameBase = FrameSize * frameIndex;
+	FrameOffset = 0;
+}
+
+bool jUniformRingBuffer::Allocate(VkDeviceSize size, jUniformAllocation& outAllocation)
+{
+	const VkDeviceSize offset = Aligned(FrameOffset, Alignment);
+	if (size == 0 || (offset + size) > FrameSize)
+		return false;
+
+	FrameOffset = offset + size;
+
+	outAllocation.Buffer = Buffer;
+	outAllocation.Offset = static_cast<uint32_t>(FrameBase + offset);
+	outAllocation.Size = size;
+	outAllocation.MappedData = MappedData + FrameBase + offset;
+	return true;
+}
+
+VkDeviceSize jUniformRingBuffer::GetRequiredSize(VkDeviceSize frameSize, uint32_t frameCount, VkDeviceSize minOffsetAlignment)
+{
+	const VkDeviceSize alignment = std::max<VkDeviceSize>(minOffsetAlignment, 1);
+	return Aligned(frameSize, alignment) * frameCount;
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// jUniformRingBuffer 에서 받은 영역. Offset 은 VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC 의 Dynamic offset 으로 그대로 사용함.
+struct jUniformAllocation
+{
+	VkBuffer Buffer = VK_NULL_HANDLE;
+	uint32_t Offset = 0;
+	VkDeviceSize Size = 0;
+	void* MappedData = nullptr;		// Buffer 의 Offset 위치를 가리키는 포인터
+};
+
+// 계속 Map 되어있는 하나의 Uniform 버퍼를 프레임 수 만큼 구간으로 나누고, 각 구간 안에서는 Bump pointer 로 할당하는 클래스.
+// 매 프레임 vkMapMemory / vkUnmapMemory 없이 오브젝트 마다의 Uniform 데이터를 바로 쓸 수 있음.
+//
+// 사용법
+// 1. 프레임 시작시 BeginFrame(frameIndex) 로 해당 프레임의 구간을 비움. (해당 구간을 사용하던 GPU 작업이 끝난 이후여야 함)
+// 2. Allocate / Write 로 영역을 받아서 쓰고, Descriptor set 을 바인딩 할때 Offset 을 Dynamic offset 으로 넘김.
+//    Descriptor 는 Buffer 의 0 ~ range 를 가리키도록 한번만 업데이트 해두면 됨.
+class jUniformRingBuffer
+{
+public:
+	// minOffsetAlignment : VkPhysicalDeviceLimits::minUniformBufferOffsetAlignment
+	void Initialize(VkBuffer buffer, void* mappedData, VkDeviceSize frameSize, uint32_t frameCount, VkDeviceSize minOffsetAlignment);
+
+	void BeginFrame(uint32_t frameIndex);
+	bool Allocate(VkDeviceSize size, jUniformAllocation& outAllocation);
+
+	template <typename T>
+	bool Write(const T& data, jUniformAllocation& outAllocation)
+	{
+		if (!Allocate(sizeof(T), outAllocation))
+			return false;
+
+		memcpy(outAllocation.MappedData, &data, sizeof(T));
+		return true;
+	}
+
+	VkBuffer GetBuffer() const { return Buffer; }
+	VkDeviceSize GetFrameSize() const { return FrameSize; }
+	VkDeviceSize GetFrameUsedSize() const { return FrameOffset; }
+	VkDeviceSize GetAlignment() const { return Alignment; }
+	uint32_t GetFrameBaseOffset(uint32_t frameIndex) const { return static_cast<uint32_t>(FrameSize * frameIndex); }
+
+	// frameSize 를 alignment 에 맞춘 뒤 frameCount 만큼 필요한 전체 크기
+	static VkDeviceSize GetRequiredSize(VkDeviceSize frameSize, uint32_t frameCount, VkDeviceSize minOffsetAlignment);
+
+private:
+	VkBuffer Buffer = VK_NULL_HANDLE;
+	uint8_t* MappedData = nullptr;
+	VkDeviceSize FrameSize = 0;
+	uint32_t FrameCount = 0;
+	VkDeviceSize Alignment = 1;
+
+	VkDeviceSize FrameBase = 0;			// 현재 프레임 구간의 시작 위치
+	VkDeviceSize FrameOffset = 0;		// 현재 프레임 구간 안에서 다음 할당 위치
+};
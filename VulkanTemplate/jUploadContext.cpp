@@ -0,0 +1,152 @@
+﻿#include <pch.h>
+#include "jUploadContext.h"
+
+#include "jAssert.h"
+
+bool jUploadContext::Initialize(VkDevice device, jQueueTimeline& timeline, uint32_t queueFamilyIndex)
+{
+	Device = device;
+	Timeline = &timeline;
+
+	// 배치마다 커맨드 버퍼를 개별적으로 다시 기록하므로 RESET_COMMAND_BUFFER 가 필요함
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = queueFamilyIndex;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	return ensure(vkCreateCommandPool(Device, &poolInfo, nullptr, &CommandPool) == VK_SUCCESS);
+}
+
+void jUploadContext::Release()
+{
+	if (!Device)
+		return;
+
+	// 기록만 하고 제출하지 않은 커맨드도 버리지 않고 마무리함
+	Wait(Submit());
+	FreeBatches.clear();
+
+	// 커맨드 버퍼는 Pool 과 함께 소멸됨
+	if (CommandPool)
+		vkDestroyCommandPool(Device, CommandPool, nullptr);
+	CommandPool = VK_NULL_HANDLE;
+	Timeline = nullptr;
+	Device = VK_NULL_HANDLE;
+}
+
+VkCommandBuffer jUploadContext::GetCommandBuffer()
+{
+	if (Current.CommandBuffer)
+		return Current.CommandBuffer;
+
+	jBatch batch;
+	if (!ensure(GrabBatch(batch)))
+		return VK_NULL_HANDLE;
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	if (!ensure(vkBeginCommandBuffer(batch.CommandBuffer, &beginInfo) == VK_SUCCESS))
+	{
+		FreeBatches.push_back(batch);
+		return VK_NULL_HANDLE;
+	}
+
+	Current = batch;
+	return Current.CommandBuffer;
+}
+
+void jUploadContext::AddWaitSemaphore(VkSemaphore timelineSemaphore, uint64_t value, VkPipelineStageFlags waitStage)
+{
+	// 기록된 커맨드가 없어도 기다림이 빠지지 않도록 배치를 시작해둠
+	if (!ensure(GetCommandBuffer()))
+		return;
+
+	jSemaphoreWait wait;
+	wait.Semaphore = timelineSemaphore;
+	wait.Value = value;
+	wait.Stage = waitStage;
+	Waits.push_back(wait);
+}
+
+uint64_t jUploadContext::Submit()
+{
+	if (!Current.CommandBuffer)
+		return LastSubmittedValue;
+
+	jBatch batch = Current;
+	Current = jBatch();
+
+	// 제출 순서는 실행 순서만 보장하므로, 복사 결과가 이후에 제출되는 커맨드(Vertex input, Shader 등) 에 보이도록 배치 끝에 Barrier 를 넣어줌
+	VkMemoryBarrier memoryBarrier = {};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+	vkCmdPipelineBarrier(batch.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0
+		, 1, &memoryBarrier
+		, 0, nullptr
+		, 0, nullptr);
+
+	vkEndCommandBuffer(batch.CommandBuffer);
+
+	jQueueSubmitInfo submitInfo;
+	submitInfo.CommandBuffers = &batch.CommandBuffer;
+	submitInfo.CommandBufferCount = 1;
+	submitInfo.Waits = Waits.data();
+	submitInfo.WaitCount = static_cast<uint32_t>(Waits.size());
+	const uint64_t value = Timeline->Submit(submitInfo);
+	Waits.clear();
+	if (!value)
+	{
+		FreeBatches.push_back(batch);
+		return LastSubmittedValue;
+	}
+
+	batch.Value = value;
+	LastSubmittedValue = value;
+	PendingBatches.push_back(batch);
+	++SubmitCount;
+	return value;
+}
+
+bool jUploadContext::Wait(uint64_t value)
+{
+	if (!Timeline->Wait(value))
+		return false;
+
+	RecycleBatches(value);
+	return true;
+}
+
+uint64_t jUploadContext::Poll()
+{
+	const uint64_t completedValue = Timeline->GetCompletedValue();
+	RecycleBatches(completedValue);
+	return completedValue;
+}
+
+void jUploadContext::RecycleBatches(uint64_t completedValue)
+{
+	while (!PendingBatches.empty() && (PendingBatches.front().Value <= completedValue))
+	{
+		FreeBatches.push_back(PendingBatches.front());
+		PendingBatches.pop_front();
+	}
+}
+
+bool jUploadContext::GrabBatch(jBatch& outBatch)
+{
+	if (!FreeBatches.empty())
+	{
+		outBatch = FreeBatches.back();
+		FreeBatches.pop_back();
+		vkResetCommandBuffer(outBatch.CommandBuffer, 0);
+		return true;
+	}
+
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = CommandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+	return (vkAllocateCommandBuffers(Device, &allocInfo, &outBatch.CommandBuffer) == VK_SUCCESS);
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include "jQueueTimeline.h"
+
+// 업로드용 커맨드(버퍼 복사, 이미지 복사, 레이아웃 전환, 밉맵 생성) 를 하나의 커맨드 버퍼에 모아서 한번에 제출하는 클래스.
+// 업로드마다 커맨드 버퍼를 할당하고 vkQueueWaitIdle 로 기다리지 않아도 됨.
+//
+// 사용법
+// 1. GetCommandBuffer 로 현재 배치의 커맨드 버퍼를 얻어서 커맨드를 기록함. 처음 요청될때 Begin 됨.
+// 2. Submit 으로 지금까지 기록한 커맨드를 제출하고, 이 배치의 값(value) 을 받음. 값은 Queue 의 Timeline 값이라 같은 Queue 의 다른 제출과 같은 기준임.
+// 3. 업로드한 리소스나 Staging 메모리를 CPU 에서 다시 써야 할때만 Wait(value) 또는 IsComplete(value) 로 확인함.
+//    같은 Queue 에 나중에 제출한 커맨드는 제출 순서에 의해 업로드 커맨드의 Barrier 이후에 실행되므로 따로 기다릴 필요 없음.
+//
+// 다른 Queue(ex. 전용 Transfer queue) 의 업로드를 기다려야 하는 경우
+// - AddWaitSemaphore(다른 Queue 의 Timeline semaphore, value, stage) 로 다음 제출이 그 값을 기다리게 함.
+class jUploadContext
+{
+public:
+	bool Initialize(VkDevice device, jQueueTimeline& timeline, uint32_t queueFamilyIndex);
+	void Release();
+
+	VkCommandBuffer GetCommandBuffer();
+	bool HasPendingCommands() const { return !!Current.CommandBuffer; }
+
+	// 현재 배치를 제출할때 timelineSemaphore 가 value 가 될때까지 기다림. 현재 배치가 없으면 새로 시작함.
+	void AddWaitSemaphore(VkSemaphore timelineSemaphore, uint64_t value, VkPipelineStageFlags waitStage);
+
+	// 기록된 커맨드가 없으면 아무것도 제출하지 않고 마지막으로 제출한 값을 돌려줌
+	uint64_t Submit();
+
+	bool Wait(uint64_t value);
+	bool IsComplete(uint64_t value) { return value <= Poll(); }
+
+	// 완료된 배치들을 재사용 목록으로 돌려놓고, Queue 에서 완료된 가장 큰 값을 돌려줌
+	uint64_t Poll();
+
+	uint64_t GetLastSubmittedValue() const { return LastSubmittedValue; }
+	uint32_t GetSubmitCount() const { return SubmitCount; }
+	jQueueTimeline* GetTimeline() const { return Timeline; }
+
+private:
+	struct jBatch
+	{
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+		uint64_t Value = 0;
+	};
+
+	bool GrabBatch(jBatch& outBatch);
+	void RecycleBatches(uint64_t completedValue);
+
+	VkDevice Device = VK_NULL_HANDLE;
+	jQueueTimeline* Timeline = nullptr;
+	VkCommandPool CommandPool = VK_NULL_HANDLE;
+
+	jBatch Current;						// 기록중인 배치, 기록중이 아니면 CommandBuffer 가 VK_NULL_HANDLE
+	std::deque<jBatch> PendingBatches;	// 제출 순서대로 들어있음
+	std::vector<jBatch> FreeBatches;
+	std::vector<jSemaphoreWait> Waits;	// 다음 Submit 에서 기다릴 세마포어들
+
+	uint64_t LastSubmittedValue = 0;
+	uint32_t SubmitCount = 0;
+};
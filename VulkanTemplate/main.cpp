@@ -16,6 +16,12 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include "jStagingRing.h"
+
+// stb_image 가 디코딩 결과를 Staging ring 에 바로 쓸 수 있도록 할당자를 연결함. (jImageDecodeTarget 참고)
+#define STBI_MALLOC(sz) jImageDecodeTarget::Malloc(sz)
+#define STBI_REALLOC(p, newsz) jImageDecodeTarget::Realloc(p, newsz)
+#define STBI_FREE(p) jImageDecodeTarget::Free(p)
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
@@ -39,11 +45,30 @@
 #include "jAssert.h"
 #include "jSimpleType.h"
 #include "Camera.h"
+#include "jSamplerCache.h"
+#include "jMemoryAllocator.h"
+#include "jDeviceCapabilities.h"
+#include "jUniformRingBuffer.h"
+#include "jBindlessDescriptorSet.h"
+#include "jDescriptorAllocator.h"
+#include "jDescriptorSetLayoutCache.h"
+#include "jThreadPool.h"
+#include "jQueueTimeline.h"
+#include "jUploadContext.h"
+#include "jDeletionQueue.h"
+#include "jPipelineCache.h"
+#include "jPipelineStateCache.h"
+#include "jShaderCache.h"
+#include "jShaderReflection.h"
+#include "jFileWatcher.h"
+#include "jMaterial.h"
 #include <unordered_map>
 #include <type_traits>
 #include <algorithm>
 
-#define MULTIPLE_FRAME 1
+#define BINDLESS_DESCRIPTOR 1		// 디바이스가 지원하지 않으면 Instance stream 경로로 그림
+#define DEDICATED_TRANSFER_QUEUE 1	// 전용 Transfer queue 가 없으면 Graphics queue 로 업로드함
+#define INDIRECT_DRAW 1				// 디바이스가 지원하면 Indirect 드로우로 그림 (I 키로 방식을 바꿀 수 있음). 0 이면 항상 배치 마다 vkCmdDrawIndexed
 #define VALIDATION_LAYER_VERBOSE 0
 
 struct jVertex
@@ -158,13 +183,137 @@ namespace std
 //	Matrix View;					|			mat4 view;
 //	Matrix Proj;					|			mat4 proj
 //};								|		};
+// 쉐이더 블럭과 레이아웃이 같은지는 시작할때 SPIR-V reflection 으로 확인함 (ValidateShaderLayouts)
 struct jUniformBufferObject
 {
-	Matrix Model;
 	Matrix View;
 	Matrix Proj;
 };
 
+// Bindless 가 아닌 경로에서 인스턴스 마다 두번째 버택스 바인딩으로 넘기는 데이터. (VK_VERTEX_INPUT_RATE_INSTANCE)
+// 쉐이더에서는 mat4 하나가 vec4 4개로 나뉘어 location 을 4개 사용함.
+struct jInstanceData
+{
+	Matrix Model;
+
+	static constexpr uint32_t Binding = 1;
+	static constexpr uint32_t FirstLocation = 3;		// jVertex 의 location 0 ~ 2 다음
+
+	static VkVertexInputBindingDescription GetBindingDescription()
+	{
+		VkVertexInputBindingDescription bindingDescription = {};
+		bindingDescription.binding = Binding;
+		bindingDescription.stride = sizeof(jInstanceData);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;		// 인스턴스 마다 다음 데이터로 이동
+		return bindingDescription;
+	}
+
+	static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions()
+	{
+		// Model 은 쉐이더에서 읽는 그대로(Column-major) 들어있으므로 column 하나가 location 하나가 됨
+		std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions = {};
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			attributeDescriptions[i].binding = Binding;
+			attributeDescriptions[i].location = FirstLocation + i;
+			attributeDescriptions[i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[i].offset = static_cast<uint32_t>(offsetof(jInstanceData, Model) + sizeof(float) * 4 * i);
+		}
+		return attributeDescriptions;
+	}
+};
+
+// 화면에 그릴 오브젝트. 현재는 모두 같은 메시(vertexBuffer, indexBuffer) 를 사용하고 Model 행렬만 다름.
+// 같은 머터리얼을 쓰는 오브젝트들은 jDrawBatch 로 묶어서 인스턴싱으로 한번에 그림.
+struct jRenderObject
+{
+	Matrix Model;
+	uint32_t TextureIndex = 0;		// Bindless 텍스쳐 배열의 인덱스
+	uint32_t MaterialIndex = 0;		// materials 의 인덱스. 머터리얼에 따라 그리는 파이프라인이 달라짐
+};
+
+// Bindless 경로에서 오브젝트 Storage buffer 에 들어가는 데이터. 쉐이더의 std430 ObjectData 와 같아야 함.
+// std430 에서 구조체 배열의 Stride 는 가장 큰 멤버(mat4 -> vec4) 정렬인 16 의 배수가 되므로 패딩을 넣어줌.
+struct jObjectData
+{
+	Matrix Model;
+	uint32_t TextureIndex = 0;
+	uint32_t Padding[3] = {};
+};
+static_assert(sizeof(jObjectData) % 16 == 0, "jObjectData must match std430 array stride");
+
+// 메시와 머터리얼이 같은 연속된 오브젝트들. vkCmdDrawIndexed 한번에 InstanceCount 개를 그림.
+// 인스턴스 데이터는 renderObjects 와 같은 순서로 들어있으므로 FirstInstance 가 곧 renderObjects 의 인덱스임.
+// Bindless 경로는 오브젝트 버퍼 전체를 바인딩하므로 이번 프레임 구간의 시작 인덱스를 더해서 그림.
+struct jDrawBatch
+{
+	uint32_t MaterialIndex = 0;
+	uint32_t FirstInstance = 0;
+	uint32_t InstanceCount = 0;
+};
+
+// 드로우를 기록하는 방법. 디바이스가 지원하는 방식 중 CPU 부담이 가장 적은 것으로 시작하며 I 키로 바꿀 수 있음.
+namespace jDrawSubmitMode
+{
+	enum Type : uint32_t
+	{
+		Direct,			// 배치 마다 vkCmdDrawIndexed
+		IndirectCpu,	// CPU 가 배치 마다 VkDrawIndexedIndirectCommand 를 쓰고, 파이프라인이 같은 연속된 배치는 vkCmdDrawIndexedIndirect 한번으로 그림
+		IndirectGpu,	// Compute 쉐이더(cull.comp) 가 오브젝트를 컬링하고 커맨드를 씀. 기록하는 드로우 수는 배치 수와 같고 오브젝트 수와는 상관없음
+		Count
+	};
+}
+
+// GPU 컬링의 배치 정보. 쉐이더의 CullBatch 와 같아야 하며, DrawCount 는 vkCmdDrawIndexedIndirectCount 의 Count buffer 로 그대로 씀.
+struct jCullBatch
+{
+	uint32_t FirstInstance = 0;
+	uint32_t InstanceCount = 0;
+	uint32_t DrawCount = 0;			// 쉐이더가 보이는 오브젝트 수 만큼 늘림. 0 으로 초기화해서 넘김
+	uint32_t Padding = 0;
+};
+
+// cull.comp 의 Push constant. 쉐이더의 CullConstants 와 같아야 함.
+struct jCullConstants
+{
+	Matrix ViewProj;
+	float BoundingSphere[4] = {};	// 메시 로컬 공간의 중심(xyz) 과 반지름(w)
+	uint32_t ObjectCount = 0;
+	uint32_t BatchCount = 0;
+	uint32_t ObjectStride = 0;		// Model 행렬 버퍼에서 오브젝트 하나의 크기 (vec4 단위)
+	uint32_t IndexCount = 0;
+	uint32_t Compact = 0;			// 1 이면 보이는 것만 앞으로 모으고 DrawCount 를 씀 (vkCmdDrawIndexedIndirectCount)
+	uint32_t BaseInstance = 0;		// Model 행렬 버퍼에서 첫 오브젝트의 인덱스. 드로우 커맨드의 firstInstance 에도 더함.
+};
+
+// 이번 프레임의 Indirect 드로우 데이터 (UpdateIndirectBuffer). Commands 가 비어있으면 Direct 로 그림.
+struct jIndirectDraws
+{
+	jUniformAllocation Commands;	// VkDrawIndexedIndirectCommand 배열. IndirectCpu 는 배치 마다, IndirectGpu 는 오브젝트 마다 하나
+	jUniformAllocation Batches;		// IndirectGpu 에서만 사용. drawBatches 와 같은 순서의 jCullBatch 배열
+};
+
+// 동시에 진행될 수 있는 프레임(Frame in flight) 마다 따로 가지는 리소스.
+// 해당 프레임의 펜스를 기다린 뒤에는 GPU 가 더 이상 사용하지 않으므로 개별로 해제하지 않고 통째로 Reset 해서 다시 씀.
+struct jFrameContext
+{
+	uint64_t SubmitValue = 0;							// 이 Frame context 를 마지막으로 제출한 Graphics timeline 값. 다시 쓰기 전에 이 값을 기다림
+	VkSemaphore ImageAvailableSemaphore = VK_NULL_HANDLE;	// 스왑체인 이미지 획득 -> 렌더링 (바이너리)
+	VkSemaphore RenderFinishedSemaphore = VK_NULL_HANDLE;	// 렌더링 -> Present (바이너리, Present 는 Timeline semaphore 를 기다릴 수 없음)
+
+	VkCommandPool CommandPool = VK_NULL_HANDLE;			// TRANSIENT Pool. 매 프레임 vkResetCommandPool 로 커맨드 버퍼까지 한번에 리셋함
+	VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;		// 매 프레임 다시 기록하는 Primary 커맨드 버퍼
+	jDescriptorAllocator DescriptorAllocator;			// 이 프레임에서만 사용하는 Descriptor set
+
+	// 멀티스레드 기록용. Command pool 은 동시에 여러 스레드에서 사용할 수 없으므로 기록 작업마다 Pool 을 따로 가짐.
+	struct jRecordContext
+	{
+		VkCommandPool CommandPool = VK_NULL_HANDLE;
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;	// Secondary 커맨드 버퍼
+	};
+	std::vector<jRecordContext> RecordContexts;
+};
+
 class HelloTriangleApplication
 {
 public:
@@ -173,10 +322,53 @@ public:
 	
 	const std::string MODEL_PATH = "models/chalet.obj";
 	const std::string TEXTURE_PATH = "textures/chalet.jpg";
-
-#if MULTIPLE_FRAME
-	static constexpr int32_t MAX_FRAMES_IN_FLIGHT = 2;
-#endif // MULTIPLE_FRAME
+	const std::string PIPELINE_CACHE_PATH = "pipeline_cache.bin";		// 실행할때 읽고 종료할때 저장함
+	const std::string SHADER_SOURCE_PATH = "Shaders";					// 이 디렉토리의 쉐이더 소스가 바뀌면 Hot reload 함
+	const std::string SHADER_CACHE_PATH = "Shaders/Cache";				// 실행중에 컴파일한 SPIR-V 를 저장하는 곳
+	const std::string CULL_SHADER_PATH = "Shaders/cull.comp";			// IndirectGpu 에서 컬링하고 드로우 커맨드를 채우는 Compute 쉐이더
+
+	// 업로드에 사용할 Staging ring 의 크기. 한번에 업로드하는 리소스 중 가장 큰 것보다 커야함. (chalet.jpg 는 4096x4096 RGBA = 64MB)
+	static constexpr VkDeviceSize STAGING_RING_SIZE = 128 * 1024 * 1024;
+	// vkCmdCopyBufferToImage 의 bufferOffset 은 텍셀 크기의 배수여야 함. optimalBufferCopyOffsetAlignment 를 고려해 넉넉하게 잡음.
+	static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+	// Uniform ring buffer 의 프레임당 구간 크기. minUniformBufferOffsetAlignment 가 256 이면 오브젝트 4096 개 분량의 Uniform block 을 쓸 수 있음.
+	static constexpr VkDeviceSize UNIFORM_RING_FRAME_SIZE = 1024 * 1024;
+
+	// 인스턴스 버퍼의 프레임당 구간 크기. jInstanceData 가 64 bytes 이므로 프레임당 131072 개의 인스턴스를 그릴 수 있음.
+	// Bindless 경로는 같은 크기의 구간에 jObjectData(80 bytes) 를 쓰므로 프레임당 104857 개까지 그릴 수 있음.
+	static constexpr VkDeviceSize INSTANCE_RING_FRAME_SIZE = 8 * 1024 * 1024;
+
+	// Indirect 드로우 버퍼의 프레임당 구간 크기. IndirectGpu 는 오브젝트 마다 커맨드(20 bytes) 를 쓰므로 프레임당 약 200000 개의 오브젝트를 그릴 수 있음.
+	static constexpr VkDeviceSize INDIRECT_RING_FRAME_SIZE = 4 * 1024 * 1024;
+	static constexpr uint32_t CULL_WORKGROUP_SIZE = 64;		// cull.comp 의 local_size_x
+
+	// Bindless descriptor set 의 텍스쳐 배열 크기
+	static constexpr uint32_t BINDLESS_MAX_TEXTURES = 1024;
+
+	// 드로우(jDrawBatch) 가 많으면 여러 작업으로 나눠서 Secondary 커맨드 버퍼에 동시에 기록함.
+	// 작업 하나당 드로우가 너무 적으면 Secondary 커맨드 버퍼를 시작하고 실행하는 비용이 더 크므로 최소 개수를 둠.
+	static constexpr uint32_t MAX_RECORD_JOBS = 16;
+	static constexpr uint32_t MIN_DRAWS_PER_RECORD_JOB = 256;
+
+	static constexpr uint32_t COMMAND_RECORD_BENCHMARK_DRAWS = 50000;
+	static constexpr uint32_t COMMAND_RECORD_BENCHMARK_ITERATIONS = 20;
+
+	// 동시에 진행할 수 있는 프레임 수. 실행 중에 SetFramesInFlight 나 숫자키 1 ~ MAX_FRAMES_IN_FLIGHT 로 바꿀 수 있음.
+	// 1 이면 매 프레임 이전 프레임이 끝날때까지 기다림.
+	static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+	static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+	// 새로운 파이프라인 조합을 백그라운드에서 컴파일하는 스레드 수
+	static constexpr uint32_t PIPELINE_COMPILE_WORKER_COUNT = 1;
+
+	// M 키로 돌아가며 적용해보는 머터리얼 기능 조합. 처음 쓰일때 백그라운드에서 파이프라인 변형이 만들어짐.
+	static constexpr uint32_t MATERIAL_VARIANTS[] = {
+		jMaterialFeature::Texture,
+		jMaterialFeature::Texture | jMaterialFeature::VertexColor,
+		jMaterialFeature::VertexColor,
+		jMaterialFeature::Texture | jMaterialFeature::AlphaTest,
+	};
 
 	const std::vector<const char*> validationLayers = {
 		"VK_LAYER_KHRONOS_validation"
@@ -228,28 +420,51 @@ public:
 		return VK_FALSE;
 	}
 
-	static std::vector<char> ReadFile(const std::string& filename)
+	static void framebufferResizeCallback(GLFWwindow* window, int width, int height)
 	{
-		// 1. std::ios::ate : 파일의 끝에서 부터 읽기 시작한다. (파일의 끝에서 부터 읽어서 파일의 크기를 얻어 올수 있음)
-		// 2. std::ios::binary : 바이너리 파일로서 파일을 읽음. (text transformations 을 피함)
-		std::ifstream file(filename, std::ios::ate | std::ios::binary);
+		auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+		app->framebufferResized = true;
+	}
 
-		if (!ensure(file.is_open()))
-			return std::vector<char>();
+	static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+	{
+		auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+		if ((action == GLFW_PRESS) && (key >= GLFW_KEY_1) && (key <= GLFW_KEY_9))
+			app->SetFramesInFlight(static_cast<uint32_t>(key - GLFW_KEY_0));
+		if ((action == GLFW_PRESS) && (key == GLFW_KEY_W))
+			app->wireframe = !app->wireframe;
+		if ((action == GLFW_PRESS) && (key == GLFW_KEY_M))
+			app->CycleMaterialVariant();
+		if ((action == GLFW_PRESS) && (key == GLFW_KEY_I))
+			app->CycleDrawSubmitMode();
+	}
 
-		size_t fileSize = (size_t)file.tellg();
-		std::vector<char> buffer(fileSize);
+	// 첫번째 머터리얼의 기능 조합을 MATERIAL_VARIANTS 의 다음 것으로 바꿈. 파이프라인은 다음 DrawFrame 에서 요청됨.
+	void CycleMaterialVariant()
+	{
+		if (materials.empty())
+			return;
 
-		file.seekg(0);		// 파일의 맨 첨으로 이동
-		file.read(buffer.data(), fileSize);
-		file.close();
-		return buffer;
+		materialVariantIndex = (materialVariantIndex + 1) % static_cast<uint32_t>(std::size(MATERIAL_VARIANTS));
+		materials[0].Features = MATERIAL_VARIANTS[materialVariantIndex];
+		materialPipelines[0] = INVALID_PIPELINE_HANDLE;
+		std::cout << "Material : " << materials[0].GetFeatureString() << std::endl;
 	}
 
-	static void framebufferResizeCallback(GLFWwindow* window, int width, int height)
+	// 지원하는 드로우 방식 중 다음 것으로 바꿈. 다음 DrawFrame 부터 적용됨.
+	void CycleDrawSubmitMode()
 	{
-		auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
-		app->framebufferResized = true;
+		do
+		{
+			drawSubmitMode = (drawSubmitMode + 1) % jDrawSubmitMode::Count;
+		} while (!IsDrawSubmitModeSupported(drawSubmitMode));
+		std::cout << "Draw submit : " << GetDrawSubmitModeString(drawSubmitMode) << std::endl;
+	}
+
+	// 다음 DrawFrame 에서 적용됨. [1, MAX_FRAMES_IN_FLIGHT] 로 제한함.
+	void SetFramesInFlight(uint32_t count)
+	{
+		requestedFramesInFlight = std::max(1u, std::min(count, MAX_FRAMES_IN_FLIGHT));
 	}
 
 	void Run()
@@ -259,6 +474,15 @@ public:
 		Cleanup();
 	}
 
+	// Bindless 를 지원하는 디바이스에서도 Instance stream 경로로 그리게 함. (Fallback 경로 확인용)
+	void SetBindlessAllowed(bool allowed) { bindlessAllowed = allowed; }
+
+	// 0 이 아니면 frameCount 만큼 그린 뒤 종료함. (자동 실행 확인용)
+	void SetExitFrameCount(uint32_t frameCount) { exitFrameCount = frameCount; }
+
+	// 초기화가 끝나면 작업(스레드) 수 별로 커맨드 버퍼 기록 시간을 측정해서 출력함
+	void SetRecordBenchmark(bool enable) { recordBenchmark = enable; }
+
 private:
 	void InitWindow()
 	{
@@ -270,6 +494,7 @@ private:
 		window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan window", nullptr, nullptr);
 		glfwSetWindowUserPointer(window, this);
 		glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);		// static function 밖에 안됨.(멤버함수 호출불가)
+		glfwSetKeyCallback(window, keyCallback);
 	}
 
 	void InitVulkan()
@@ -284,31 +509,47 @@ private:
 		CreateSwapChain();			// 6
 		CreateImageViews();			// 7
 		CreateRenderPass();			// 8
-		CreateDescriptorSetLayout();// 9
-		CreateGraphicsPipeline();	// 10
-		CreateCommandPool();		// 11
-		CreateColorResources();		// 12
-		CreateDepthResources();		// 13
-		CreateFrameBuffers();		// 14
-		CreateTextureImage();		// 15
-		CreateTextureImageView();	// 16
-		CreateTextureSampler();		// 17
-		LoadModel();				// 18
-		CreateVertexBuffer();		// 19
-		CreateIndexBuffer();		// 20
-		CreateUniformBuffers();		// 21
-		CreateDescriptorPool();		// 22
-		CreateDescriptorSets();		// 23
-		CreateCommandBuffers();		// 24
-		CreateSyncObjects();		// 25
+		// 쉐이더와 C++ 구조체의 레이아웃이 다르면 잘못된 데이터로 그리게 되므로 더 진행하지 않음
+		if (!CreateDescriptorSetLayout())	// 9
+			throw std::runtime_error("failed to create descriptor set layout (shader layout mismatch)");
+		CreateBindlessDescriptors();// 10
+		CreateGraphicsPipeline();	// 11
+		CreateCullPipeline();		// 12
+		SelectDrawSubmitMode();		// 13
+		CreateUploadContext();		// 14
+		CreateStagingRing();		// 15
+		CreateColorResources();		// 16
+		CreateDepthResources();		// 17
+		CreateFrameBuffers();		// 18
+		CreateTextureImage();		// 19
+		CreateTextureImageView();	// 20
+		CreateTextureSampler();		// 21
+		LoadModel();				// 22
+		CreateRenderObjects();		// 23
+		CreateVertexBuffer();		// 24
+		CreateIndexBuffer();		// 25
+		CreateUniformBuffers();		// 26
+		CreateFrameContexts();		// 27
+		CreateSyncObjects();		// 28
+
+		// 초기화 중에 기록한 업로드(텍스쳐, 버텍스/인덱스 버퍼, 레이아웃 전환) 를 한번에 제출함.
+		// 같은 Queue 에 제출하므로 첫 프레임에서 따로 기다리지 않아도 됨.
+		SubmitUploads();
+
+		if (recordBenchmark)
+			BenchmarkCommandRecording();
 	}
 
 	void MainLoop()
 	{
+		uint32_t frameCount = 0;
 		while (!glfwWindowShouldClose(window))
 		{
 			glfwPollEvents();
 			DrawFrame();
+
+			if (exitFrameCount && (++frameCount >= exitFrameCount))
+				break;
 		}
 
 		// Logical device 가 작업을 모두 마칠때까지 기다렸다가 Destory를 진행할 수 있게 기다림.
@@ -317,34 +558,101 @@ private:
 
 	void Cleanup()
 	{
+		shaderWatcher.Release();
+
 		CleanupSwapChain();
 
-		vkDestroySampler(device, textureSampler, nullptr);
+		std::cout << "Pipeline state cache : " << pipelineStateCache.GetPipelineCount() << " pipelines, "
+			<< pipelineStateCache.GetHitCount() << " hits, " << pipelineStateCache.GetMissCount() << " misses, "
+			<< pipelineStateCache.GetAsyncCompileCount() << " async compiles (" << pipelineStateCache.GetAsyncCompileTotalMs() << " ms), "
+			<< pipelineStateCache.GetReloadCount() << " reloads" << std::endl;
+		pipelineStateCache.Release();
+
+		// 쉐이더 모듈은 파이프라인이 모두 만들어진 뒤에는 필요 없지만, 새 조합을 만들때 재사용하도록 끝까지 들고 있음
+		std::cout << "Shader cache : " << shaderCache.GetModuleCount() << " modules, " << shaderCache.GetCompileCount() << " compiled, "
+			<< shaderCache.GetDiskHitCount() << " loaded from disk, " << shaderCache.GetModuleHitCount() << " module reuses, "
+			<< shaderCache.GetRetiredCount() << " outdated modules retired" << std::endl;
+		shaderCache.Release();
+
+		// RenderPass 는 Framebuffer 가 모두 소멸된 뒤에 지워야 함
+		const uint64_t lastUsedValue = graphicsTimeline.GetLastSubmittedValue();
+		deletionQueue.PushPipelineLayout(lastUsedValue, pipelineLayout);
+		deletionQueue.PushRenderPass(lastUsedValue, renderPass);
+		deletionQueue.PushPipeline(lastUsedValue, cullPipeline);
+		deletionQueue.PushPipelineLayout(lastUsedValue, cullPipelineLayout);
+
+		// Sampler 는 Sampler cache 가 모두 소유하고 있음.
+		std::cout << "Sampler cache : " << samplerCache.GetSamplerCount() << " samplers, "
+			<< samplerCache.GetHitCount() << " hits, " << samplerCache.GetMissCount() << " misses" << std::endl;
+		samplerCache.Release();
+
 		vkDestroyImageView(device, textureImageView, nullptr);
 
 		vkDestroyImage(device, textureImage, nullptr);
-		vkFreeMemory(device, textureImageMemory, nullptr);
+		memoryAllocator.Free(textureImageMemory);
+
+		// Staging ring 의 메모리는 할당자가 Map 해둔 것이므로 따로 Unmap 하지 않음.
+		vkDestroyBuffer(device, stagingRingBuffer, nullptr);
+		memoryAllocator.Free(stagingRingBufferMemory);
+
+		bindlessDescriptors.Release();
+
+		DestroyUniformBuffers();
+
+		if (commandRecordCount > 0)
+		{
+			std::cout << "Command buffer recording : " << commandRecordCount << " frames, avg "
+				<< (commandRecordTotalMs / commandRecordCount) << " ms, max " << commandRecordMaxMs << " ms" << std::endl;
+		}
 
-		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+		size_t descriptorPoolCount = 0;
+		for (jFrameContext& frame : frameContexts)
+			descriptorPoolCount += frame.DescriptorAllocator.GetPoolCount();
+		DestroyFrameContexts();
+		std::cout << "Descriptor allocator : " << descriptorPoolCount << " pools" << std::endl;
+		std::cout << "Descriptor set layout cache : " << descriptorSetLayoutCache.GetLayoutCount() << " layouts, "
+			<< descriptorSetLayoutCache.GetHitCount() << " hits, " << descriptorSetLayoutCache.GetMissCount() << " misses" << std::endl;
+		descriptorSetLayoutCache.Release();
 
 		vkDestroyBuffer(device, indexBuffer, nullptr);
-		vkFreeMemory(device, indexBufferMemory, nullptr);
+		memoryAllocator.Free(indexBufferMemory);
 
 		vkDestroyBuffer(device, vertexBuffer, nullptr);
-		vkFreeMemory(device, vertexBufferMemory, nullptr);
+		memoryAllocator.Free(vertexBufferMemory);
+
+		std::cout << "Upload context : " << uploadContext.GetSubmitCount() << " graphics submits, "
+			<< transferUploadContext.GetSubmitCount() << " transfer submits" << std::endl;
+		transferUploadContext.Release();
+		uploadContext.Release();
+
+		std::cout << "Graphics timeline : " << graphicsTimeline.GetLastSubmittedValue() << " submits" << std::endl;
+		transferTimeline.Release();
+		graphicsTimeline.Release();
 
-#if MULTIPLE_FRAME
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		// Timeline 을 모두 기다렸으므로 남은 것들을 모두 지움
+		std::cout << "Deletion queue : " << deletionQueue.GetDeletedCount() << " deferred, " << deletionQueue.GetPendingCount() << " pending at exit" << std::endl;
+		deletionQueue.Release();
+
+		// 다음 실행에서 쓸 수 있도록 이번 실행에서 만든 파이프라인들이 포함된 캐시를 저장함
+		std::cout << "Pipeline cache : " << pipelineCache.GetCreateCount() << " created (" << pipelineCache.GetCreateTotalMs() << " ms)";
+		if (pipelineCache.IsCreationFeedbackEnabled())
 		{
-			vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
-			vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
-			vkDestroyFence(device, inFlightFences[i], nullptr);
+			std::cout << ", " << pipelineCache.GetColdCount() << " cold (" << pipelineCache.GetColdTotalMs() << " ms), "
+				<< pipelineCache.GetWarmCount() << " warm (" << pipelineCache.GetWarmTotalMs() << " ms)";
 		}
-#else
-		vkDestroySemaphore(device, renderFinishedSemaphore, nullptr);
-		vkDestroySemaphore(device, imageAvailableSemaphore, nullptr);
-#endif // MULTIPLE_FRAME
-		vkDestroyCommandPool(device, commandPool, nullptr);
+		std::cout << std::endl;
+		if (!pipelineCache.Save())
+			std::cout << "Pipeline cache : failed to save " << PIPELINE_CACHE_PATH << std::endl;
+		pipelineCache.Release();
+
+		// 모든 리소스의 메모리가 반환된 뒤에 Block 들을 해제해야 함.
+		for (uint32_t i = 0; i < memoryAllocator.GetHeapCount(); ++i)
+		{
+			const jMemoryHeapStats stats = memoryAllocator.GetHeapStats(i);
+			std::cout << "Memory heap " << i << " : " << stats.BlockCount << " blocks (" << stats.BlockBytes << " bytes), "
+				<< stats.DedicatedAllocationCount << " dedicated (" << stats.DedicatedBytes << " bytes)" << std::endl;
+		}
+		memoryAllocator.Release();
 
 		vkDestroyDevice(device, nullptr);
 
@@ -366,7 +674,9 @@ private:
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "No Engine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		// Descriptor indexing 을 코어 기능(VkPhysicalDeviceVulkan12Features) 으로 쓰기 위해 1.2 로 요청함.
+		// Timeline semaphore 도 1.2 기능이므로 1.2 를 지원하지 않는 디바이스는 IsDeviceSuitable 에서 제외함.
+		appInfo.apiVersion = VK_API_VERSION_1_2;
 
 		// Must
 		VkInstanceCreateInfo createInfo = {};
@@ -508,34 +818,68 @@ private:
 		std::vector<VkPhysicalDevice> devices(deviceCount);
 		vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
 
+		// 조건을 만족하는 디바이스 중 외장 GPU 를 우선함. 없으면 통합 GPU, 가상 GPU, CPU(lavapipe, SwiftShader) 순서로 선택.
+		int32_t bestPriority = -1;
 		for (const auto& device : devices)
 		{
-			if (IsDeviceSuitable(device))
+			if (!IsDeviceSuitable(device))
+				continue;
+
+			VkPhysicalDeviceProperties deviceProperties;
+			vkGetPhysicalDeviceProperties(device, &deviceProperties);
+
+			const int32_t priority = GetDeviceTypePriority(deviceProperties.deviceType);
+			if (priority > bestPriority)
 			{
 				physicalDevice = device;
-				msaaSamples = GetMaxUsableSampleCount();
-				break;
+				bestPriority = priority;
 			}
 		}
 
 		if (!ensure(physicalDevice != VK_NULL_HANDLE))
 			return false;
 
+		// 이후로는 PhysicalDevice 의 속성을 다시 조회하지 않고 캐시된 값을 사용함
+		deviceCapabilities.Initialize(physicalDevice, surface);
+		physicalDeviceQueueFamilies = findQueueFamilies(physicalDevice);
+		msaaSamples = deviceCapabilities.GetMaxUsableSampleCount();
+
+		std::cout << "Physical device : " << deviceCapabilities.GetProperties().deviceName << std::endl;
+
+		useBindless = BINDLESS_DESCRIPTOR && bindlessAllowed && deviceCapabilities.IsBindlessSupported(BINDLESS_MAX_TEXTURES);
+		std::cout << "Descriptor mode : " << (useBindless ? "Bindless" : "Instance stream") << std::endl;
+
+		useTransferQueue = DEDICATED_TRANSFER_QUEUE && physicalDeviceQueueFamilies.transferFamily.has_value();
+		std::cout << "Upload queue : " << (useTransferQueue ? "Dedicated transfer" : "Graphics") << std::endl;
+
+		// 파이프라인 캐시의 Cold / Warm 을 드라이버가 알려준 결과로 나눌 수 있음. 없으면 생성 시간만 집계함.
+		usePipelineCreationFeedback = deviceCapabilities.IsExtensionSupported(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+		std::cout << "Pipeline creation feedback : " << (usePipelineCreationFeedback ? "On" : "Off") << std::endl;
+
 		return true;
 	}
 
+	int32_t GetDeviceTypePriority(VkPhysicalDeviceType deviceType) const
+	{
+		switch (deviceType)
+		{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:		return 4;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:	return 3;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:		return 2;
+		case VK_PHYSICAL_DEVICE_TYPE_CPU:				return 1;
+		default:										return 0;
+		}
+	}
+
+	// 디바이스 종류는 보지 않음. 종류에 따른 우선순위는 PickPhysicalDevice 에서 판단함.
 	bool IsDeviceSuitable(VkPhysicalDevice device)
 	{
-		VkPhysicalDeviceProperties deviceProperties;
+		VkPhysicalDeviceProperties deviceProperties = {};
 		vkGetPhysicalDeviceProperties(device, &deviceProperties);
 
 		VkPhysicalDeviceFeatures deviceFeatures = {};
 		vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
 
-		// 현재는 Geometry Shader 지원 여부만 판단
-		if (deviceProperties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU || !deviceFeatures.geometryShader)
-			return false;
-
 		QueueFamilyIndices indices = findQueueFamilies(device);
 		bool extensionsSupported = CheckDeviceExtensionSupport(device);
 
@@ -546,13 +890,25 @@ private:
 			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 		}
 
-		return indices.IsComplete() && extensionsSupported && swapChainAdequate && deviceFeatures.samplerAnisotropy;
+		// 프레임과 업로드를 Timeline semaphore 로 동기화하므로 Vulkan 1.2 의 timelineSemaphore 가 필요함
+		if (deviceProperties.apiVersion < VK_API_VERSION_1_2)
+			return false;
+
+		VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		VkPhysicalDeviceFeatures2 features2 = {};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &vulkan12Features;
+		vkGetPhysicalDeviceFeatures2(device, &features2);
+
+		return indices.IsComplete() && extensionsSupported && swapChainAdequate && deviceFeatures.samplerAnisotropy && vulkan12Features.timelineSemaphore;
 	}
 
 	struct QueueFamilyIndices
 	{
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		std::optional<uint32_t> transferFamily;		// Graphics, Compute 없이 Transfer 만 가능한 Family (DMA 엔진). 없을 수 있음.
 
 		bool IsComplete()
 		{
@@ -587,15 +943,29 @@ private:
 			++i;
 		}
 
+		// 전용 Transfer queue 는 렌더링과 별개로 동작하므로 큰 버퍼나 텍스쳐 업로드를 렌더링과 동시에 진행할 수 있음
+		i = 0;
+		for (const auto& queueFamily : queueFamilies)
+		{
+			if ((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+			{
+				indices.transferFamily = i;
+				break;
+			}
+			++i;
+		}
+
 		return indices;
 	}
 
 	bool CreateLogicalDevice()
 	{
-		QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+		const QueueFamilyIndices& indices = physicalDeviceQueueFamilies;
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+		if (useTransferQueue)
+			uniqueQueueFamilies.insert(indices.transferFamily.value());
 
 		float queuePriority = 1.0f;			// [0.0 ~ 1.0]
 		for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -612,6 +982,11 @@ private:
 		VkPhysicalDeviceFeatures deviceFeatures = {};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;		// VkSampler 가 Anisotropy 를 사용할 수 있도록 하기 위해 true로 설정
 		deviceFeatures.sampleRateShading = VK_TRUE;		// Sample shading 켬	 (텍스쳐 내부에 있는 aliasing 도 완화 해줌)
+		deviceFeatures.fillModeNonSolid = deviceCapabilities.GetFeatures().fillModeNonSolid;	// 와이어프레임(VK_POLYGON_MODE_LINE), 지원하는 경우만
+
+		// Indirect 드로우 (jDrawSubmitMode). 지원하는 경우만 켜고, 없는 기능에 따라 IsDrawSubmitModeSupported 에서 방식을 제한함.
+		deviceFeatures.multiDrawIndirect = INDIRECT_DRAW && deviceCapabilities.GetFeatures().multiDrawIndirect;					// Indirect 드로우 한번에 여러 커맨드
+		deviceFeatures.drawIndirectFirstInstance = INDIRECT_DRAW && deviceCapabilities.GetFeatures().drawIndirectFirstInstance;	// 커맨드의 firstInstance 로 인스턴스 데이터 위치를 넘김
 
 		VkDeviceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -620,9 +995,26 @@ private:
 
 		createInfo.pEnabledFeatures = &deviceFeatures;
 
+		// 1.2 기능은 pNext 로 켜야 함. timelineSemaphore 는 항상 켜고, drawIndirectCount 는 지원하면 켜고, Descriptor indexing 기능은 Bindless 를 쓸 때만 켬.
+		VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		if (useBindless)
+		{
+			vulkan12Features.runtimeDescriptorArray = VK_TRUE;							// 쉐이더에서 크기 없는 배열 (textures[]) 사용
+			vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;					// 사용하지 않는 슬롯은 비워둘 수 있음
+			vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;	// 바인딩 이후에도 텍스쳐 슬롯 추가 가능
+			vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;		// nonuniformEXT 인덱스로 접근
+		}
+		vulkan12Features.timelineSemaphore = VK_TRUE;		// 프레임과 업로드 동기화 (IsDeviceSuitable 에서 확인함)
+		vulkan12Features.drawIndirectCount = INDIRECT_DRAW && deviceCapabilities.GetVulkan12Features().drawIndirectCount;	// vkCmdDrawIndexedIndirectCount
+		createInfo.pNext = &vulkan12Features;
+
 		// extension
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		std::vector<const char*> enabledExtensions = deviceExtensions;
+		if (usePipelineCreationFeedback)
+			enabledExtensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+		createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 		// 최신 버젼에서는 validation layer는 무시되지만, 오래된 버젼을 호환을 위해 vkInstance와 맞춰줌
 		if (enableValidationLayers)
@@ -641,6 +1033,33 @@ private:
 		// 현재는 Queue가 1개 뿐이므로 QueueIndex를 0
 		vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
 		vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+		if (useTransferQueue)
+			vkGetDeviceQueue(device, indices.transferFamily.value(), 0, &transferQueue);
+
+		// Queue 마다 Timeline semaphore 를 하나씩 두고, 모든 제출은 이것을 통해서 함
+		if (!ensure(graphicsTimeline.Initialize(device, graphicsQueue)))
+			return false;
+		if (useTransferQueue && !ensure(transferTimeline.Initialize(device, transferQueue)))
+			return false;
+
+		samplerCache.Initialize(device, deviceCapabilities.GetLimits().maxSamplerAnisotropy);
+		descriptorSetLayoutCache.Initialize(device);
+		memoryAllocator.Initialize(device, deviceCapabilities);
+		deletionQueue.Initialize(device, memoryAllocator);
+
+		// 이전 실행에서 저장한 캐시가 있고 같은 디바이스와 드라이버라면 파이프라인 생성 시간이 크게 줄어듬
+		if (!ensure(pipelineCache.Initialize(device, deviceCapabilities.GetProperties(), PIPELINE_CACHE_PATH, usePipelineCreationFeedback)))
+			return false;
+		std::cout << "Pipeline cache : " << (pipelineCache.IsLoadedFromDisk() ? "loaded " : "created empty, ") << pipelineCache.GetLoadedSize() << " bytes" << std::endl;
+		// 쉐이더는 GLSL 소스를 실행중에 컴파일함. 소스가 바뀌지 않았으면 디스크에 캐시된 SPIR-V 를 씀.
+		if (!ensure(shaderCache.Initialize(device, SHADER_CACHE_PATH)))
+			return false;
+		if (!ensure(pipelineStateCache.Initialize(device, pipelineCache, shaderCache, PIPELINE_COMPILE_WORKER_COUNT)))
+			return false;
+
+		// 감시에 실패해도 Hot reload 만 안될 뿐이므로 계속 진행함
+		if (!shaderWatcher.Initialize(SHADER_SOURCE_PATH))
+			std::cout << "Shader hot reload disabled : failed to watch " << SHADER_SOURCE_PATH << std::endl;
 
 		return true;
 	}
@@ -775,7 +1194,7 @@ private:
 																		// 포스트 프로세스 같은 처리를 위해 별도의 이미지를 만드는 것이면
 																		// VK_IMAGE_USAGE_TRANSFER_DST_BIT 으로 하면됨.
 
-		QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+		const QueueFamilyIndices& indices = physicalDeviceQueueFamilies;
 		uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
 
 		// 그림은 Graphics Queue Family와 Present Queue Family가 다른경우 아래와 같이 동작한다.
@@ -812,6 +1231,9 @@ private:
 		swapChainImages.resize(imageCount);
 		vkGetSwapchainImagesKHR(device, swapChain, &imageCount, swapChainImages.data());
 
+		// 스왑체인을 다시 만들때는 모든 작업이 끝난 상태이므로 0 으로 초기화함
+		swapChainImageSubmitValues.assign(imageCount, 0);
+
 		swapChainImageFormat = surfaceFormat.format;
 		swapChainExtent = extent;
 
@@ -954,219 +1376,135 @@ private:
 		return true;
 	}
 
+	// 씬 쉐이더들의 SPIR-V 에서 Descriptor set 과 Push constant 구성을 읽어옴. 쉐이더의 바인딩을 바꿔도 레이아웃 코드를 같이 고칠 필요가 없음.
+	// 레이아웃은 시작할때 한번만 만들므로 Hot reload 는 바인딩 구성이 같은 수정만 지원함.
+	bool ReflectSceneShaders()
+	{
+		std::string vertexShader;
+		std::string fragmentShader;
+		GetSceneShaderPaths(vertexShader, fragmentShader);
+
+		// 파이프라인과 같은 defines 로 요청하므로 여기서 만든 모듈을 파이프라인에서 그대로 씀
+		jShaderReflection fragmentReflection;
+		if (!ensure(shaderCache.GetReflection(vertexShader, {}, sceneReflection) && shaderCache.GetReflection(fragmentShader, {}, fragmentReflection)))
+			return false;
+		if (!ensure(sceneReflection.Merge(fragmentReflection)))
+			return false;
+
+		// binding 0 : Dynamic uniform buffer. 바인딩 할때 Dynamic offset 을 넘겨서 같은 Descriptor 로 버퍼의 다른 위치를 가리킬 수 있음.
+		// 쉐이더에서는 일반 Uniform buffer 와 구분되지 않으므로 직접 지정함.
+		if (!ensure(sceneReflection.SetDynamicBuffer(0, 0)))
+			return false;
+
+		return ensure(ValidateShaderLayouts());
+	}
+
+	// C++ 에서 쉐이더로 넘기는 구조체가 쉐이더의 블럭과 같은 메모리 레이아웃인지 확인함.
+	// 위의 Alignment 규칙을 어기면 어긋난 멤버를 출력하고 초기화에 실패함.
+	bool ValidateShaderLayouts() const
+	{
+		bool valid = true;
+
+		const jReflectedBinding* sceneUniform = sceneReflection.FindBinding(0, 0);
+		if (!ensure(sceneUniform && (sceneUniform->DescriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC))
+			|| !sceneUniform->Block.Validate("jUniformBufferObject"
+				, { JREFLECT_MEMBER(jUniformBufferObject, View), JREFLECT_MEMBER(jUniformBufferObject, Proj) }, sizeof(jUniformBufferObject)))
+		{
+			valid = false;
+		}
+
+		if (useBindless)
+		{
+			// set 1 은 jBindlessDescriptorSet 의 레이아웃을 쓰므로 쉐이더가 같은 구성으로 선언했는지 확인함
+			const jReflectedBinding* objectBufferBinding = sceneReflection.FindBinding(1, jBindlessDescriptorSet::ObjectBufferBinding);
+			const jReflectedBinding* textureArrayBinding = sceneReflection.FindBinding(1, jBindlessDescriptorSet::TextureArrayBinding);
+			if (!ensure(objectBufferBinding && (objectBufferBinding->DescriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+				&& textureArrayBinding && (textureArrayBinding->DescriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)))
+			{
+				valid = false;
+			}
+			else if (!objectBufferBinding->Block.Validate("jObjectData[]", { jReflectedMember{ "objects", 0, sizeof(jObjectData), 0 } }, 0))
+			{
+				valid = false;
+			}
+		}
+		return valid;
+	}
+
 	bool CreateDescriptorSetLayout()
 	{
-		VkDescriptorSetLayoutBinding uboLayoutBinding = {};
-		uboLayoutBinding.binding = 0;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		uboLayoutBinding.descriptorCount = 1;
+		if (!ReflectSceneShaders())
+			return false;
 
-		// VkShaderStageFlagBits 에 값을 | 연산으로 조합가능
-		//  - VK_SHADER_STAGE_ALL_GRAPHICS 로 설정하면 모든곳에서 사용
-		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-		uboLayoutBinding.pImmutableSamplers = nullptr;	// Optional (이미지 샘플링 시에서만 사용)
+		// 레이아웃은 캐시가 소유하고, 같은 구성을 요청하는 파이프라인 끼리 공유함.
+		// set 0 의 바인딩과 StageFlags 는 쉐이더에서 읽은 그대로 씀.
+		//  - binding 0 : Dynamic uniform buffer (vertex)
+		//  - binding 1 : sampler (fragment). Bindless 경로는 텍스쳐 배열을 쓰므로 없음.
+		jDescriptorSetLayoutDesc layoutDesc;
+		sceneReflection.GetDescriptorSetLayoutDesc(0, layoutDesc);
 
-		VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
-		samplerLayoutBinding.binding = 1;
-		samplerLayoutBinding.descriptorCount = 1;
-		samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		samplerLayoutBinding.pImmutableSamplers = nullptr;
-		samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;	// sampler 를 fragment shader에 붙임.
+		descriptorSetLayout = descriptorSetLayoutCache.GetLayout(layoutDesc);
+		if (!ensure(descriptorSetLayout != VK_NULL_HANDLE))
+			return false;
 
-		std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
+		return true;
+	}
 
-		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
-		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-		layoutInfo.pBindings = bindings.data();
+	bool CreateBindlessDescriptors()
+	{
+		if (!useBindless)
+			return true;
 
-		if (!ensure(vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) == VK_SUCCESS))
+		// 오브젝트 버퍼는 인스턴스 버퍼와 같이 프레임별로 나눠서 쓰므로 CreateUniformBuffers 에서 만들고 연결함
+		if (!ensure(bindlessDescriptors.Initialize(device, descriptorSetLayoutCache, BINDLESS_MAX_TEXTURES)))
 			return false;
 
 		return true;
 	}
 
-	bool CreateGraphicsPipeline()
+	void GetSceneShaderPaths(std::string& outVertexShader, std::string& outFragmentShader) const
 	{
-		// 1. Create Shader
-		auto vertShaderCode = ReadFile("Shaders/vert.spv");
-		auto fragShaderCode = ReadFile("Shaders/frag.spv");
-
-		VkShaderModule vertShaderModule = CreateShaderModule(vertShaderCode);
-		VkShaderModule fragShaderModule = CreateShaderModule(fragShaderCode);
-
-		VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-		vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		vertShaderStageInfo.module = vertShaderModule;
-		vertShaderStageInfo.pName = "main";
-
-		// pSpecializationInfo 을 통해 쉐이더에서 사용하는 상수값을 설정해줄 수 있음. 이 상수 값에 따라 if 분기문에 없어지거나 하는 최적화가 일어날 수 있음.
-		//vertShaderStageInfo.pSpecializationInfo
-
-		VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
-		fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		fragShaderStageInfo.module = fragShaderModule;
-		fragShaderStageInfo.pName = "main";
-
-		VkPipelineShaderStageCreateInfo shaderStage[] = { vertShaderStageInfo, fragShaderStageInfo };
-		// VkShaderModule 은 이 함수의 끝에서 Destroy 시킴
-
-		// 2. Vertex Input
-		// 1). Bindings : 데이터 사이의 간격과 버택스당 or 인스턴스당(인스턴싱 사용시) 데이터인지 여부
-		// 2). Attribute descriptions : 버택스 쉐이더 전달되는 attributes 의 타입. 그것을 로드할 바인딩과 오프셋
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-
-		auto bindingDescription = jVertex::GetBindingDescription();
-		auto attributeDescription = jVertex::GetAttributeDescriptions();
-
-		vertexInputInfo.vertexBindingDescriptionCount = 1;
-		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescription.size());
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescription.data();
-
-		// 3. Input Assembly
-		// primitiveRestartEnable 옵션이 VK_TRUE 이면, 인덱스버퍼의 특수한 index 0xFFFF or 0xFFFFFFFF 를 사용해서 line 과 triangle topology mode를 사용할 수 있다.
-		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-		// 4. Viewports and scissors
-		// SwapChain의 이미지 사이즈가 이 클래스에 정의된 상수 WIDTH, HEIGHT와 다를 수 있다는 것을 기억 해야함.
-		// 그리고 Viewports 사이즈는 SwapChain 크기 이하로 마추면 됨.
-		// [minDepth ~ maxDepth] 는 [0.0 ~ 1.0] 이며 특별한 경우가 아니면 이 범위로 사용하면 된다.
-		// Scissor Rect 영역을 설정해주면 영역내에 있는 Pixel만 레스터라이저를 통과할 수 있으며 나머지는 버려(Discard)진다.
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(swapChainExtent.width);
-		viewport.height = static_cast<float>(swapChainExtent.height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
+		// Bindless 경로는 Model 행렬과 텍스쳐를 오브젝트 Storage buffer 와 텍스쳐 배열에서 읽는 쉐이더를 사용함
+		outVertexShader = useBindless ? "Shaders/shader_bindless.vert" : "Shaders/shader.vert";
+		outFragmentShader = useBindless ? "Shaders/shader_bindless.frag" : "Shaders/shader.frag";
+	}
 
-		VkRect2D scissor = {};
-		scissor.offset = { 0, 0 };
-		scissor.extent = swapChainExtent;
+	// 씬을 그리는 파이프라인의 상태. 실제 Vk 구조체는 jPipelineStateCache 가 이 Desc 로 만듬.
+	jGraphicsPipelineDesc GetScenePipelineDesc(const jMaterial& material) const
+	{
+		jGraphicsPipelineDesc desc;
+		GetSceneShaderPaths(desc.VertexShader, desc.FragmentShader);
+		material.AppendSpecializationConstants(desc.SpecializationConstants);
 
-		// Viewport와 Scissor 를 여러개 설정할 수 있는 멀티 뷰포트를 사용할 수 있기 때문임
-		VkPipelineViewportStateCreateInfo viewportState = {};
-		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
-		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
-
-		// 5. Rasterizer
-		VkPipelineRasterizationStateCreateInfo rasterizer = {};
-		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		rasterizer.depthClampEnable = VK_FALSE;		// 이 값이 VK_TRUE 면 Near나 Far을 벗어나는 영역을 [0.0 ~ 1.0]으로 Clamp 시켜줌.(쉐도우맵에서 유용)
-		rasterizer.rasterizerDiscardEnable = VK_FALSE;	// 이 값이 VK_TRUE 면, 레스터라이저 스테이지를 통과할 수 없음. 즉 Framebuffer 로 결과가 넘어가지 않음.
-		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;	// FILL, LINE, POINT 세가지가 있음
-		rasterizer.lineWidth = 1.0f;
-		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-		//rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-		rasterizer.depthBiasEnable = VK_FALSE;			// 쉐도우맵 용
-		rasterizer.depthBiasConstantFactor = 0.0f;		// Optional
-		rasterizer.depthBiasClamp = 0.0f;				// Optional
-		rasterizer.depthBiasSlopeFactor = 0.0f;			// Optional
-
-		// 6. Multisampling
-		// 현재는 사용하지 않음
-		VkPipelineMultisampleStateCreateInfo multisampling = {};
-		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		multisampling.rasterizationSamples = msaaSamples;
-		multisampling.sampleShadingEnable = VK_TRUE;		// Sample shading 켬	 (텍스쳐 내부에 있는 aliasing 도 완화 해줌)
-		multisampling.minSampleShading = 0.2f;
-		multisampling.pSampleMask = nullptr;				// Optional
-		multisampling.alphaToCoverageEnable = VK_FALSE;		// Optional
-		multisampling.alphaToOneEnable = VK_FALSE;			// Optional
-
-		// 7. Depth and stencil testing
-		VkPipelineDepthStencilStateCreateInfo depthStencil = {};
-		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		depthStencil.depthTestEnable = VK_TRUE;
-		depthStencil.depthWriteEnable = VK_TRUE;
-		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-		depthStencil.depthBoundsTestEnable = VK_FALSE;
-		depthStencil.minDepthBounds = 0.0f;		// Optional
-		depthStencil.maxDepthBounds = 1.0f;		// Optional
-
-		// 8. Color blending
-		// 2가지 방식의 blending 이 있음
-		// 1). 기존과 새로운 값을 섞어서 최종색을 만들어낸다.
-		// 2). 기존과 새로운 값을 비트 연산으로 결합한다.
-		/*
-			// Blend 가 켜져있으면 대략 이런식으로 동작함
-			if (blendEnable)
-			{
-				finalColor.rgb = (srcColorBlendFactor * newColor.rgb) <colorBlendOp> (dstColorBlendFactor * oldColor.rgb);
-				finalColor.a = (srcAlphaBlendFactor * newColor.a) <alphaBlendOp> (dstAlphaBlendFactor * oldColor.a);
-			} else
-			{
-				finalColor = newColor;
-			}
+		desc.VertexBindings.push_back(jVertex::GetBindingDescription());
+		const auto attributeDescriptions = jVertex::GetAttributeDescriptions();
+		desc.VertexAttributes.assign(attributeDescriptions.begin(), attributeDescriptions.end());
 
-			finalColor = finalColor & colorWriteMask;
-		*/
-		VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-		colorBlendAttachment.blendEnable = VK_FALSE;						// 현재 VK_FALSE라 새로운 값이 그대로 사용됨
-		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;		// Optional
-		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;	// Optional
-		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;				// Optional
-		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;		// Optional
-		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;	// Optional
-		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;				// Optional
-
-		// 일반적인 경우 블랜드는 아래와 같은 식을 사용한다.
-		/*
-			finalColor.rgb = newAlpha * newColor + (1 - newAlpha) * oldColor;
-			finalColor.a = newAlpha.a;
-		*/
-		// 이렇게 하려면 아래와 같이 설정해야 함.
-		//colorBlendAttachment.blendEnable = VK_TRUE;
-		//colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-		//colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-		//colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-		//colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-		//colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-		//colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-		// 2가지 blending 방식을 모두 끌 수도있는데 그렇게 되면, 변경되지 않은 fragment color 값이 그대로 framebuffer에 쓰여짐.
-		VkPipelineColorBlendStateCreateInfo colorBlending = {};
-		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-
-		// 2). 기존과 새로운 값을 비트 연산으로 결합한다.
-		colorBlending.logicOpEnable = VK_FALSE;			// 모든 framebuffer에 사용하는 blendEnable을 VK_FALSE로 했다면 자동으로 logicOpEnable은 꺼진다.
-		colorBlending.logicOp = VK_LOGIC_OP_COPY;		// Optional
-
-		// 1). 기존과 새로운 값을 섞어서 최종색을 만들어낸다.
-		colorBlending.attachmentCount = 1;						// framebuffer 개수에 맞게 설정해준다.
-		colorBlending.pAttachments = &colorBlendAttachment;
-
-		colorBlending.blendConstants[0] = 0.0f;		// Optional
-		colorBlending.blendConstants[1] = 0.0f;		// Optional
-		colorBlending.blendConstants[2] = 0.0f;		// Optional
-		colorBlending.blendConstants[3] = 0.0f;		// Optional
-
-		// 9. Dynamic state
-		// 이전에 정의한 state에서 제한된 범위 내에서 새로운 pipeline을 만들지 않고 state를 변경할 수 있음. (viewport size, line width, blend constants)
-		// 이것을 하고싶으면 Dynamic state를 만들어야 함. 이경우 Pipeline에 설정된 값은 무시되고, 매 렌더링시에 새로 설정해줘야 함.
-		VkDynamicState dynamicStates[] = {
-			VK_DYNAMIC_STATE_VIEWPORT,
-			VK_DYNAMIC_STATE_LINE_WIDTH
-		};
-		// 현재는 사용하지 않음.
-		//VkPipelineDynamicStateCreateInfo dynamicState = {};
-		//dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-		//dynamicState.dynamicStateCount = 2;
-		//dynamicState.pDynamicStates = dynamicStates;
+		// Bindless 경로는 인스턴스 데이터를 오브젝트 버퍼에서 gl_InstanceIndex 로 읽음
+		if (!useBindless)
+		{
+			desc.VertexBindings.push_back(jInstanceData::GetBindingDescription());
+			const auto instanceAttributeDescriptions = jInstanceData::GetAttributeDescriptions();
+			desc.VertexAttributes.insert(desc.VertexAttributes.end(), instanceAttributeDescriptions.begin(), instanceAttributeDescriptions.end());
+		}
+
+		desc.CullMode = VK_CULL_MODE_BACK_BIT;
+		desc.FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		desc.SampleCount = msaaSamples;
+		desc.MinSampleShading = 0.2f;			// Sample shading 켬	 (텍스쳐 내부에 있는 aliasing 도 완화 해줌)
+		desc.DepthTestEnable = VK_TRUE;
+		desc.DepthWriteEnable = VK_TRUE;
+		desc.DepthCompareOp = VK_COMPARE_OP_LESS;
+
+		desc.Layout = pipelineLayout;
+		desc.RenderPass = renderPass;
+		desc.Subpass = 0;
+		return desc;
+	}
 
-		// 10. Pipeline layout
+	bool CreateGraphicsPipeline()
+	{
+		// Pipeline layout
 		// 쉐이더에 전달된 Uniform 들을 명세하기 위한 오브젝트
 		// 이 오브젝트는 프로그램 실행동안 계속해서 참조되므로 cleanup 에서 제거해줌
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
@@ -1175,57 +1513,153 @@ private:
 		pipelineLayoutInfo.pSetLayouts = nullptr;
 		pipelineLayoutInfo.setLayoutCount = 1;
 		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-		pipelineLayoutInfo.pushConstantRangeCount = 0;		// Optional		// 쉐이더에 값을 constant 값을 전달 할 수 있음. 이후에 배움
-		pipelineLayoutInfo.pPushConstantRanges = nullptr;	// Optional
+
+		// Push constant : 커맨드 버퍼에 직접 기록되는 작은 상수 데이터. 버퍼나 Descriptor 없이 드로우 마다 바꿀 수 있음.
+		// 범위와 스테이지는 쉐이더에서 읽음. 현재 씬 쉐이더들은 Model 행렬을 인스턴스 데이터에서 읽으므로 Push constant 를 쓰지 않음.
+		const VkPushConstantRange pushConstantRange = sceneReflection.GetPushConstantRange();
+		if (!ensure(pushConstantRange.size <= deviceCapabilities.GetLimits().maxPushConstantsSize))
+			return false;
+		pipelineLayoutInfo.pushConstantRangeCount = sceneReflection.HasPushConstants() ? 1 : 0;
+		pipelineLayoutInfo.pPushConstantRanges = sceneReflection.HasPushConstants() ? &pushConstantRange : nullptr;
+
+		// set 0 : 씬 Uniform (Dynamic uniform buffer), set 1 : Bindless (오브젝트 버퍼 + 텍스쳐 배열)
+		const VkDescriptorSetLayout bindlessSetLayouts[] = { descriptorSetLayout, bindlessDescriptors.GetLayout() };
+		if (useBindless)
+		{
+			pipelineLayoutInfo.setLayoutCount = 2;
+			pipelineLayoutInfo.pSetLayouts = bindlessSetLayouts;
+		}
 		if (!ensure(vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) == VK_SUCCESS))
+			return false;
+
+		// 씬 파이프라인은 다른 조합들의 Fallback 이므로 바로 만들어서 기다림. 같은 Desc 라면 파이프라인 캐시 덕분에 빠르게 만들어짐.
+		// 머터리얼 변형들은 다음 DrawFrame 에서 다시 요청됨.
+		scenePipeline = pipelineStateCache.RequestImmediate(GetScenePipelineDesc(jMaterial()));
+		wireframePipeline = INVALID_PIPELINE_HANDLE;
+		overridePipeline = INVALID_PIPELINE_HANDLE;
+		materialPipelines.assign(materials.size(), INVALID_PIPELINE_HANDLE);
+		return ensure(scenePipeline != INVALID_PIPELINE_HANDLE);
+	}
+
+	// IndirectGpu 에서 오브젝트를 컬링하고 드로우 커맨드를 채우는 Compute 파이프라인. 레이아웃은 씬 쉐이더처럼 SPIR-V 에서 읽음.
+	// 만들지 못하면 IndirectGpu 만 쓰지 않고 초기화는 계속함. 씬 파이프라인이 아니므로 Hot reload 는 되지 않음.
+	bool CreateCullPipeline()
+	{
+		// 커맨드를 채운 뒤 같은 커맨드 버퍼에서 바로 그리므로 Graphics queue 에서 Compute 를 실행할 수 있어야 함
+		const VkQueueFamilyProperties& graphicsFamily = deviceCapabilities.GetQueueFamilies()[physicalDeviceQueueFamilies.graphicsFamily.value()];
+		if (!INDIRECT_DRAW || !(graphicsFamily.queueFlags & VK_QUEUE_COMPUTE_BIT))
+			return false;
+
+		const VkShaderModule cullShader = shaderCache.GetShaderModule(CULL_SHADER_PATH, {});
+		if (!ensure(cullShader && shaderCache.GetReflection(CULL_SHADER_PATH, {}, cullReflection)))
+			return false;
+		if (!ensure(ValidateCullLayouts()))
+			return false;
+
+		jDescriptorSetLayoutDesc layoutDesc;
+		cullReflection.GetDescriptorSetLayoutDesc(0, layoutDesc);
+		cullDescriptorSetLayout = descriptorSetLayoutCache.GetLayout(layoutDesc);
+		if (!ensure(cullDescriptorSetLayout != VK_NULL_HANDLE))
+			return false;
+
+		const VkPushConstantRange pushConstantRange = cullReflection.GetPushConstantRange();
+		if (!ensure(pushConstantRange.size <= deviceCapabilities.GetLimits().maxPushConstantsSize))
+			return false;
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &cullDescriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (!ensure(vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &cullPipelineLayout) == VK_SUCCESS))
+			return false;
+
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = cullShader;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.layout = cullPipelineLayout;
+		if (!ensure(pipelineCache.CreateComputePipelines(1, &pipelineInfo, &cullPipeline) == VK_SUCCESS))
 		{
-			vkDestroyShaderModule(device, fragShaderModule, nullptr);
-			vkDestroyShaderModule(device, vertShaderModule, nullptr);
+			cullPipeline = VK_NULL_HANDLE;
 			return false;
 		}
+		return true;
+	}
 
-		VkGraphicsPipelineCreateInfo pipelineInfo = {};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	// cull.comp 의 블럭들이 C++ 구조체와 같은 레이아웃인지 확인함
+	bool ValidateCullLayouts() const
+	{
+		bool valid = true;
 
-		// Shader stage
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStage;
+		if (!ensure(cullReflection.HasPushConstants())
+			|| !cullReflection.GetPushConstantBlock().Validate("jCullConstants"
+				, { JREFLECT_MEMBER(jCullConstants, ViewProj), JREFLECT_MEMBER(jCullConstants, BoundingSphere), JREFLECT_MEMBER(jCullConstants, ObjectCount)
+				, JREFLECT_MEMBER(jCullConstants, BatchCount), JREFLECT_MEMBER(jCullConstants, ObjectStride), JREFLECT_MEMBER(jCullConstants, IndexCount)
+				, JREFLECT_MEMBER(jCullConstants, Compact), JREFLECT_MEMBER(jCullConstants, BaseInstance) }, sizeof(jCullConstants)))
+		{
+			valid = false;
+		}
 
-		// Fixed-function stage
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &inputAssembly;
-		pipelineInfo.pViewportState = &viewportState;
-		pipelineInfo.pRasterizationState = &rasterizer;
-		pipelineInfo.pMultisampleState = &multisampling;
-		pipelineInfo.pDepthStencilState = &depthStencil;
-		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.pDynamicState = nullptr;			// Optional
-		pipelineInfo.layout = pipelineLayout;
-		pipelineInfo.renderPass = renderPass;
-		pipelineInfo.subpass = 0;		// index of subpass
+		// binding 0 : Model 행렬 버퍼, binding 1 : jCullBatch 배열, binding 2 : 드로우 커맨드 배열
+		const jReflectedBinding* batchBinding = cullReflection.FindBinding(0, 1);
+		const jReflectedBinding* drawBinding = cullReflection.FindBinding(0, 2);
+		if (!ensure(cullReflection.FindBinding(0, 0) && batchBinding && drawBinding))
+			return false;
 
-		// Pipeline을 상속받을 수 있는데, 아래와 같은 장점이 있다.
-		// 1). 공통된 내용이 많으면 파이프라인 설정이 저렴하다.
-		// 2). 공통된 부모를 가진 파이프라인 들끼리의 전환이 더 빠를 수 있다.
-		// BasePipelineHandle 이나 BasePipelineIndex 가 로 Pipeline 내용을 상속받을 수 있다.
-		// 이 기능을 사용하려면 VkGraphicsPipelineCreateInfo의 flags 에 VK_PIPELINE_CREATE_DERIVATIVE_BIT  가 설정되어있어야 함
-		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;		// Optional
-		pipelineInfo.basePipelineIndex = -1;					// Optional
+		if (!batchBinding->Block.Validate("jCullBatch[]", { jReflectedMember{ "batches", 0, sizeof(jCullBatch), 0 } }, 0))
+			valid = false;
+		if (!drawBinding->Block.Validate("VkDrawIndexedIndirectCommand[]", { jReflectedMember{ "draws", 0, sizeof(VkDrawIndexedIndirectCommand), 0 } }, 0))
+			valid = false;
+		return valid;
+	}
 
-		// 여기서 두번째 파라메터 VkPipelineCache에 VK_NULL_HANDLE을 넘겼는데, VkPipelineCache는 VkPipeline을 저장하고 생성하는데 재사용할 수 있음.
-		// 또한 파일로드 저장할 수 있어서 다른 프로그램에서 다시 사용할 수도있다. VkPipelineCache를 사용하면 VkPipeline을 생성하는 시간을 
-		// 굉장히 빠르게 할수있다. (듣기로는 대략 1/10 의 속도로 생성해낼 수 있다고 함)
-		if (!ensure(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) == VK_SUCCESS))
+	// IndirectCpu : 배치의 FirstInstance 를 커맨드의 firstInstance 로 넘기므로 drawIndirectFirstInstance 가 필요함.
+	// IndirectGpu : 배치 마다 오브젝트 수 만큼의 커맨드를 한번에 그리므로 multiDrawIndirect 와 컬링 파이프라인도 필요함.
+	bool IsDrawSubmitModeSupported(uint32_t mode) const
+	{
+		const VkPhysicalDeviceFeatures& features = deviceCapabilities.GetFeatures();
+		switch (mode)
 		{
-			vkDestroyShaderModule(device, fragShaderModule, nullptr);
-			vkDestroyShaderModule(device, vertShaderModule, nullptr);
-			return false;
+		case jDrawSubmitMode::Direct:
+			return true;
+		case jDrawSubmitMode::IndirectCpu:
+			return INDIRECT_DRAW && features.drawIndirectFirstInstance;
+		case jDrawSubmitMode::IndirectGpu:
+			return INDIRECT_DRAW && features.drawIndirectFirstInstance && features.multiDrawIndirect && (cullPipeline != VK_NULL_HANDLE);
 		}
+		return false;
+	}
+
+	const char* GetDrawSubmitModeString(uint32_t mode) const
+	{
+		switch (mode)
+		{
+		case jDrawSubmitMode::Direct: return "Direct";
+		case jDrawSubmitMode::IndirectCpu: return "Indirect (CPU)";
+		case jDrawSubmitMode::IndirectGpu: return useDrawIndirectCount ? "Indirect count (GPU culling)" : "Indirect (GPU culling)";
+		}
+		return "Unknown";
+	}
 
-		vkDestroyShaderModule(device, fragShaderModule, nullptr);
-		vkDestroyShaderModule(device, vertShaderModule, nullptr);
+	// 지원하는 방식 중 CPU 부담이 가장 적은 것으로 시작함
+	void SelectDrawSubmitMode()
+	{
+		useDrawIndirectCount = INDIRECT_DRAW && deviceCapabilities.GetVulkan12Features().drawIndirectCount;
 
-		return true;
+		drawSubmitMode = jDrawSubmitMode::Direct;
+		for (uint32_t mode = jDrawSubmitMode::Count - 1; mode > jDrawSubmitMode::Direct; --mode)
+		{
+			if (IsDrawSubmitModeSupported(mode))
+			{
+				drawSubmitMode = mode;
+				break;
+			}
+		}
+		std::cout << "Draw submit : " << GetDrawSubmitModeString(drawSubmitMode) << std::endl;
 	}
 
 	bool CreateFrameBuffers()
@@ -1255,42 +1689,24 @@ private:
 		return true;
 	}
 
-	VkShaderModule CreateShaderModule(const std::vector<char>& code)
-	{
-		VkShaderModuleCreateInfo createInfo = {};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-
-		// pCode 가 uint32_t* 형이라서 4 byte aligned 된 메모리를 넘겨줘야 함.
-		// 다행히 std::vector의 default allocator가 가 메모리 할당시 4 byte aligned 을 이미 하고있어서 그대로 씀.
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-		VkShaderModule shaderModule;
-		check(vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) == VK_SUCCESS);
-
-		// compiling or linking 과정이 graphics pipeline 이 생성되기 전까지 처리되지 않는다.
-		// 그래픽스 파이프라인이 생성된 후 VkShaderModule은 즉시 소멸 가능.
-		return shaderModule;
-	}
-
-	bool CreateCommandPool()
+	bool CreateUploadContext()
 	{
-		QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
-
-		VkCommandPoolCreateInfo poolInfo = {};
-		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+		const QueueFamilyIndices& queueFamilyIndices = physicalDeviceQueueFamilies;
 
-		// VK_COMMAND_POOL_CREATE_TRANSIENT_BIT : 커맨드 버퍼가 새로운 커맨드를 자주 다시 기록한다고 힌트를 줌.
-		//											(메모리 할당 동작을 변경할 것임)
-		// VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT : 커맨드 버퍼들이 개별적으로 다시 기록될 수 있다.
-		//													이 플래그가 없으면 모든 커맨드 버퍼들이 동시에 리셋되야 함.
-		// 우리는 프로그램 시작시에 커맨드버퍼를 한번 녹화하고 계속해서 반복사용 할 것이므로 flags를 설정하지 않음.
-		poolInfo.flags = 0;		// Optional
-
-		if (!ensure(vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) == VK_SUCCESS))
+		// 업로드 커맨드는 모두 Graphics queue 에 제출함. 밉맵 생성에 vkCmdBlitImage 가 필요하고,
+		// 같은 Queue 라서 이후 프레임이 제출 순서만으로 업로드 이후에 실행되기 때문.
+		// 프레임 커맨드 버퍼는 jFrameContext 의 TRANSIENT Pool 에서 할당함.
+		// 업로드 제출 값은 Graphics timeline 값이라 프레임 제출과 같은 기준으로 완료 여부를 확인할 수 있음.
+		if (!ensure(uploadContext.Initialize(device, graphicsTimeline, queueFamilyIndices.graphicsFamily.value())))
 			return false;
 
+		// 전용 Transfer queue 가 있으면 복사는 그쪽에서 하고, Graphics 업로드 컨텍스트는 소유권 Acquire 와 밉맵 생성만 함.
+		if (useTransferQueue)
+		{
+			if (!ensure(transferUploadContext.Initialize(device, transferTimeline, queueFamilyIndices.transferFamily.value())))
+				return false;
+		}
+
 		return true;
 	}
 
@@ -1298,15 +1714,7 @@ private:
 	{
 		for (VkFormat format : candidates)
 		{
-			VkFormatProperties props;
-			// props.linearTilingFeatures : Linear tiling 지원여부
-			// props.optimalTilingFeatures : Optimal tiling 지원여부
-			// props.bufferFeatures : 버퍼를 지원하는 경우
-			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
-
-			if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features)
-				return format;
-			else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features)
+			if (deviceCapabilities.IsFormatSupported(format, tiling, features))
 				return format;
 		}
 		check(0);
@@ -1339,34 +1747,160 @@ private:
 		}
 		depthImageView = CreateImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
 
-		TransitionImageLayout(depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
+		TransitionImageLayout(uploadContext.GetCommandBuffer(), depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
 
 		return true;
 	}
 
-	bool CreateTextureImage()
+	bool CreateStagingRing()
 	{
-		int texWidth, texHeight, texChannels;
-		stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-
-		if (!ensure(pixels))
+		if (!ensure(CreateBuffer(STAGING_RING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			, stagingRingBuffer, stagingRingBufferMemory)))
+		{
 			return false;
+		}
 
-		VkDeviceSize imageSize = texWidth * texHeight * 4;
-		textureMipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max<int>(texWidth, texHeight)))) + 1;
-
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
+		// 할당자가 HOST_VISIBLE 메모리를 Map 된 상태로 유지해줌. HOST_COHERENT 라 따로 Flush 할 필요 없음.
+		if (!ensure(stagingRingBufferMemory.MappedData))
+			return false;
 
-		CreateBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-			, stagingBuffer, stagingBufferMemory);
+		stagingRing.Initialize(stagingRingBuffer, stagingRingBufferMemory.MappedData, STAGING_RING_SIZE);
+		return true;
+	}
 
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
-		memcpy(data, pixels, static_cast<size_t>(imageSize));
-		vkUnmapMemory(device, stagingBufferMemory);
+	// 지금까지 기록한 업로드 커맨드를 제출하고, 그동안 Staging ring 에서 할당한 영역을 이번 제출 값에 묶어둠.
+	// 완료를 기다리지 않으므로 CPU 에서 업로드에 사용한 메모리를 다시 써야 할때만 uploadContext.Wait 으로 기다림.
+	// 전용 Transfer queue 를 쓰는 경우 복사와 소유권 Release 를 먼저 제출하고, Graphics 쪽 제출이 이를 기다리게 함.
+	// Graphics 쪽 제출이 끝나면 Transfer 쪽도 끝난 것이므로 Staging ring 은 Graphics 쪽 값으로만 관리함.
+	uint64_t SubmitUploads()
+	{
+		if (useTransferQueue && transferUploadContext.HasPendingCommands())
+		{
+			const uint64_t transferValue = transferUploadContext.Submit();
+			uploadContext.AddWaitSemaphore(transferTimeline.GetSemaphore(), transferValue, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+			transferUploadContext.Poll();
+		}
+
+		const uint64_t uploadValue = uploadContext.Submit();
+		stagingRing.Retire(uploadValue);
+		stagingRing.Release(uploadContext.Poll());
+		return uploadValue;
+	}
+
+	// Staging ring 에 공간이 없으면 지금까지의 업로드를 제출하고 완료될때까지 기다린 뒤 한번 더 시도함.
+	bool AllocateStaging(VkDeviceSize size, jStagingAllocation& outAllocation)
+	{
+		if (stagingRing.Allocate(size, STAGING_ALIGNMENT, outAllocation))
+			return true;
+
+		if (!uploadContext.Wait(SubmitUploads()))
+			return false;
+		stagingRing.Release(graphicsTimeline.GetCompletedValue());
+
+		return stagingRing.Allocate(size, STAGING_ALIGNMENT, outAllocation);
+	}
+
+	// 복사 커맨드를 기록할 커맨드 버퍼. 전용 Transfer queue 를 쓰면 그쪽 업로드 컨텍스트의 것을 돌려줌.
+	// 여기에 기록한 리소스는 복사가 끝난 뒤 TransferBufferOwnership / TransferImageOwnership 으로 Graphics queue 에 넘겨야 함.
+	VkCommandBuffer GetTransferCommandBuffer()
+	{
+		return useTransferQueue ? transferUploadContext.GetCommandBuffer() : uploadContext.GetCommandBuffer();
+	}
+
+	// VK_SHARING_MODE_EXCLUSIVE 리소스를 다른 Queue family 에서 쓰려면 소유권을 넘겨야 함.
+	// Transfer 커맨드 버퍼에 Release, Graphics 업로드 커맨드 버퍼에 Acquire 를 같은 내용으로 기록하고, 둘 사이는 SubmitUploads 의 세마포어로 동기화됨.
+	// Release 의 dst 와 Acquire 의 src 쪽 Stage/Access 는 무시되므로 0 으로 둠.
+	// 같은 Queue 에서 업로드한 경우는 배치 끝의 Barrier 로 충분하므로 아무것도 하지 않음.
+	void TransferBufferOwnership(VkBuffer buffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccessMask)
+	{
+		if (!useTransferQueue)
+			return;
+
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = physicalDeviceQueueFamilies.transferFamily.value();
+		barrier.dstQueueFamilyIndex = physicalDeviceQueueFamilies.graphicsFamily.value();
+		barrier.buffer = buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(transferUploadContext.GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0
+			, 0, nullptr
+			, 1, &barrier
+			, 0, nullptr);
+
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccessMask;
+		vkCmdPipelineBarrier(uploadContext.GetCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, 0
+			, 0, nullptr
+			, 1, &barrier
+			, 0, nullptr);
+	}
+
+	// layout 은 넘기는 동안 유지됨. 밉맵 생성처럼 Graphics queue 에서 이어서 써야 하는 경우를 위해 모든 밉을 넘김.
+	void TransferImageOwnership(VkImage image, VkImageLayout layout, uint32_t mipLevels, VkPipelineStageFlags dstStage, VkAccessFlags dstAccessMask)
+	{
+		if (!useTransferQueue)
+			return;
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = layout;
+		barrier.newLayout = layout;
+		barrier.srcQueueFamilyIndex = physicalDeviceQueueFamilies.transferFamily.value();
+		barrier.dstQueueFamilyIndex = physicalDeviceQueueFamilies.graphicsFamily.value();
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = mipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(transferUploadContext.GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0
+			, 0, nullptr
+			, 0, nullptr
+			, 1, &barrier);
+
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccessMask;
+		vkCmdPipelineBarrier(uploadContext.GetCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, 0
+			, 0, nullptr
+			, 0, nullptr
+			, 1, &barrier);
+	}
+
+	bool CreateTextureImage()
+	{
+		int texWidth, texHeight, texChannels;
+		if (!ensure(stbi_info(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels)))
+			return false;
+
+		VkDeviceSize imageSize = texWidth * texHeight * 4;
+		textureMipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max<int>(texWidth, texHeight)))) + 1;
 
-		stbi_image_free(pixels);
+		// 디코딩 결과가 Staging ring 에 바로 쓰여지도록 영역을 먼저 할당해둠.
+		jStagingAllocation staging;
+		if (!ensure(AllocateStaging(imageSize, staging)))
+			return false;
+
+		jImageDecodeTarget::SetTarget(staging.MappedData, static_cast<size_t>(imageSize));
+		stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		jImageDecodeTarget::ClearTarget();
+
+		// 할당한 Staging 영역은 다음 SubmitUploads 에서 같이 반환됨
+		if (!ensure(pixels))
+			return false;
+
+		// 디코더가 다른 버퍼에 결과를 만든 경우(포맷 변환 등)에만 복사함. 이 경우 pixels 는 일반 힙 메모리이므로 해제해줌.
+		if (pixels != staging.MappedData)
+		{
+			memcpy(staging.MappedData, pixels, static_cast<size_t>(imageSize));
+			stbi_image_free(pixels);
+		}
 
 		if (!ensure(CreateImage(static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), textureMipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_UNORM
 			, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT
@@ -1376,18 +1910,22 @@ private:
 			return false;
 		}
 
-		if (!TransitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, textureMipLevels))
+		// UNDEFINED 에서 전환하면 기존 내용을 보존하지 않으므로 소유권을 넘겨받지 않고 Transfer queue 에서 바로 사용할 수 있음
+		VkCommandBuffer transferCommandBuffer = GetTransferCommandBuffer();
+		if (!TransitionImageLayout(transferCommandBuffer, textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, textureMipLevels))
 			return false;
-		CopyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+		CopyBufferToImage(transferCommandBuffer, staging.Buffer, staging.Offset, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+
+		// 밉맵 생성(vkCmdBlitImage) 은 Graphics queue 에서만 가능함
+		TransferImageOwnership(textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, textureMipLevels
+			, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
 
 		// 밉맵을 만드는 동안 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL 으로 전환됨.
 		//// 이제 쉐이더에 읽기가 가능하게 하기위해서 아래와 같이 적용.
 		//if (TransitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, textureMipLevels))
 		//	return false;
 
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
-
+		// 복사와 밉맵 생성은 업로드 커맨드 버퍼에 기록만 되고, 제출은 SubmitUploads 에서 한번에 함.
 		if (!ensure(GenerateMipmaps(textureImage, VK_FORMAT_R8G8B8A8_UNORM, texWidth, texHeight, textureMipLevels)))
 			return false;
 
@@ -1396,12 +1934,12 @@ private:
 
 	bool GenerateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
 	{
-		VkFormatProperties formatProperties;
-		vkGetPhysicalDeviceFormatProperties(physicalDevice, imageFormat, &formatProperties);
-		if (!ensure(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+		if (!ensure(deviceCapabilities.IsFormatSupported(imageFormat, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)))
 			return false;
 
-		VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+		VkCommandBuffer commandBuffer = uploadContext.GetCommandBuffer();
+		if (!ensure(commandBuffer))
+			return false;
 
 		VkImageMemoryBarrier barrier = { };
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -1472,8 +2010,6 @@ private:
 			, 0, nullptr
 			, 1, &barrier);
 
-		EndSingleTimeCommands(commandBuffer);
-
 		return true;
 	}
 
@@ -1515,10 +2051,10 @@ private:
 
 	bool CreateTextureSampler()
 	{
-		VkSamplerCreateInfo samplerInfo = {};
-		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerInfo.magFilter = VK_FILTER_LINEAR;
-		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		// Sampler 는 상태값이 같으면 재사용 할 수 있고 디바이스 마다 만들 수 있는 개수가 제한되어 있으므로 Sampler cache 를 통해서 얻음.
+		jSamplerStateDesc samplerState;
+		samplerState.MagFilter = VK_FILTER_LINEAR;
+		samplerState.MinFilter = VK_FILTER_LINEAR;
 
 		// UV가 [0~1] 범위를 벗어는 경우 처리
 		// VK_SAMPLER_ADDRESS_MODE_REPEAT : 반복해서 출력, UV % 1
@@ -1526,28 +2062,29 @@ private:
 		// VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE : 범위 밖은 가장자리의 색으로 모두 출력
 		// VK_SAMPLER_ADDRESS_MODE_MIRROR_CLAMP_TO_EDGE : 범위 밖은 반대편 가장자리의 색으로 모두 출력
 		// VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER : 단색으로 설정함. (samplerInfo.borderColor)
-		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerState.AddressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerState.AddressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerState.AddressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerState.BorderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 		
-		samplerInfo.anisotropyEnable = VK_TRUE;
-		samplerInfo.maxAnisotropy = 16;
+		samplerState.MaxAnisotropy = 16.0f;		// 디바이스의 maxSamplerAnisotropy 보다 크면 그 값으로 제한됨
 
 		// 이게 true 이면 UV 좌표가 [0, texWidth], [0, texHeight] 가 됨. false 이면 [0, 1] 범위
-		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+		samplerState.UnnormalizedCoordinates = VK_FALSE;
 
 		// compareEnable이 ture 이면, 텍셀을 특정 값과 비교한 뒤 그 결과를 필터링 연산에 사용한다.
 		// Percentage-closer filtering(PCF) 에 주로 사용됨.
-		samplerInfo.compareEnable = VK_FALSE;
-		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerState.CompareEnable = VK_FALSE;
+		samplerState.CompareOp = VK_COMPARE_OP_ALWAYS;
 
-		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerInfo.mipLodBias = 0.0f;	// Optional
-		samplerInfo.minLod = 0.0f;		// Optional
-		samplerInfo.maxLod = static_cast<float>(textureMipLevels);
+		samplerState.MipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerState.MipLodBias = 0.0f;	// Optional
+		samplerState.MinLod = 0.0f;		// Optional
+		samplerState.MaxLod = static_cast<float>(textureMipLevels);
 
-		if (!ensure(vkCreateSampler(device, &samplerInfo, nullptr, &textureSampler) == VK_SUCCESS))
+		// 만들어진 Sampler 는 Sampler cache 가 소유하므로 따로 소멸시키지 않음.
+		textureSampler = samplerCache.GetSampler(samplerState);
+		if (!ensure(textureSampler != VK_NULL_HANDLE))
 			return false;
 
 		return true;
@@ -1597,11 +2134,91 @@ private:
 			}
 		}
 
+		// GPU 컬링에 쓰는 바운딩 스피어. AABB 의 중심에서 가장 먼 버텍스까지를 반지름으로 함.
+		if (!vertices.empty())
+		{
+			jSimpleVec3 minPos = vertices[0].pos;
+			jSimpleVec3 maxPos = vertices[0].pos;
+			for (const jVertex& vertex : vertices)
+			{
+				minPos = { std::min(minPos.x, vertex.pos.x), std::min(minPos.y, vertex.pos.y), std::min(minPos.z, vertex.pos.z) };
+				maxPos = { std::max(maxPos.x, vertex.pos.x), std::max(maxPos.y, vertex.pos.y), std::max(maxPos.z, vertex.pos.z) };
+			}
+			meshBoundingCenter = { (minPos.x + maxPos.x) * 0.5f, (minPos.y + maxPos.y) * 0.5f, (minPos.z + maxPos.z) * 0.5f };
+
+			float radiusSquared = 0.0f;
+			for (const jVertex& vertex : vertices)
+			{
+				const float dx = vertex.pos.x - meshBoundingCenter.x;
+				const float dy = vertex.pos.y - meshBoundingCenter.y;
+				const float dz = vertex.pos.z - meshBoundingCenter.z;
+				radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+			}
+			meshBoundingRadius = sqrtf(radiusSquared);
+		}
+
+		return true;
+	}
+
+	bool CreateRenderObjects()
+	{
+		renderObjects.clear();
+
+		// 머터리얼의 파이프라인은 DrawFrame 에서 처음 쓰일때 요청함
+		materials.assign(1, jMaterial());
+		materials[0].Features = MATERIAL_VARIANTS[materialVariantIndex];
+		materialPipelines.assign(materials.size(), INVALID_PIPELINE_HANDLE);
+
+		// 인스턴스 데이터는 UpdateInstanceBuffer 에서 매 프레임 다시 쓰므로 Model 행렬을 바꾸면 다음 프레임에 바로 반영됨.
+		jRenderObject renderObject;
+		renderObject.Model = Matrix::MakeRotate(Vector(0.0f, 0.0f, 1.0f), DegreeToRadian(245.0f)).GetTranspose();
+		renderObject.MaterialIndex = 0;
+		renderObjects.push_back(renderObject);
+
+		BuildDrawBatches();
+
+		if (useBindless)
+		{
+			// 텍스쳐는 배열에 한번만 넣고, 같은 텍스쳐를 쓰는 오브젝트들은 같은 인덱스를 공유함
+			const uint32_t textureIndex = bindlessDescriptors.AddTexture(textureImageView, textureSampler);
+			if (!ensure(textureIndex != jBindlessDescriptorSet::InvalidIndex))
+				return false;
+
+			for (jRenderObject& object : renderObjects)
+				object.TextureIndex = textureIndex;
+		}
+
 		return true;
 	}
 
+	// renderObjects 를 머터리얼 순서로 정렬하고 같은 머터리얼끼리 jDrawBatch 로 묶음. 오브젝트 수와 상관없이 드로우는 머터리얼 수 만큼만 기록됨.
+	// 메시는 현재 하나뿐이라 머터리얼로만 나눔. renderObjects 를 추가하거나 머터리얼을 바꾼 뒤에는 다시 호출해야 함.
+	void BuildDrawBatches()
+	{
+		std::stable_sort(renderObjects.begin(), renderObjects.end(), [](const jRenderObject& a, const jRenderObject& b)
+		{
+			return a.MaterialIndex < b.MaterialIndex;
+		});
+
+		// IndirectGpu 는 배치 마다 오브젝트 수 만큼의 커맨드를 한번에 그리므로 maxDrawIndirectCount 를 넘지 않도록 나눔
+		const uint32_t maxBatchSize = IsDrawSubmitModeSupported(jDrawSubmitMode::IndirectGpu) ? deviceCapabilities.GetLimits().maxDrawIndirectCount : UINT32_MAX;
+
+		drawBatches.clear();
+		for (uint32_t i = 0; i < static_cast<uint32_t>(renderObjects.size()); ++i)
+		{
+			if (drawBatches.empty() || (drawBatches.back().MaterialIndex != renderObjects[i].MaterialIndex) || (drawBatches.back().InstanceCount >= maxBatchSize))
+			{
+				jDrawBatch batch;
+				batch.MaterialIndex = renderObjects[i].MaterialIndex;
+				batch.FirstInstance = i;
+				drawBatches.push_back(batch);
+			}
+			++drawBatches.back().InstanceCount;
+		}
+	}
+
 	bool CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage
-		, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+		, VkMemoryPropertyFlags properties, VkImage& image, jMemoryAllocation& imageMemory)
 	{
 		VkImageCreateInfo imageInfo = {};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -1642,57 +2259,19 @@ private:
 		VkMemoryRequirements memRequirements;
 		vkGetImageMemoryRequirements(device, image, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-		if (!ensure(vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) == VK_SUCCESS))
+		// 큰 이미지는 할당자가 알아서 Dedicated allocation 으로 처리함.
+		if (!ensure(memoryAllocator.Allocate(memRequirements, properties, 0, (tiling == VK_IMAGE_TILING_LINEAR), false, imageMemory)))
 			return false;
 
-		vkBindImageMemory(device, image, imageMemory, 0);
+		vkBindImageMemory(device, image, imageMemory.Memory, imageMemory.Offset);
 
 		return true;
 	}
 
-	VkCommandBuffer BeginSingleTimeCommands()
+	bool TransitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels)
 	{
-		VkCommandBufferAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = commandPool;
-		allocInfo.commandBufferCount = 1;
-
-		VkCommandBuffer commandBuffer;
-		vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-		vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		return commandBuffer;
-	}
-
-	void EndSingleTimeCommands(VkCommandBuffer commandBuffer)
-	{
-		vkEndCommandBuffer(commandBuffer);
-
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-
-		vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(graphicsQueue);
-
-		// 명령 완료를 기다리기 위해서 2가지 방법이 있는데, Fence를 사용하는 방법(vkWaitForFences)과 Queue가 Idle이 될때(vkQueueWaitIdle)를 기다리는 방법이 있음.
-		// fence를 사용하는 방법이 여러개의 전송을 동시에 하고 마치는 것을 기다릴 수 있게 해주기 때문에 그것을 사용함.
-		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
-	}
-
-	bool TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels)
-	{
-		VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+		if (!ensure(commandBuffer))
+			return false;
 
 		// Layout Transition 에는 image memory barrier 사용
 		// Pipeline barrier는 리소스들 간의 synchronize 를 맞추기 위해 사용 (버퍼를 읽기전에 쓰기가 완료되는 것을 보장받기 위해)
@@ -1729,7 +2308,7 @@ private:
 		barrier.dstAccessMask = 0;	// TODO
 
 		// Barrier 는 동기화를 목적으로 사용하므로, 이 리소스와 연관되는 어떤 종류의 명령이 이전에 일어나야 하는지와
-		// 어떤 종류의 명령이 Barrier를 기다려야 하는지를 명시해야만 한다. vkQueueWaitIdle 을 사용하지만 그래도 수동으로 해줘야 함.
+		// 어떤 종류의 명령이 Barrier를 기다려야 하는지를 명시해야만 한다. 여러 업로드가 한 커맨드 버퍼에 모이므로 정확히 명시해야 함.
 
 		// Undefined -> transfer destination : 이 경우 기다릴 필요없이 바로 쓰면됨. Undefined 라 다른 곳에서 딱히 쓰거나 하는것이 없음.
 		// Transfer destination -> frag shader reading : frag 쉐이더에서 읽기 전에 transfer destination 에서 쓰기가 완료 됨이 보장되어야 함. 그래서 shader 에서 읽기 가능.
@@ -1786,17 +2365,16 @@ private:
 			, 1, &barrier
 		);
 
-		EndSingleTimeCommands(commandBuffer);
-
 		return true;
 	}
 
-	void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+	void CopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t width, uint32_t height)
 	{
-		VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+		if (!ensure(commandBuffer))
+			return;
 
 		VkBufferImageCopy region = {};
-		region.bufferOffset = 0;
+		region.bufferOffset = bufferOffset;
 
 		// 아래 2가지는 얼마나 많은 pixel이 들어있는지 설명, 둘다 0, 0이면 전체
 		region.bufferRowLength = 0;
@@ -1813,29 +2391,35 @@ private:
 		vkCmdCopyBufferToImage(commandBuffer, buffer, image
 			, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL		// image가 현재 어떤 레이아웃으로 사용되는지 명세
 			, 1, &region);
+	}
 
-		EndSingleTimeCommands(commandBuffer);
+	// DEVICE_LOCAL 이면서 HOST_VISIBLE 인 메모리에 버퍼를 만들고 데이터를 바로 씀. Staging 버퍼와 복사 커맨드가 필요없음.
+	// memoryAllocator.IsDirectUploadAvailable() 인 경우(UMA, ReBAR) 에만 사용.
+	bool CreateBufferDirectUpload(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, jMemoryAllocation& bufferMemory)
+	{
+		if (!ensure(CreateBuffer(size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			, buffer, bufferMemory)))
+		{
+			return false;
+		}
+
+		memcpy(bufferMemory.MappedData, data, static_cast<size_t>(size));
+		return true;
 	}
 
 	bool CreateVertexBuffer()
 	{
 		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
 
-		// VK_BUFFER_USAGE_TRANSFER_SRC_BIT : 이 버퍼가 메모리 전송 연산의 소스가 될 수 있음.
-		CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT
-			, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+		if (memoryAllocator.IsDirectUploadAvailable())
+			return CreateBufferDirectUpload(vertices.data(), bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBuffer, vertexBufferMemory);
 
-		//// 마지막 파라메터 0은 메모리 영역의 offset 임.
-		//// 이 값이 0이 아니면 memRequirements.alignment 로 나눠야 함. (align 되어있다는 의미)
-		//vkBindBufferMemory(device, vertexBuffer, vertexBufferMemory, 0);
+		// Staging ring 은 VK_BUFFER_USAGE_TRANSFER_SRC_BIT 로 만들어져 있고, 계속 Map 되어 있으므로 바로 씀.
+		jStagingAllocation staging;
+		if (!ensure(AllocateStaging(bufferSize, staging)))
+			return false;
 
-		void* data;
-		// size 항목에 VK_WHOLE_SIZE  를 넣어서 모든 메모리를 잡을 수도 있음.
-		vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, vertices.data(), (size_t)bufferSize);
-		vkUnmapMemory(device, stagingBufferMemory);
+		memcpy(staging.MappedData, vertices.data(), (size_t)bufferSize);
 
 		// Map -> Unmap 했다가 메모리에 데이터가 즉시 반영되는게 아님
 		// 바로 사용하려면 아래 2가지 방법이 있음.
@@ -1845,13 +2429,15 @@ private:
 
 		// VK_BUFFER_USAGE_TRANSFER_DST_BIT : 이 버퍼가 메모리 전송 연산의 목적지가 될 수 있음.
 		// DEVICE LOCAL 메모리에 VertexBuffer를 만들었으므로 이제 vkMapMemory 같은 것은 할 수 없음.
-		CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
-			, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
-
-		CopyBuffer(stagingBuffer, vertexBuffer, bufferSize);
+		if (!ensure(CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+			, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory)))
+		{
+			return false;
+		}
 
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
+		if (!CopyBuffer(GetTransferCommandBuffer(), staging.Buffer, vertexBuffer, bufferSize, staging.Offset))
+			return false;
+		TransferBufferOwnership(vertexBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 
 		return true;
 	}
@@ -1860,254 +2446,623 @@ private:
 	{
 		VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+		if (memoryAllocator.IsDirectUploadAvailable())
+			return CreateBufferDirectUpload(indices.data(), bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexBufferMemory);
 
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, indices.data(), (size_t)bufferSize);
-		vkUnmapMemory(device, stagingBufferMemory);
+		jStagingAllocation staging;
+		if (!ensure(AllocateStaging(bufferSize, staging)))
+			return false;
 
-		CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
+		memcpy(staging.MappedData, indices.data(), (size_t)bufferSize);
 
-		CopyBuffer(stagingBuffer, indexBuffer, bufferSize);
+		if (!ensure(CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory)))
+			return false;
 
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
+		if (!CopyBuffer(GetTransferCommandBuffer(), staging.Buffer, indexBuffer, bufferSize, staging.Offset))
+			return false;
+		TransferBufferOwnership(indexBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
 
 		return true;
 	}
 
-	bool CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+	bool CopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0)
 	{
-		// 임시 커맨드 버퍼를 통해서 메모리를 전송함.
-		VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
-
-		// VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT : 커맨드버퍼를 1번만 쓰고, 복사가 다 될때까지 기다리기 위해서 사용
+		// 업로드 커맨드 버퍼에 복사를 기록만 함. 실제 복사는 SubmitUploads 로 제출된 뒤에 일어남.
+		if (!ensure(commandBuffer))
+			return false;
 
 		VkBufferCopy copyRegion = {};
-		copyRegion.srcOffset = 0;		// Optional
+		copyRegion.srcOffset = srcOffset;	// Optional
 		copyRegion.dstOffset = 0;		// Optional
 		copyRegion.size = size;			// 여기서는 VK_WHOLE_SIZE 사용 불가
 		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
-		EndSingleTimeCommands(commandBuffer);
+		return true;
+	}
+
+	bool CreateUniformBuffers()
+	{
+		// Frame context 수 만큼 구간을 나눔. 해당 프레임의 제출 값을 기다린 뒤에 구간을 재사용하므로 스왑체인 이미지 수와는 상관없음.
+		const VkDeviceSize minOffsetAlignment = deviceCapabilities.GetLimits().minUniformBufferOffsetAlignment;
+		const uint32_t frameCount = framesInFlight;
+		const VkDeviceSize bufferSize = jUniformRingBuffer::GetRequiredSize(UNIFORM_RING_FRAME_SIZE, frameCount, minOffsetAlignment);
+
+		if (!ensure(CreateBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			, uniformRingBuffer, uniformRingBufferMemory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)))
+		{
+			return false;
+		}
+
+		// 할당자가 Map 해둔 상태를 계속 사용함. HOST_COHERENT 라 따로 Flush 할 필요 없음.
+		if (!ensure(uniformRingBufferMemory.MappedData))
+			return false;
+
+		uniformRing.Initialize(uniformRingBuffer, uniformRingBufferMemory.MappedData, UNIFORM_RING_FRAME_SIZE, frameCount, minOffsetAlignment);
+
+		// 인스턴스 버퍼도 같은 방식으로 프레임별 구간을 나눠서 매 프레임 씀. GPU 컬링이 Model 행렬을 읽으므로 Storage buffer 로도 씀.
+		// Bindless 경로는 이 버퍼를 오브젝트 Storage buffer 로 통째로 바인딩하고 쉐이더가 gl_InstanceIndex 로 읽으므로,
+		// 구간의 시작이 jObjectData 크기의 배수가 되도록 구간 크기를 맞춤. 아닌 경로는 GPU 컬링이 구간을 Offset 으로 바인딩하므로 Storage buffer 정렬을 맞춤.
+		const VkDeviceSize storageAlignment = std::max<VkDeviceSize>(16, deviceCapabilities.GetLimits().minStorageBufferOffsetAlignment);
+		const VkDeviceSize instanceStride = useBindless ? sizeof(jObjectData) : sizeof(jInstanceData);
+		const VkDeviceSize instanceFrameSize = (INSTANCE_RING_FRAME_SIZE / instanceStride) * instanceStride;
+		const VkDeviceSize instanceAlignment = useBindless ? 16 : storageAlignment;
+		const VkDeviceSize instanceBufferSize = jUniformRingBuffer::GetRequiredSize(instanceFrameSize, frameCount, instanceAlignment);
+		const VkBufferUsageFlags instanceUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | (useBindless ? 0 : VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+		if (!ensure(CreateBuffer(instanceBufferSize, instanceUsage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			, instanceRingBuffer, instanceRingBufferMemory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)))
+		{
+			return false;
+		}
+		if (!ensure(instanceRingBufferMemory.MappedData))
+			return false;
+
+		instanceRing.Initialize(instanceRingBuffer, instanceRingBufferMemory.MappedData, instanceFrameSize, frameCount, instanceAlignment);
+
+		// Frames in flight 가 바뀌면 버퍼를 다시 만들므로 그때마다 다시 연결함. 이전 버퍼를 쓰던 프레임은 모두 끝난 상태임.
+		if (useBindless)
+			bindlessDescriptors.SetObjectBuffer(instanceRingBuffer, instanceBufferSize);
+
+		// Indirect 드로우 커맨드와 GPU 컬링의 배치 정보. 드로우 방식은 실행 중에 바꿀 수 있으므로 항상 만듬.
+		// IndirectGpu 에서는 Compute 쉐이더가 이 버퍼에 커맨드를 씀.
+		const VkDeviceSize indirectBufferSize = jUniformRingBuffer::GetRequiredSize(INDIRECT_RING_FRAME_SIZE, frameCount, storageAlignment);
+		if (!ensure(CreateBuffer(indirectBufferSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+			, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			, indirectRingBuffer, indirectRingBufferMemory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)))
+		{
+			return false;
+		}
+		if (!ensure(indirectRingBufferMemory.MappedData))
+			return false;
 
+		indirectRing.Initialize(indirectRingBuffer, indirectRingBufferMemory.MappedData, INDIRECT_RING_FRAME_SIZE, frameCount, storageAlignment);
 		return true;
 	}
 
-	uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	void DestroyUniformBuffers()
 	{
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+		vkDestroyBuffer(device, uniformRingBuffer, nullptr);
+		memoryAllocator.Free(uniformRingBufferMemory);
 
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; ++i)
+		if (instanceRingBuffer)
 		{
-			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-				return i;
+			vkDestroyBuffer(device, instanceRingBuffer, nullptr);
+			memoryAllocator.Free(instanceRingBufferMemory);
+			instanceRingBuffer = VK_NULL_HANDLE;
 		}
 
-		check(0);	// failed to find sutable memory type!
-		return 0;
+		vkDestroyBuffer(device, indirectRingBuffer, nullptr);
+		memoryAllocator.Free(indirectRingBufferMemory);
 	}
 
-	bool CreateUniformBuffers()
+	bool CreateFrameContexts()
 	{
-		VkDeviceSize bufferSize = sizeof(jUniformBufferObject);
-	
-		uniformBuffers.resize(swapChainImages.size());
-		uniformBuffersMemory.resize(swapChainImages.size());
+		const QueueFamilyIndices& queueFamilyIndices = physicalDeviceQueueFamilies;
 
-		for (size_t i = 0; i < swapChainImages.size(); ++i)
+		// 코어 수 만큼 작업을 나눌 수 있도록 함. 호출한 메인 스레드도 작업을 처리하므로 워커는 하나 적게 만듬.
+		recordJobCount = std::max(1u, std::min(std::thread::hardware_concurrency(), MAX_RECORD_JOBS));
+		recordThreadPool.Initialize(recordJobCount - 1);
+		std::cout << "Command buffer record jobs : " << recordJobCount << std::endl;
+
+		frameContexts.resize(framesInFlight);
+		for (jFrameContext& frame : frameContexts)
 		{
-			CreateBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-				| VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i], uniformBuffersMemory[i]);
+			VkCommandPoolCreateInfo poolInfo = {};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+			// 커맨드 버퍼를 개별로 리셋하지 않고 vkResetCommandPool 로 Pool 전체를 리셋하므로 RESET_COMMAND_BUFFER_BIT 은 필요없음.
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			if (!ensure(vkCreateCommandPool(device, &poolInfo, nullptr, &frame.CommandPool) == VK_SUCCESS))
+				return false;
+
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = frame.CommandPool;
+
+			// VK_COMMAND_BUFFER_LEVEL_PRIMARY : 실행을 위해 Queue를 제출할 수 있으면 다른 커맨드버퍼로 부터 호출될 수 없다.
+			// VK_COMMAND_BUFFER_LEVEL_SECONDARY : 직접 제출할 수 없으며, Primary command buffer 로 부터 호출될 수 있다.
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+			if (!ensure(vkAllocateCommandBuffers(device, &allocInfo, &frame.CommandBuffer) == VK_SUCCESS))
+				return false;
+
+			frame.DescriptorAllocator.Initialize(device);
+
+			frame.RecordContexts.resize(recordJobCount);
+			for (jFrameContext::jRecordContext& recordContext : frame.RecordContexts)
+			{
+				if (!ensure(vkCreateCommandPool(device, &poolInfo, nullptr, &recordContext.CommandPool) == VK_SUCCESS))
+					return false;
+
+				VkCommandBufferAllocateInfo secondaryAllocInfo = {};
+				secondaryAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				secondaryAllocInfo.commandPool = recordContext.CommandPool;
+				secondaryAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+				secondaryAllocInfo.commandBufferCount = 1;
+				if (!ensure(vkAllocateCommandBuffers(device, &secondaryAllocInfo, &recordContext.CommandBuffer) == VK_SUCCESS))
+					return false;
+			}
 		}
+
 		return true;
 	}
 
-	bool CreateDescriptorPool()
+	// 이 프레임의 GPU 작업이 끝난 뒤에 호출해야 함.
+	// 커맨드 버퍼를 하나씩 리셋하지 않고 Pool 전체를 리셋하는 것이 가장 쌈.
+	void ResetFrameContext(jFrameContext& frame)
+	{
+		vkResetCommandPool(device, frame.CommandPool, 0);
+		for (jFrameContext::jRecordContext& recordContext : frame.RecordContexts)
+			vkResetCommandPool(device, recordContext.CommandPool, 0);
+		frame.DescriptorAllocator.Reset();
+	}
+
+	// 커맨드 버퍼와 Descriptor set 은 각각 Pool 과 함께 소멸되고, 레이아웃은 모두 캐시가 소유하고 있음.
+	void DestroyFrameContexts()
+	{
+		recordThreadPool.Release();
+
+		for (jFrameContext& frame : frameContexts)
+		{
+			frame.DescriptorAllocator.Release();
+			vkDestroyCommandPool(device, frame.CommandPool, nullptr);
+			for (jFrameContext::jRecordContext& recordContext : frame.RecordContexts)
+				vkDestroyCommandPool(device, recordContext.CommandPool, nullptr);
+			vkDestroySemaphore(device, frame.ImageAvailableSemaphore, nullptr);
+			vkDestroySemaphore(device, frame.RenderFinishedSemaphore, nullptr);
+		}
+		frameContexts.clear();
+	}
+
+	// Frames in flight 수가 바뀌면 진행중인 프레임이 모두 끝난 뒤에 Frame context 와 Uniform ring 을 새 개수로 다시 만듬.
+	// 자주 일어나는 일이 아니므로 간단하게 처리함.
+	bool ApplyFramesInFlight()
 	{
-		std::array<VkDescriptorPoolSize, 2> poolSizes = {};
-		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[0].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
-		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[1].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
+		if (!graphicsTimeline.WaitIdle())
+			return false;
+
+		// 타임라인은 그래픽스 큐의 제출만 추적함. Present 는 아직 RenderFinishedSemaphore 를 기다리고 있을 수 있으므로
+		// 세마포어를 지우기 전에 Present 큐도 비워야 함.
+		if (!ensure(vkQueueWaitIdle(presentQueue) == VK_SUCCESS))
+			return false;
+
+		DestroyFrameContexts();
+		DestroyUniformBuffers();
 
-		VkDescriptorPoolCreateInfo poolInfo = {};
-		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = static_cast<uint32_t>(swapChainImages.size());
-		poolInfo.flags = 0;		// Descriptor Set을 만들고나서 더 이상 손대지 않을거라 그냥 기본값 0으로 설정
+		framesInFlight = requestedFramesInFlight;
+		currenFrame = 0;
+		std::cout << "Frames in flight : " << framesInFlight << std::endl;
 
-		if (!ensure(vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) == VK_SUCCESS))
+		return CreateUniformBuffers() && CreateFrameContexts() && CreateSyncObjects();
+	}
+
+	// 프레임마다 새로 할당하는 씬 Descriptor set. 프레임 할당자가 Reset 될때 한번에 반환되므로 따로 해제하지 않음.
+	bool AllocateSceneDescriptorSet(jDescriptorAllocator& allocator, VkDescriptorSet& descriptorSet)
+	{
+		if (!ensure(allocator.Allocate(descriptorSetLayout, descriptorSet)))
 			return false;
 
+		// 실제 위치는 바인딩 할때 넘기는 Dynamic offset 이 더해져서 결정됨
+		VkDescriptorBufferInfo bufferInfo = {};
+		bufferInfo.buffer = uniformRing.GetBuffer();
+		bufferInfo.offset = 0;
+		bufferInfo.range = sizeof(jUniformBufferObject);		// 전체 사이즈라면 VK_WHOLE_SIZE 이거 가능 (Dynamic 인 경우는 불가)
+
+		VkDescriptorImageInfo imageInfo = {};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = textureImageView;
+		imageInfo.sampler = textureSampler;
+
+		std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
+		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[0].dstSet = descriptorSet;
+		descriptorWrites[0].dstBinding = 0;
+		descriptorWrites[0].dstArrayElement = 0;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		descriptorWrites[0].descriptorCount = 1;
+		descriptorWrites[0].pBufferInfo = &bufferInfo;		// 현재는 Buffer 기반 Desriptor 이므로 이것을 사용
+		descriptorWrites[0].pImageInfo = nullptr;			// Optional	(Image Data 기반에 사용)
+		descriptorWrites[0].pTexelBufferView = nullptr;		// Optional (Buffer View 기반에 사용)
+
+		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[1].dstSet = descriptorSet;
+		descriptorWrites[1].dstBinding = 1;
+		descriptorWrites[1].dstArrayElement = 0;
+		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[1].descriptorCount = 1;
+		descriptorWrites[1].pImageInfo = &imageInfo;
+
+		// Bindless 경로의 쉐이더는 set 0 에 텍스쳐가 없으므로 (레이아웃에도 없음) Uniform buffer 만 씀
+		const uint32_t writeCount = sceneReflection.FindBinding(0, 1) ? 2 : 1;
+		vkUpdateDescriptorSets(device, writeCount, descriptorWrites.data(), 0, nullptr);
+
 		return true;
 	}
 
-	bool CreateDescriptorSets()
+	// 현재 씬 상태로 프레임 커맨드 버퍼를 기록함. 커맨드 버퍼는 frame 의 Pool 이 리셋된 상태여야 함.
+	// maxRecordJobs : 드로우를 나눠서 동시에 기록할 최대 작업 수 (1 이면 메인 스레드에서 Primary 커맨드 버퍼에 바로 기록)
+	bool RecordCommandBuffer(jFrameContext& frame, uint32_t imageIndex, const jUniformAllocation& sceneUniform, const jUniformAllocation& instances
+		, const jIndirectDraws& indirect, uint32_t maxRecordJobs)
 	{
-		std::vector<VkDescriptorSetLayout> layouts(swapChainImages.size(), descriptorSetLayout);
-		VkDescriptorSetAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = descriptorPool;
-		allocInfo.descriptorSetCount = static_cast<uint32_t>(swapChainImages.size());
-		allocInfo.pSetLayouts = layouts.data();
+		VkDescriptorSet sceneDescriptorSet = VK_NULL_HANDLE;
+		if (!AllocateSceneDescriptorSet(frame.DescriptorAllocator, sceneDescriptorSet))
+			return false;
+
+		VkCommandBuffer commandBuffer = frame.CommandBuffer;
 
-		descriptorSets.resize(swapChainImages.size());
-		if (!ensure(vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) == VK_SUCCESS))
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+		// VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT : 커맨드가 한번 실행된다음에 다시 기록됨
+		// VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT : Single Render Pass 범위에 있는 Secondary Command Buffer.
+		// VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT : 실행 대기중인 동안에 다시 서밋 될 수 있음.
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;		// 매 프레임 다시 기록하므로 한번만 제출함
+
+		// 이 플래그는 Secondary command buffer를 위해서만 사용하며, Primary command buffer 로 부터 상속받을 상태를 명시함.
+		beginInfo.pInheritanceInfo = nullptr;	// Optional
+
+		if (!ensure(vkBeginCommandBuffer(commandBuffer, &beginInfo) == VK_SUCCESS))
 			return false;
 
-		for (size_t i = 0; i < swapChainImages.size(); ++i)
+		// Compute 는 렌더 패스 안에서 실행할 수 없으므로 렌더 패스 전에 컬링함
+		if (indirect.Batches.Buffer && !RecordCullPass(commandBuffer, frame.DescriptorAllocator, instances, indirect))
+			return false;
+
+		// Starting render pass
+		VkRenderPassBeginInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = renderPass;
+		renderPassInfo.framebuffer = swapChainFramebuffers[imageIndex];
+
+		// 렌더될 영역이며, 최상의 성능을 위해 attachment의 크기와 동일해야함.
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = swapChainExtent;
+
+		std::array<VkClearValue, 2> clearValues = {};
+		clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };		// CreateRenderPass 할때 사용한 VK_ATTACHMENT_LOAD_OP_CLEAR 를 위해 사용.
+		clearValues[1].depthStencil = { 1.0f, 0 };
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassInfo.pClearValues = clearValues.data();
+
+		const uint32_t drawCount = static_cast<uint32_t>(drawBatches.size());
+		const uint32_t jobCount = std::max(1u, std::min({ maxRecordJobs, static_cast<uint32_t>(frame.RecordContexts.size()), drawCount / MIN_DRAWS_PER_RECORD_JOB }));
+
+		// 커맨드를 기록하는 명령어는 prefix로 모두 vkCmd 가 붙으며, 리턴값은 void 로 에러 핸들링은 따로 안함.
+		// VK_SUBPASS_CONTENTS_INLINE : 렌더 패스 명령이 Primary 커맨드 버퍼에 포함되며, Secondary 커맨드 버퍼는 실행되지 않는다.
+		// VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : 렌더 패스 명령이 Secondary 커맨드 버퍼에서 실행된다.
+		if (jobCount <= 1)
 		{
-			VkDescriptorBufferInfo bufferInfo = {};
-			bufferInfo.buffer = uniformBuffers[i];
-			bufferInfo.offset = 0;
-			bufferInfo.range = sizeof(jUniformBufferObject);		// 전체 사이즈라면 VK_WHOLE_SIZE 이거 가능
-
-			VkDescriptorImageInfo imageInfo = {};
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = textureImageView;
-			imageInfo.sampler = textureSampler;
-
-			std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
-			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[0].dstSet = descriptorSets[i];
-			descriptorWrites[0].dstBinding = 0;
-			descriptorWrites[0].dstArrayElement = 0;
-			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			descriptorWrites[0].descriptorCount = 1;
-			descriptorWrites[0].pBufferInfo = &bufferInfo;		// 현재는 Buffer 기반 Desriptor 이므로 이것을 사용
-			descriptorWrites[0].pImageInfo = nullptr;			// Optional	(Image Data 기반에 사용)
-			descriptorWrites[0].pTexelBufferView = nullptr;		// Optional (Buffer View 기반에 사용)
-
-			descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[1].dstSet = descriptorSets[i];
-			descriptorWrites[1].dstBinding = 1;
-			descriptorWrites[1].dstArrayElement = 0;
-			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			descriptorWrites[1].descriptorCount = 1;
-			descriptorWrites[1].pImageInfo = &imageInfo;
-
-			vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size())
-				, descriptorWrites.data(), 0, nullptr);
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+			RecordDraws(commandBuffer, sceneDescriptorSet, sceneUniform.Offset, instances, indirect, 0, drawCount);
 		}
+		else
+		{
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+			// 드로우를 연속된 구간으로 나눠서 각 작업이 자기 Secondary 커맨드 버퍼에 기록함.
+			// 작업마다 Command pool 이 따로 있고, Descriptor set 할당 같은 공유 상태는 위에서 미리 해뒀으므로 동기화가 필요없음.
+			const uint32_t drawsPerJob = (drawCount + jobCount - 1) / jobCount;
+			std::atomic<bool> recordSucceeded(true);
+			recordThreadPool.ParallelFor(jobCount, [&](uint32_t jobIndex)
+			{
+				VkCommandBuffer secondaryCommandBuffer = frame.RecordContexts[jobIndex].CommandBuffer;
+
+				// Secondary 커맨드 버퍼는 어떤 렌더 패스 안에서 실행될지 알려줘야 함
+				VkCommandBufferInheritanceInfo inheritanceInfo = {};
+				inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+				inheritanceInfo.renderPass = renderPass;
+				inheritanceInfo.subpass = 0;
+				inheritanceInfo.framebuffer = swapChainFramebuffers[imageIndex];		// Optional, 알려주면 드라이버가 최적화 할 수 있음
+
+				VkCommandBufferBeginInfo secondaryBeginInfo = {};
+				secondaryBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				secondaryBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+				secondaryBeginInfo.pInheritanceInfo = &inheritanceInfo;
+				if (vkBeginCommandBuffer(secondaryCommandBuffer, &secondaryBeginInfo) != VK_SUCCESS)
+				{
+					recordSucceeded = false;
+					return;
+				}
+
+				const uint32_t firstDraw = std::min(jobIndex * drawsPerJob, drawCount);
+				const uint32_t lastDraw = std::min(firstDraw + drawsPerJob, drawCount);
+				RecordDraws(secondaryCommandBuffer, sceneDescriptorSet, sceneUniform.Offset, instances, indirect, firstDraw, lastDraw);
+
+				if (vkEndCommandBuffer(secondaryCommandBuffer) != VK_SUCCESS)
+					recordSucceeded = false;
+			});
+			if (!ensure(recordSucceeded.load()))
+				return false;
+
+			// 작업 순서대로 실행하므로 한 스레드에서 기록한 것과 같은 순서로 그려짐
+			std::vector<VkCommandBuffer> secondaryCommandBuffers(jobCount);
+			for (uint32_t jobIndex = 0; jobIndex < jobCount; ++jobIndex)
+				secondaryCommandBuffers[jobIndex] = frame.RecordContexts[jobIndex].CommandBuffer;
+			vkCmdExecuteCommands(commandBuffer, jobCount, secondaryCommandBuffers.data());
+		}
+
+		// Finishing up
+		vkCmdEndRenderPass(commandBuffer);
+
+		if (!ensure(vkEndCommandBuffer(commandBuffer) == VK_SUCCESS))
+			return false;
 
 		return true;
 	}
 
-	bool CreateCommandBuffers()
+	// IndirectGpu 에서 오브젝트 마다 절두체 컬링을 하고 보이는 오브젝트의 드로우 커맨드를 씀. (Shaders/cull.comp)
+	// CPU 는 오브젝트 수와 상관없이 Dispatch 하나와 배리어만 기록함.
+	bool RecordCullPass(VkCommandBuffer commandBuffer, jDescriptorAllocator& allocator, const jUniformAllocation& instances, const jIndirectDraws& indirect)
 	{
-		commandBuffers.resize(swapChainFramebuffers.size());
+		VkDescriptorSet cullDescriptorSet = VK_NULL_HANDLE;
+		if (!ensure(allocator.Allocate(cullDescriptorSetLayout, cullDescriptorSet)))
+			return false;
 
-		VkCommandBufferAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.commandPool = commandPool;
+		// Model 행렬은 그릴때 쓰는 버퍼에서 그대로 읽음. Bindless 경로는 그릴때와 같이 버퍼 전체를 바인딩하고 BaseInstance 부터 읽음.
+		std::array<VkDescriptorBufferInfo, 3> bufferInfos = {};
+		bufferInfos[0].buffer = instances.Buffer;
+		bufferInfos[0].offset = useBindless ? 0 : instances.Offset;
+		bufferInfos[0].range = useBindless ? VK_WHOLE_SIZE : instances.Size;
+		bufferInfos[1].buffer = indirect.Batches.Buffer;
+		bufferInfos[1].offset = indirect.Batches.Offset;
+		bufferInfos[1].range = indirect.Batches.Size;
+		bufferInfos[2].buffer = indirect.Commands.Buffer;
+		bufferInfos[2].offset = indirect.Commands.Offset;
+		bufferInfos[2].range = indirect.Commands.Size;
+
+		std::array<VkWriteDescriptorSet, 3> descriptorWrites = {};
+		for (uint32_t i = 0; i < static_cast<uint32_t>(descriptorWrites.size()); ++i)
+		{
+			descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[i].dstSet = cullDescriptorSet;
+			descriptorWrites[i].dstBinding = i;
+			descriptorWrites[i].dstArrayElement = 0;
+			descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptorWrites[i].descriptorCount = 1;
+			descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+		}
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+		jCullConstants constants;
+		constants.ViewProj = cullViewProj;
+		constants.BoundingSphere[0] = meshBoundingCenter.x;
+		constants.BoundingSphere[1] = meshBoundingCenter.y;
+		constants.BoundingSphere[2] = meshBoundingCenter.z;
+		constants.BoundingSphere[3] = meshBoundingRadius;
+		constants.ObjectCount = static_cast<uint32_t>(renderObjects.size());
+		constants.BatchCount = static_cast<uint32_t>(drawBatches.size());
+		constants.ObjectStride = static_cast<uint32_t>((useBindless ? sizeof(jObjectData) : sizeof(jInstanceData)) / (sizeof(float) * 4));
+		constants.IndexCount = static_cast<uint32_t>(indices.size());
+		constants.Compact = useDrawIndirectCount ? 1 : 0;
+		constants.BaseInstance = GetBaseInstance(instances);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1, &cullDescriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(commandBuffer, (constants.ObjectCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+		// 드로우가 커맨드와 DrawCount 를 읽기 전에 Compute 쉐이더의 쓰기가 끝나야 함
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		return true;
+	}
 
-		// VK_COMMAND_BUFFER_LEVEL_PRIMARY : 실행을 위해 Queue를 제출할 수 있으면 다른 커맨드버퍼로 부터 호출될 수 없다.
-		// VK_COMMAND_BUFFER_LEVEL_SECONDARY : 직접 제출할 수 없으며, Primary command buffer 로 부터 호출될 수 있다.
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+	// 와이어프레임처럼 모든 오브젝트를 같은 파이프라인으로 그리는 경우가 아니면 머터리얼의 파이프라인을 씀.
+	// 아직 요청하지 않은 머터리얼은 씬 파이프라인으로 그리고, 요청했지만 컴파일 중인 것은 jPipelineStateCache 가 Fallback 을 돌려줌.
+	jPipelineHandle GetMaterialPipeline(uint32_t materialIndex) const
+	{
+		if (overridePipeline != INVALID_PIPELINE_HANDLE)
+			return overridePipeline;
+		if ((materialIndex < materialPipelines.size()) && (materialPipelines[materialIndex] != INVALID_PIPELINE_HANDLE))
+			return materialPipelines[materialIndex];
+		return scenePipeline;
+	}
 
-		if (!ensure(vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) == VK_SUCCESS))
-			return false;
+	// 드로우의 firstInstance 에 더할 값. Bindless 경로는 오브젝트 버퍼를 모든 프레임 구간에 걸쳐 바인딩하므로 이번 프레임 구간의 시작 인덱스이고,
+	// 아닌 경로는 인스턴스 버텍스 스트림을 구간의 Offset 으로 바인딩하므로 0 임.
+	uint32_t GetBaseInstance(const jUniformAllocation& instances) const
+	{
+		if (!useBindless)
+			return 0;
+
+		JASSERT((instances.Offset % sizeof(jObjectData)) == 0);
+		return static_cast<uint32_t>(instances.Offset / sizeof(jObjectData));
+	}
 
-		// Begin command buffers
-		for (size_t i = 0; i < commandBuffers.size(); ++i)
+	// drawBatches 의 [firstDraw, lastDraw) 구간을 그리는 커맨드를 기록함. 여러 스레드에서 동시에 호출될 수 있으므로 멤버를 수정하면 안됨.
+	// Secondary 커맨드 버퍼는 Primary 의 바인딩 상태를 물려받지 않으므로 파이프라인과 리소스를 매번 바인딩 함.
+	// instances : 이번 프레임의 인스턴스 데이터 (UpdateInstanceBuffer)
+	// indirect : Indirect 드로우 데이터 (UpdateIndirectBuffer). 비어있으면 배치 마다 vkCmdDrawIndexed 로 그림.
+	void RecordDraws(VkCommandBuffer commandBuffer, VkDescriptorSet sceneDescriptorSet, uint32_t dynamicOffset, const jUniformAllocation& instances
+		, const jIndirectDraws& indirect, uint32_t firstDraw, uint32_t lastDraw) const
+	{
+		// Basic drawing commands
+		// 파이프라인은 배치의 머터리얼에 따라 바뀌므로 드로우 하면서 바인딩 함. 이전과 같으면 다시 바인딩하지 않음.
+		VkPipeline boundPipeline = VK_NULL_HANDLE;
+		auto BindBatchPipeline = [&](const jDrawBatch& batch)
 		{
-			VkCommandBufferBeginInfo beginInfo = {};
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			const VkPipeline pipeline = pipelineStateCache.GetPipeline(GetMaterialPipeline(batch.MaterialIndex));
+			if (pipeline != boundPipeline)
+			{
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+				boundPipeline = pipeline;
+			}
+		};
 
-			// VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT : 커맨드가 한번 실행된다음에 다시 기록됨
-			// VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT : Single Render Pass 범위에 있는 Secondary Command Buffer.
-			// VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT : 실행 대기중인 동안에 다시 서밋 될 수 있음.
-			beginInfo.flags = 0;					// Optional
+		// Dynamic state 는 Secondary 커맨드 버퍼에 상속되지 않으므로 커맨드 버퍼마다 설정해야 함.
+		// SwapChain의 이미지 사이즈가 이 클래스에 정의된 상수 WIDTH, HEIGHT와 다를 수 있다는 것을 기억 해야함.
+		// [minDepth ~ maxDepth] 는 [0.0 ~ 1.0] 이며 특별한 경우가 아니면 이 범위로 사용하면 된다.
+		// Scissor Rect 영역을 설정해주면 영역내에 있는 Pixel만 레스터라이저를 통과할 수 있으며 나머지는 버려(Discard)진다.
+		VkViewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(swapChainExtent.width);
+		viewport.height = static_cast<float>(swapChainExtent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
-			// 이 플래그는 Secondary command buffer를 위해서만 사용하며, Primary command buffer 로 부터 상속받을 상태를 명시함.
-			beginInfo.pInheritanceInfo = nullptr;	// Optional
+		VkRect2D scissor = {};
+		scissor.offset = { 0, 0 };
+		scissor.extent = swapChainExtent;
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-			if (!ensure(vkBeginCommandBuffer(commandBuffers[i], &beginInfo) == VK_SUCCESS))
-				return false;
+		// binding 0 : 메시의 버택스, binding 1 : 인스턴스 데이터 (Bindless 경로는 같은 데이터를 오브젝트 Storage buffer 로 읽으므로 없음)
+		VkBuffer vertexBuffers[] = { vertexBuffer, instances.Buffer };
+		VkDeviceSize offsets[] = { 0, instances.Offset };
+		vkCmdBindVertexBuffers(commandBuffer, 0, useBindless ? 1 : 2, vertexBuffers, offsets);
 
-			// Starting render pass
-			VkRenderPassBeginInfo renderPassInfo = {};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = renderPass;
-			renderPassInfo.framebuffer = swapChainFramebuffers[i];
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 
-			// 렌더될 영역이며, 최상의 성능을 위해 attachment의 크기와 동일해야함.
-			renderPassInfo.renderArea.offset = { 0, 0 };
-			renderPassInfo.renderArea.extent = swapChainExtent;
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &sceneDescriptorSet, 1, &dynamicOffset);
 
-			std::array<VkClearValue, 2> clearValues = {};
-			clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };		// CreateRenderPass 할때 사용한 VK_ATTACHMENT_LOAD_OP_CLEAR 를 위해 사용.
-			clearValues[1].depthStencil = { 1.0f, 0 };
-			renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-			renderPassInfo.pClearValues = clearValues.data();
+		if (useBindless)
+		{
+			// Bindless set 은 한번만 바인딩함. 쉐이더는 gl_InstanceIndex(firstInstance 부터 시작) 로 오브젝트 버퍼를 읽음.
+			VkDescriptorSet bindlessSet = bindlessDescriptors.GetDescriptorSet();
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &bindlessSet, 0, nullptr);
+		}
+		const uint32_t baseInstance = GetBaseInstance(instances);
 
-			// 커맨드를 기록하는 명령어는 prefix로 모두 vkCmd 가 붙으며, 리턴값은 void 로 에러 핸들링은 따로 안함.
-			// VK_SUBPASS_CONTENTS_INLINE : 렌더 패스 명령이 Primary 커맨드 버퍼에 포함되며, Secondary 커맨드 버퍼는 실행되지 않는다.
-			// VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : 렌더 패스 명령이 Secondary 커맨드 버퍼에서 실행된다.
-			vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		// 배치 마다 드로우 하나. 인스턴스 속성도 firstInstance 번째 데이터부터 읽으므로 두 경로 모두 FirstInstance 만 넘기면 됨.
+		// Indirect 드로우도 커맨드의 firstInstance 로 baseInstance 를 더한 같은 값이 넘어감.
+		const uint32_t commandStride = sizeof(VkDrawIndexedIndirectCommand);
+		for (uint32_t drawIndex = firstDraw; drawIndex < lastDraw; ++drawIndex)
+		{
+			const jDrawBatch& batch = drawBatches[drawIndex];
+			BindBatchPipeline(batch);
 
-			// Basic drawing commands
-			vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+			if (!indirect.Commands.Buffer)
+			{
+				//vkCmdDraw(commandBuffer, static_cast<uint32_t>(vertices.size()), 1, 0, 0);			// VertexBuffer 만 있는 경우 호출
+				vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), batch.InstanceCount, 0, 0, baseInstance + batch.FirstInstance);
+			}
+			else if (indirect.Batches.Buffer)
+			{
+				// IndirectGpu : 배치의 커맨드 슬롯은 FirstInstance 부터 오브젝트 수 만큼 있음.
+				// Count 를 쓸 수 있으면 보이는 오브젝트 수(DrawCount) 만큼만 그리고, 아니면 안보이는 것은 instanceCount 가 0 인 커맨드임.
+				const VkDeviceSize commandOffset = indirect.Commands.Offset + static_cast<VkDeviceSize>(commandStride) * batch.FirstInstance;
+				if (useDrawIndirectCount)
+				{
+					const VkDeviceSize countOffset = indirect.Batches.Offset + sizeof(jCullBatch) * drawIndex + offsetof(jCullBatch, DrawCount);
+					vkCmdDrawIndexedIndirectCount(commandBuffer, indirect.Commands.Buffer, commandOffset, indirect.Batches.Buffer, countOffset, batch.InstanceCount, commandStride);
+				}
+				else
+				{
+					vkCmdDrawIndexedIndirect(commandBuffer, indirect.Commands.Buffer, commandOffset, batch.InstanceCount, commandStride);
+				}
+			}
+			else
+			{
+				// IndirectCpu : 파이프라인이 같은 연속된 배치들은 커맨드가 붙어있으므로 한번에 그림
+				uint32_t drawCount = 1;
+				if (deviceCapabilities.GetFeatures().multiDrawIndirect)
+				{
+					const uint32_t maxDrawCount = deviceCapabilities.GetLimits().maxDrawIndirectCount;
+					while ((drawIndex + drawCount < lastDraw) && (drawCount < maxDrawCount)
+						&& (pipelineStateCache.GetPipeline(GetMaterialPipeline(drawBatches[drawIndex + drawCount].MaterialIndex)) == boundPipeline))
+					{
+						++drawCount;
+					}
+				}
 
-			VkBuffer vertexBuffers[] = { vertexBuffer };
-			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
+				const VkDeviceSize commandOffset = indirect.Commands.Offset + static_cast<VkDeviceSize>(commandStride) * drawIndex;
+				vkCmdDrawIndexedIndirect(commandBuffer, indirect.Commands.Buffer, commandOffset, drawCount, commandStride);
+				drawIndex += drawCount - 1;
+			}
+		}
+	}
 
-			vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	// 같은 메시를 COMMAND_RECORD_BENCHMARK_DRAWS 번 그리는 씬으로 작업 수를 바꿔가며 기록 시간을 측정함.
+	// 기록만 하고 제출하지 않음. 인스턴스 데이터는 실제 프레임과 같이 UpdateInstanceBuffer 로 써서 두 경로 모두 유효한 범위만 기록됨.
+	// 오브젝트마다 다른 머터리얼 인덱스를 줘서 배치로 묶이지 않는 경우(오브젝트당 드로우 하나) 와 인스턴싱으로 모두 묶이는 경우를 비교함.
+	void BenchmarkCommandRecording()
+	{
+		const std::vector<jRenderObject> savedRenderObjects = renderObjects;
+		renderObjects.resize(COMMAND_RECORD_BENCHMARK_DRAWS, savedRenderObjects.empty() ? jRenderObject() : savedRenderObjects[0]);
 
-			vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[i], 0, nullptr);
+		jFrameContext& frame = frameContexts[0];
+		for (const bool instanced : { false, true })
+		{
+			// 없는 머터리얼 인덱스는 씬 파이프라인으로 그려지므로 파이프라인은 모두 같음
+			for (uint32_t i = 0; i < static_cast<uint32_t>(renderObjects.size()); ++i)
+				renderObjects[i].MaterialIndex = instanced ? 0 : i;
+			BuildDrawBatches();
+
+			jUniformAllocation sceneUniform;
+			jUniformAllocation instances;
+			jIndirectDraws indirect;
+			if (!ensure(UpdateUniformBuffer(0, sceneUniform) && UpdateInstanceBuffer(0, instances) && UpdateIndirectBuffer(0, instances, indirect)))
+				break;
 
-			//vkCmdDraw(commandBuffers[i], static_cast<uint32_t>(vertices.size()), 1, 0, 0);			// VertexBuffer 만 있는 경우 호출
-			vkCmdDrawIndexed(commandBuffers[i], static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+			double singleJobMs = 0.0;
+			for (uint32_t jobCount = 1; ; jobCount = std::min(jobCount * 2, recordJobCount))
+			{
+				double totalMs = 0.0;
+				for (uint32_t i = 0; i < COMMAND_RECORD_BENCHMARK_ITERATIONS; ++i)
+				{
+					ResetFrameContext(frame);
+					const auto startTime = std::chrono::high_resolution_clock::now();
+					RecordCommandBuffer(frame, 0, sceneUniform, instances, indirect, jobCount);
+					totalMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+				}
 
-			// Finishing up
-			vkCmdEndRenderPass(commandBuffers[i]);
+				const double averageMs = totalMs / COMMAND_RECORD_BENCHMARK_ITERATIONS;
+				if (jobCount == 1)
+					singleJobMs = averageMs;
+				std::cout << "Record benchmark : " << COMMAND_RECORD_BENCHMARK_DRAWS << " objects in " << drawBatches.size() << " batches ("
+					<< GetDrawSubmitModeString(drawSubmitMode) << "), " << jobCount << " jobs : "
+					<< averageMs << " ms (x" << (singleJobMs / averageMs) << ")" << std::endl;
 
-			if (!ensure(vkEndCommandBuffer(commandBuffers[i]) == VK_SUCCESS))
-				return false;
+				if (jobCount >= recordJobCount)
+					break;
+			}
 		}
 
-		return true;
+		ResetFrameContext(frame);
+		renderObjects = savedRenderObjects;
+		BuildDrawBatches();
 	}
 
 	bool CreateSyncObjects()
 	{
+		// CPU - GPU 간 동기화는 모두 graphicsTimeline 의 값으로 하므로 펜스는 만들지 않음.
+		// 스왑체인의 이미지 획득과 Present 는 Timeline semaphore 를 쓸 수 없어서 바이너리 세마포어를 Frame context 마다 둠.
 		VkSemaphoreCreateInfo semaphoreInfo = {};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-#if MULTIPLE_FRAME
-		VkFenceCreateInfo fenceInfo = {};
-		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-		imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-		imagesInFlight.resize(swapChainImages.size(), VK_NULL_HANDLE);
-
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		for (jFrameContext& frame : frameContexts)
 		{
-			if (!ensure(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) == VK_SUCCESS)
-				|| !ensure(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) == VK_SUCCESS)
-				|| !ensure(vkCreateFence(device, &fenceInfo, nullptr, &inFlightFences[i]) == VK_SUCCESS))
+			frame.SubmitValue = 0;
+			if (!ensure(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frame.ImageAvailableSemaphore) == VK_SUCCESS)
+				|| !ensure(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frame.RenderFinishedSemaphore) == VK_SUCCESS))
 			{
 				return false;
 			}
 		}
-#else
-		if (!ensure(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphore) == VK_SUCCESS)
-			|| !ensure(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphore) == VK_SUCCESS))
-		{
-			return false;
-		}
-#endif // MULTIPLE_FRAME
 		return true;
 	}
 
@@ -2129,24 +3084,60 @@ private:
 		// 1. 이미지를 획득해서 렌더링 준비가 완료된 경우 Signal(Lock 이 풀리는) 되는 것 (imageAvailableSemaphore)
 		// 2. 렌더링을 마쳐서 Presentation 가능한 상태에서 Signal 되는 것 (renderFinishedSemaphore)
 
-#if MULTIPLE_FRAME
-		vkWaitForFences(device, 1, &inFlightFences[currenFrame], VK_TRUE, UINT64_MAX);
-#endif // MULTIPLE_FRAME
+		if (requestedFramesInFlight != framesInFlight)
+		{
+			if (!ensure(ApplyFramesInFlight()))
+				return false;
+		}
 
-		uint32_t imageIndex;
-		// timeout 은 nanoseconds. UINT64_MAX 는 타임아웃 없음
-#if MULTIPLE_FRAME
-		VkResult acquireNextImageResult = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphores[currenFrame], VK_NULL_HANDLE, &imageIndex);
+		jFrameContext& frame = frameContexts[currenFrame];
+		const uint32_t frameIndex = currenFrame;
 
-		// 이전 프레임에서 현재 사용하려는 이미지를 사용중에 있나? (그렇다면 펜스를 기다려라)
-		if (imagesInFlight[imageIndex] != VK_NULL_HANDLE)
-			vkWaitForFences(device, 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+		// 펜스 대신 Graphics timeline 의 값으로 CPU 가 GPU 를 기다림. 프레임마다 펜스를 리셋할 필요 없음.
+		// 이 Frame context 를 마지막으로 사용한 제출이 끝날때까지 기다림. 처음 사용하는 경우는 0 이라 바로 통과함.
+		graphicsTimeline.Wait(frame.SubmitValue);
 
-		// 이 프레임에서 펜스를 사용한다고 마크 해둠
-		imagesInFlight[imageIndex] = inFlightFences[currenFrame];
-#else
-		VkResult acquireNextImageResult = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
-#endif // MULTIPLE_FRAME
+		// 사용이 끝난 리소스들을 지움. 프레임 도중에 교체된 리소스도 여기서 디바이스 전체를 기다리지 않고 해제됨.
+		deletionQueue.Flush(graphicsTimeline.GetCompletedValue());
+
+		// 백그라운드 컴파일이 끝난 파이프라인을 반영하고 이번 프레임에 쓸 조합을 고름.
+		// 머터리얼 변형과 와이어프레임은 처음 쓰일때 요청되며, 컴파일이 끝날때까지는 씬 파이프라인으로 그리므로 프레임이 멈추지 않음.
+		// 같은 기능 조합의 머터리얼은 같은 Desc 가 되므로 파이프라인을 공유함.
+		// 쉐이더 소스가 바뀌었으면 그 소스를 쓰는 파이프라인만 다시 컴파일하고, 끝나면 같은 핸들로 교체됨.
+		// 교체된 파이프라인과 이전 쉐이더 모듈은 마지막으로 제출한 프레임이 끝난 뒤에 삭제 큐에서 지워지므로 vkDeviceWaitIdle 이 필요 없음.
+		std::vector<std::string> changedShaders;
+		if (shaderWatcher.ConsumeChanges(changedShaders))
+		{
+			for (const std::string& changedShader : changedShaders)
+			{
+				const uint32_t reloadCount = pipelineStateCache.Reload(changedShader);
+				if (reloadCount > 0)
+					std::cout << "Hot reload : " << changedShader << " (" << reloadCount << " pipelines)" << std::endl;
+			}
+		}
+		pipelineStateCache.Update(deletionQueue, graphicsTimeline.GetLastSubmittedValue());
+		for (size_t i = 0; i < materials.size(); ++i)
+		{
+			if (materialPipelines[i] == INVALID_PIPELINE_HANDLE)
+				materialPipelines[i] = pipelineStateCache.Request(GetScenePipelineDesc(materials[i]), scenePipeline);
+		}
+
+		overridePipeline = INVALID_PIPELINE_HANDLE;
+		if (wireframe && deviceCapabilities.GetFeatures().fillModeNonSolid)
+		{
+			if (wireframePipeline == INVALID_PIPELINE_HANDLE)
+			{
+				jGraphicsPipelineDesc desc = GetScenePipelineDesc(jMaterial());
+				desc.PolygonMode = VK_POLYGON_MODE_LINE;
+				desc.CullMode = VK_CULL_MODE_NONE;
+				wireframePipeline = pipelineStateCache.Request(desc, scenePipeline);
+			}
+			overridePipeline = wireframePipeline;
+		}
+
+		uint32_t imageIndex;
+		// timeout 은 nanoseconds. UINT64_MAX 는 타임아웃 없음
+		VkResult acquireNextImageResult = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, frame.ImageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
 
 		// 여기서는 VK_SUCCESS or VK_SUBOPTIMAL_KHR 은 성공했다고 보고 계속함.
 		// VK_ERROR_OUT_OF_DATE_KHR : 스왑체인이 더이상 서피스와 렌더링하는데 호환되지 않는 경우. (보통 윈도우 리사이즈 이후)
@@ -2162,48 +3153,60 @@ private:
 			return false;
 		}
 
-		UpdateUniformBuffer(imageIndex);
+		// 이전 프레임에서 현재 사용하려는 이미지를 사용중에 있나? (스왑체인 이미지 수보다 Frames in flight 가 많은 경우, 그렇다면 그 제출 값을 기다림)
+		graphicsTimeline.Wait(swapChainImageSubmitValues[imageIndex]);
 
-		// Submitting the command buffer
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		// 이 프레임의 제출 값을 기다렸으므로 이전에 기록한 커맨드 버퍼와 Descriptor set 은 더 이상 사용되지 않음.
+		ResetFrameContext(frame);
 
-#if MULTIPLE_FRAME
-		VkSemaphore waitsemaphores[] = { imageAvailableSemaphores[currenFrame] };
-#else
-		VkSemaphore waitsemaphores[] = { imageAvailableSemaphore };
-#endif // MULTIPLE_FRAME
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = waitsemaphores;
-		submitInfo.pWaitDstStageMask = waitStages;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
-
-#if MULTIPLE_FRAME
-		VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currenFrame] };
-#else
-		VkSemaphore signalSemaphores[] = { renderFinishedSemaphore };
-#endif // MULTIPLE_FRAME
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = signalSemaphores;
+		jUniformAllocation sceneUniform;
+		if (!ensure(UpdateUniformBuffer(frameIndex, sceneUniform)))
+			return false;
 
-		// SubmitInfo를 동시에 할수도 있음.
-#if MULTIPLE_FRAME
-		vkResetFences(device, 1, &inFlightFences[currenFrame]);		// 세마포어와는 다르게 수동으로 펜스를 unsignaled 상태로 재설정 해줘야 함
+		jUniformAllocation instances;
+		if (!ensure(UpdateInstanceBuffer(frameIndex, instances)))
+			return false;
 
-		// 마지막에 Fences 파라메터는 커맨드 버퍼가 모두 실행되고나면 Signaled 될 Fences.
-		if (!ensure(vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currenFrame]) == VK_SUCCESS))
+		jIndirectDraws indirect;
+		if (!ensure(UpdateIndirectBuffer(frameIndex, instances, indirect)))
 			return false;
-#else
-		if (!ensure(vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS))
+
+		// 씬이 바뀌어도 스왑체인을 다시 만들 필요 없이 매 프레임 현재 상태로 다시 기록함
+		const auto recordStartTime = std::chrono::high_resolution_clock::now();
+		if (!RecordCommandBuffer(frame, imageIndex, sceneUniform, instances, indirect, recordJobCount))
 			return false;
-#endif // MULTIPLE_FRAME
+		const double recordMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recordStartTime).count();
+		commandRecordTotalMs += recordMs;
+		commandRecordMaxMs = std::max(commandRecordMaxMs, recordMs);
+		++commandRecordCount;
+
+		// 프레임 도중 기록된 업로드가 있으면 프레임 커맨드 버퍼보다 먼저 제출함. 기록된 것이 없으면 아무것도 하지 않음.
+		SubmitUploads();
+
+		// Submitting the command buffer
+		// 이미지를 획득할때까지 Color attachment 에 쓰는 단계만 기다리고, 끝나면 Present 용 세마포어와 Graphics timeline 을 같이 Signal 함.
+		jSemaphoreWait imageAvailableWait;
+		imageAvailableWait.Semaphore = frame.ImageAvailableSemaphore;
+		imageAvailableWait.Stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+		jQueueSubmitInfo submitInfo;
+		submitInfo.CommandBuffers = &frame.CommandBuffer;
+		submitInfo.CommandBufferCount = 1;
+		submitInfo.Waits = &imageAvailableWait;
+		submitInfo.WaitCount = 1;
+		submitInfo.BinarySignals = &frame.RenderFinishedSemaphore;
+		submitInfo.BinarySignalCount = 1;
+
+		const uint64_t submitValue = graphicsTimeline.Submit(submitInfo);
+		if (!ensure(submitValue))
+			return false;
+		frame.SubmitValue = submitValue;
+		swapChainImageSubmitValues[imageIndex] = submitValue;
 
 		VkPresentInfoKHR presentInfo = {};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = signalSemaphores;
+		presentInfo.pWaitSemaphores = &frame.RenderFinishedSemaphore;
 
 		VkSwapchainKHR swapChains[] = { swapChain };
 		presentInfo.swapchainCount = 1;
@@ -2232,11 +3235,8 @@ private:
 		// 여러 프레임에 걸쳐 동시에 imageAvailableSemaphore 와 renderFinishedSemaphore를 재사용하게 되는 문제가 있음.
 		// 1). 한프레임을 마치고 큐가 빌때까지 기다리는 것으로 해결할 수 있음. 한번에 1개의 프레임만 완성 가능(최적의 해결방법은 아님)
 		// 2). 여러개의 프레임을 동시에 처리 할수있도록 확장. 동시에 진행될 수 있는 최대 프레임수를 지정해줌.
-#if MULTIPLE_FRAME
-		currenFrame = (currenFrame + 1) % MAX_FRAMES_IN_FLIGHT;
-#else
-		vkQueueWaitIdle(presentQueue);
-#endif // MULTIPLE_FRAME
+		// 지금은 2) 를 사용하며, framesInFlight 가 1 이면 1) 과 같음.
+		currenFrame = (currenFrame + 1) % framesInFlight;
 
 		return true;
 	}
@@ -2245,31 +3245,20 @@ private:
 	{
 		vkDestroyImageView(device, colorImageView, nullptr);
 		vkDestroyImage(device, colorImage, nullptr);
-		vkFreeMemory(device, colorImageMemory, nullptr);
+		memoryAllocator.Free(colorImageMemory);
 
 		vkDestroyImageView(device, depthImageView, nullptr);
 		vkDestroyImage(device, depthImage, nullptr);
-		vkFreeMemory(device, depthImageMemory, nullptr);
+		memoryAllocator.Free(depthImageMemory);
 
 		// ImageViews and RenderPass 가 소멸되기전에 호출되어야 함
 		for (auto framebuffer : swapChainFramebuffers)
 			vkDestroyFramebuffer(device, framebuffer, nullptr);
 
-		// Command buffer pool 을 다시 만들기 보다 있는 커맨드 버퍼 풀을 cleanup 하고 재사용 함.
-		vkFreeCommandBuffers(device, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
-
 		for (auto imageView : swapChainImageViews)
 			vkDestroyImageView(device, imageView, nullptr);
 
 		vkDestroySwapchainKHR(device, swapChain, nullptr);
-
-		for (size_t i = 0; i < swapChainImages.size(); ++i)
-		{
-			vkDestroyBuffer(device, uniformBuffers[i], nullptr);
-			vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
-		}
-
-		vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 	}
 
 	void RecreateSwapChain()
@@ -2286,24 +3275,37 @@ private:
 		// 사용중인 리소스에 손을 댈수 없기 때문에 모두 사용될때까지 기다림
 		vkDeviceWaitIdle(device);
 
+		const VkFormat oldSwapChainImageFormat = swapChainImageFormat;
 		CleanupSwapChain();
 
 		CreateSwapChain();
 		CreateImageViews();			// Swapchain images 과 연관 있어서 다시 만듬
-		CreateRenderPass();			// ImageView 와 연관 있어서 다시 만듬
-		CreateGraphicsPipeline();	// 가끔 image format 이 다르기도 함.
-									// Viewport나 Scissor Rectangle size 가 Graphics Pipeline 에 있으므로 재생성.
-									// (DynamicState로 Viewport 와 Scissor 사용하고 변경점이 이것 뿐이면 재생성 피할수 있음)
+
+		// RenderPass 는 어태치먼트의 포맷과 샘플 수만 가지고 있고, Viewport 와 Scissor 는 Dynamic state 이므로
+		// 크기만 바뀐 경우(창 크기 변경, 전체화면 전환) 는 RenderPass 와 파이프라인을 그대로 씀.
+		// 가끔 image format 이 다르기도 한데 그때만 다시 만들고, 이전 것은 삭제 큐에 넘김.
+		if (swapChainImageFormat != oldSwapChainImageFormat)
+		{
+			const uint64_t lastUsedValue = graphicsTimeline.GetLastSubmittedValue();
+			pipelineStateCache.Clear(deletionQueue, lastUsedValue);
+			deletionQueue.PushPipelineLayout(lastUsedValue, pipelineLayout);
+			deletionQueue.PushRenderPass(lastUsedValue, renderPass);
+
+			CreateRenderPass();
+			CreateGraphicsPipeline();
+		}
 		CreateColorResources();
 		CreateDepthResources();
 		CreateFrameBuffers();		// Swapchain images 과 연관 있어서 다시 만듬
-		CreateUniformBuffers();
-		CreateDescriptorPool();
-		CreateDescriptorSets();
-		CreateCommandBuffers();		// Swapchain images 과 연관 있어서 다시 만듬
+									// 커맨드 버퍼는 매 프레임 다시 기록하므로 다시 만들 필요 없음
+
+		SubmitUploads();			// Depth 이미지의 레이아웃 전환
 	}
 
-	bool CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+	// properties : 메모리 타입이 반드시 가져야 하는 플래그
+	// preferredProperties : 있으면 우선해서 선택하는 플래그 (ex. Uniform buffer 는 HOST_VISIBLE 이 필수이고 DEVICE_LOCAL 이면 더 좋음)
+	bool CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, jMemoryAllocation& bufferMemory
+		, VkMemoryPropertyFlags preferredProperties = 0)
 	{
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -2321,63 +3323,107 @@ private:
 		VkMemoryRequirements memRequirements;
 		vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits
-			, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-		if (!ensure(vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) == VK_SUCCESS))
+		if (!ensure(memoryAllocator.Allocate(memRequirements, properties, preferredProperties, true, false, bufferMemory)))
 			return false;
 
-		// 마지막 파라메터 0은 메모리 영역의 offset 임.
-		// 이 값이 0이 아니면 memRequirements.alignment 로 나눠야 함. (align 되어있다는 의미)
-		vkBindBufferMemory(device, buffer, bufferMemory, 0);
+		// 마지막 파라메터는 메모리 영역의 offset 임.
+		// 이 값은 memRequirements.alignment 로 나눠져야 함. (align 되어있다는 의미) 할당자가 맞춰서 돌려줌.
+		vkBindBufferMemory(device, buffer, bufferMemory.Memory, bufferMemory.Offset);
 
 		return true;
 	}
 
-	void UpdateUniformBuffer(uint32_t currentImage)
+	bool UpdateUniformBuffer(uint32_t frameIndex, jUniformAllocation& outSceneUniform)
 	{
-		static auto startTime = std::chrono::high_resolution_clock::now();
-
-		auto currentTime = std::chrono::high_resolution_clock::now();
-		float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
-
 		jUniformBufferObject ubo = {};
-		ubo.Model.SetIdentity();
 		ubo.View.SetIdentity();
 		ubo.Proj.SetIdentity();
-		//ubo.Model = Matrix::MakeRotate(Vector(0.0f, 0.0f, 1.0f), time * DegreeToRadian(90.0f)).GetTranspose();
-		ubo.Model = Matrix::MakeRotate(Vector(0.0f, 0.0f, 1.0f), DegreeToRadian(245.0f)).GetTranspose();
 		ubo.View = jCameraUtil::CreateViewMatrix(Vector(2.0f, 2.0f, 2.0f), Vector(0.0f, 0.0f, 0.0f), Vector(0.0f, 0.0f, 1.0f)).GetTranspose();
 		ubo.Proj = jCameraUtil::CreatePerspectiveMatrix(static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height)
 			, DegreeToRadian(45.0f), 10.0f, 0.1f).GetTranspose();
 		ubo.Proj.m[1][1] *= -1;
 
-		//ubo.Model.SetTranslate({ 0.2f, 0.2f,0.2f });
-		//ubo.Model = ubo.Model.MakeRotateZ(time * DegreeToRadian(90.0f));
+		// GPU 컬링용. 쉐이더에서 읽는 행렬은 Transpose 되어 있으므로 쉐이더의 Proj * View 는 C++ 에서 View * Proj 임.
+		cullViewProj = ubo.View * ubo.Proj;
+
+		// 이 프레임의 이전 작업이 끝난 것은 DrawFrame 에서 Frame context 의 제출 값을 기다려서 보장되므로 구간을 바로 재사용함.
+		uniformRing.BeginFrame(frameIndex);
+		return uniformRing.Write(ubo, outSceneUniform);
+	}
+
+	// 이번 프레임의 인스턴스 데이터를 renderObjects 순서로 씀.
+	// Bindless 경로는 오브젝트 Storage buffer 로 읽는 jObjectData, 아닌 경로는 인스턴스 버텍스 스트림으로 읽는 jInstanceData 를 씀.
+	bool UpdateInstanceBuffer(uint32_t frameIndex, jUniformAllocation& outInstances)
+	{
+		if (renderObjects.empty())
+			return true;
+
+		instanceRing.BeginFrame(frameIndex);
+		if (useBindless)
+		{
+			if (!instanceRing.Allocate(sizeof(jObjectData) * renderObjects.size(), outInstances))
+				return false;
 
-		void* data;
-		vkMapMemory(device, uniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
-		memcpy(data, &ubo, sizeof(ubo));
-		vkUnmapMemory(device, uniformBuffersMemory[currentImage]);
+			jObjectData* objectData = static_cast<jObjectData*>(outInstances.MappedData);
+			for (size_t i = 0; i < renderObjects.size(); ++i)
+			{
+				objectData[i].Model = renderObjects[i].Model;
+				objectData[i].TextureIndex = renderObjects[i].TextureIndex;
+			}
+			return true;
+		}
+
+		if (!instanceRing.Allocate(sizeof(jInstanceData) * renderObjects.size(), outInstances))
+			return false;
+
+		jInstanceData* instanceData = static_cast<jInstanceData*>(outInstances.MappedData);
+		for (size_t i = 0; i < renderObjects.size(); ++i)
+			instanceData[i].Model = renderObjects[i].Model;
+		return true;
 	}
 
-	VkSampleCountFlagBits GetMaxUsableSampleCount()
+	// 이번 프레임의 드로우 방식에 맞춰 Indirect 드로우 데이터를 씀. Direct 면 아무것도 하지 않음.
+	// IndirectCpu : 배치 마다 커맨드 하나를 바로 씀.
+	// IndirectGpu : 오브젝트 마다 커맨드 슬롯만 잡아두고 배치 정보를 씀. 커맨드는 RecordCullPass 의 Compute 쉐이더가 채움.
+	bool UpdateIndirectBuffer(uint32_t frameIndex, const jUniformAllocation& instances, jIndirectDraws& outIndirect)
 	{
-		VkPhysicalDeviceProperties physicalDeviceProperties;
-		vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+		outIndirect = jIndirectDraws();
+		if ((drawSubmitMode == jDrawSubmitMode::Direct) || drawBatches.empty())
+			return true;
 
-		VkSampleCountFlags counts = physicalDeviceProperties.limits.framebufferColorSampleCounts & physicalDeviceProperties.limits.framebufferDepthSampleCounts;
-		if (counts & VK_SAMPLE_COUNT_64_BIT) { return VK_SAMPLE_COUNT_64_BIT; }
-		if (counts & VK_SAMPLE_COUNT_32_BIT) { return VK_SAMPLE_COUNT_32_BIT; }
-		if (counts & VK_SAMPLE_COUNT_16_BIT) { return VK_SAMPLE_COUNT_16_BIT; }
-		if (counts & VK_SAMPLE_COUNT_8_BIT) { return VK_SAMPLE_COUNT_8_BIT; }
-		if (counts & VK_SAMPLE_COUNT_4_BIT) { return VK_SAMPLE_COUNT_4_BIT; }
-		if (counts & VK_SAMPLE_COUNT_2_BIT) { return VK_SAMPLE_COUNT_2_BIT; }
+		indirectRing.BeginFrame(frameIndex);
+		if (drawSubmitMode == jDrawSubmitMode::IndirectCpu)
+		{
+			if (!indirectRing.Allocate(sizeof(VkDrawIndexedIndirectCommand) * drawBatches.size(), outIndirect.Commands))
+				return false;
+
+			const uint32_t baseInstance = GetBaseInstance(instances);
+			VkDrawIndexedIndirectCommand* commands = static_cast<VkDrawIndexedIndirectCommand*>(outIndirect.Commands.MappedData);
+			for (size_t i = 0; i < drawBatches.size(); ++i)
+			{
+				commands[i].indexCount = static_cast<uint32_t>(indices.size());
+				commands[i].instanceCount = drawBatches[i].InstanceCount;
+				commands[i].firstIndex = 0;
+				commands[i].vertexOffset = 0;
+				commands[i].firstInstance = baseInstance + drawBatches[i].FirstInstance;
+			}
+			return true;
+		}
 
-		return VK_SAMPLE_COUNT_1_BIT;
+		if (!indirectRing.Allocate(sizeof(VkDrawIndexedIndirectCommand) * renderObjects.size(), outIndirect.Commands)
+			|| !indirectRing.Allocate(sizeof(jCullBatch) * drawBatches.size(), outIndirect.Batches))
+		{
+			return false;
+		}
+
+		jCullBatch* batches = static_cast<jCullBatch*>(outIndirect.Batches.MappedData);
+		for (size_t i = 0; i < drawBatches.size(); ++i)
+		{
+			batches[i] = jCullBatch();
+			batches[i].FirstInstance = drawBatches[i].FirstInstance;
+			batches[i].InstanceCount = drawBatches[i].InstanceCount;
+		}
+		return true;
 	}
 
 	bool CreateColorResources()
@@ -2411,6 +3457,8 @@ private:
 
 	// 물리 디바이스 - 물리 그래픽 카드를 선택
 	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	jDeviceCapabilities deviceCapabilities;			// PickPhysicalDevice 이후 채워지는 물리 디바이스 속성 캐시
+	QueueFamilyIndices physicalDeviceQueueFamilies;
 
 	// Queue Families
 	// 여러종류의 Queue type이 있을 수 있다. (ex. Compute or memory transfer related commands 만 만듬)
@@ -2418,6 +3466,7 @@ private:
 	// - 논리 디바이스가 소멸될때 함께 알아서 소멸됨, 그래서 Cleanup 해줄필요가 없음.
 	VkQueue graphicsQueue;
 	VkQueue presentQueue;
+	VkQueue transferQueue = VK_NULL_HANDLE;		// 전용 Transfer queue 를 쓰는 경우에만 있음
 
 	// 논리 디바이스 생성
 	VkDevice device;
@@ -2439,40 +3488,90 @@ private:
 	VkRenderPass renderPass;
 	VkDescriptorSetLayout descriptorSetLayout;
 	VkPipelineLayout pipelineLayout;
-	VkPipeline graphicsPipeline;
+	jShaderReflection sceneReflection;				// 씬 쉐이더(vertex + fragment) 의 리소스 인터페이스. 레이아웃을 여기서 만듬
+	jShaderCache shaderCache;
+	jFileWatcher shaderWatcher;
+	jPipelineStateCache pipelineStateCache;
+	jPipelineHandle scenePipeline = INVALID_PIPELINE_HANDLE;		// 다른 조합들의 Fallback
+	jPipelineHandle wireframePipeline = INVALID_PIPELINE_HANDLE;	// W 키로 처음 켤때 백그라운드에서 컴파일함
+	jPipelineHandle overridePipeline = INVALID_PIPELINE_HANDLE;		// 이번 프레임에 모든 오브젝트를 이것으로 그림 (ex. 와이어프레임)
+	bool wireframe = false;
+
+	std::vector<jMaterial> materials;
+	std::vector<jPipelineHandle> materialPipelines;					// materials 와 같은 순서. 아직 요청하지 않았으면 INVALID_PIPELINE_HANDLE
+	uint32_t materialVariantIndex = 0;
 
 	// Framebuffers
 	std::vector<VkFramebuffer> swapChainFramebuffers;
 
 	// Command buffers
-	VkCommandPool commandPool;		// 커맨드 버퍼를 저장할 메모리 관리자로 커맨드 버퍼를 생성함.
-	std::vector<VkCommandBuffer> commandBuffers;
-
-	// Semaphores
-#if MULTIPLE_FRAME
-	// Semaphore 들은 GPU - GPU 간의 동기화를 맞춰줌. 여러개의 프레임이 동시에 만들어질 수 있게 함.
-	std::vector<VkSemaphore> imageAvailableSemaphores;
-	std::vector<VkSemaphore> renderFinishedSemaphores;
-	// CPU - GPU 간 동기화를 위해서 Fence를 사용함. MAX_FRAMES_IN_FLIGHT 보다 더 많은 수의 frame을 만들려고 시도하지 않게 해줌
-	std::vector<VkFence> inFlightFences;
-	std::vector<VkFence> imagesInFlight;		// 스왑체인 개수보다 MAX_FRAMES_IN_FLIGHT 가 더 많은 경우를 위해서 추가한 펜스
-	size_t currenFrame = 0;
-#else
-	VkSemaphore imageAvailableSemaphore;
-	VkSemaphore renderFinishedSemaphore;
-#endif // MULTIPLE_FRAME
+	jUploadContext uploadContext;	// 업로드 커맨드를 모아서 제출함. Staging ring 의 반환 시점도 이 제출 값으로 정함.
+	jUploadContext transferUploadContext;	// 전용 Transfer queue 에서 복사만 함. useTransferQueue 인 경우에만 사용.
+	bool useTransferQueue = false;
+	std::vector<jFrameContext> frameContexts;		// framesInFlight 개
+	uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+	uint32_t requestedFramesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+	jThreadPool recordThreadPool;
+	uint32_t recordJobCount = 1;		// 한 프레임을 나눠서 기록할 최대 작업 수 (jFrameContext::RecordContexts 의 수)
+
+	// 프레임 커맨드 버퍼 기록에 걸린 시간
+	double commandRecordTotalMs = 0.0;
+	double commandRecordMaxMs = 0.0;
+	uint64_t commandRecordCount = 0;
+
+	// Synchronization
+	// Queue 마다 하나의 Timeline semaphore 가 제출할때마다 1씩 증가하는 값을 Signal 함.
+	// CPU 는 이 값으로 GPU 를 기다리고(프레임, 업로드, Staging 메모리 재사용), Queue 끼리도 이 값으로 기다림. (Transfer -> Graphics)
+	jQueueTimeline graphicsTimeline;
+	jQueueTimeline transferTimeline;			// 전용 Transfer queue 를 쓰는 경우에만 있음
+	std::vector<uint64_t> swapChainImageSubmitValues;	// 스왑체인 이미지별로 마지막으로 사용한 프레임의 제출 값
+	jDeletionQueue deletionQueue;				// Graphics timeline 값 기준으로 지연 삭제
+	jPipelineCache pipelineCache;				// 모든 파이프라인 생성이 공유함
+	bool usePipelineCreationFeedback = false;	// VK_EXT_pipeline_creation_feedback 를 켰는지 여부
+	uint32_t currenFrame = 0;
 
 	bool framebufferResized = false;
+	uint32_t exitFrameCount = 0;
+	bool recordBenchmark = false;
 
 	std::vector<jVertex> vertices;
 	std::vector<uint32_t> indices;
+	std::vector<jRenderObject> renderObjects;
+	std::vector<jDrawBatch> drawBatches;				// renderObjects 를 머터리얼 별로 묶은 것. BuildDrawBatches 에서 만듬
 	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexBufferMemory;
+	jMemoryAllocation vertexBufferMemory;
 	VkBuffer indexBuffer;
-	VkDeviceMemory indexBufferMemory;
-
-	std::vector<VkBuffer> uniformBuffers;
-	std::vector<VkDeviceMemory> uniformBuffersMemory;
+	jMemoryAllocation indexBufferMemory;
+
+	// Uniform 데이터는 모두 하나의 Map 된 버퍼를 프레임별로 나눠서 씀. (VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+	VkBuffer uniformRingBuffer;
+	jMemoryAllocation uniformRingBufferMemory;
+	jUniformRingBuffer uniformRing;
+
+	// 프레임마다 renderObjects 순서로 인스턴스 데이터를 씀. Bindless 경로는 jObjectData 를 담는 오브젝트 Storage buffer, 아닌 경로는 jInstanceData 버텍스 스트림.
+	VkBuffer instanceRingBuffer = VK_NULL_HANDLE;
+	jMemoryAllocation instanceRingBufferMemory;
+	jUniformRingBuffer instanceRing;
+
+	// Indirect 드로우 커맨드와 GPU 컬링의 배치 정보. 프레임마다 드로우 방식에 맞춰 씀. (UpdateIndirectBuffer)
+	uint32_t drawSubmitMode = jDrawSubmitMode::Direct;		// jDrawSubmitMode::Type
+	bool useDrawIndirectCount = false;						// IndirectGpu 에서 vkCmdDrawIndexedIndirectCount 사용 (Vulkan 1.2 drawIndirectCount)
+	VkBuffer indirectRingBuffer = VK_NULL_HANDLE;
+	jMemoryAllocation indirectRingBufferMemory;
+	jUniformRingBuffer indirectRing;
+
+	// IndirectGpu 에서 오브젝트를 컬링하고 드로우 커맨드를 채우는 Compute 파이프라인. 만들지 못했으면 VK_NULL_HANDLE.
+	VkPipeline cullPipeline = VK_NULL_HANDLE;
+	VkPipelineLayout cullPipelineLayout = VK_NULL_HANDLE;
+	VkDescriptorSetLayout cullDescriptorSetLayout = VK_NULL_HANDLE;	// descriptorSetLayoutCache 가 소유함
+	jShaderReflection cullReflection;
+	Matrix cullViewProj;							// UpdateUniformBuffer 에서 씀
+	jSimpleVec3 meshBoundingCenter = {};			// 메시의 바운딩 스피어 (LoadModel)
+	float meshBoundingRadius = 0.0f;
+
+	bool bindlessAllowed = true;
+	bool useBindless = false;
+	jBindlessDescriptorSet bindlessDescriptors;
 
 	// Descriptor : 쉐이더가 버퍼나 이미지 같은 리소스에 자유롭게 접근하는 방법. 디스크립터의 사용방법은 아래 3가지로 구성됨.
 	//	1. Pipeline 생성 도중 Descriptor Set Layout 명세
@@ -2481,28 +3580,55 @@ private:
 	//
 	// Descriptor set layout	: 파이프라인을 통해 접근할 리소스 타입을 명세함
 	// Descriptor set			: Descriptor 에 묶일 실제 버퍼나 이미지 리소스를 명세함.
-	VkDescriptorPool descriptorPool;
-	std::vector<VkDescriptorSet> descriptorSets;		// DescriptorPool 이 소멸될때 자동으로 소멸되므로 따로 소멸시킬 필요없음.
+	// Descriptor set 은 jFrameContext::DescriptorAllocator 에서 매 프레임 할당하며, Pool 이 Reset 될때 한번에 반환됨.
+	jDescriptorSetLayoutCache descriptorSetLayoutCache;	// 모든 Descriptor set layout 을 소유함
+
+	// 업로드용 Staging 버퍼, 계속 Map 된 상태로 Ring 형태로 나눠 씀.
+	VkBuffer stagingRingBuffer;
+	jMemoryAllocation stagingRingBufferMemory;
+	jStagingRing stagingRing;
 
 	uint32_t textureMipLevels;
 	VkImage textureImage;
-	VkDeviceMemory textureImageMemory;
+	jMemoryAllocation textureImageMemory;
 	VkImageView textureImageView;
 	VkSampler textureSampler;
 
+	jSamplerCache samplerCache;
+
+	// 리소스들의 메모리는 모두 여기서 할당받음. (리소스 마다 vkAllocateMemory 하지 않음)
+	jMemoryAllocator memoryAllocator;
+
 	VkImage depthImage;
-	VkDeviceMemory depthImageMemory;
+	jMemoryAllocation depthImageMemory;
 	VkImageView depthImageView;
 
 	VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
 	VkImage colorImage;
-	VkDeviceMemory colorImageMemory;
+	jMemoryAllocation colorImageMemory;
 	VkImageView  colorImageView;
 };
 
-int main()
+int main(int argc, char** argv)
 {
 	HelloTriangleApplication app;
+
+	// --frames-in-flight N : 동시에 진행할 프레임 수 (실행 중에는 숫자키로 바꿀 수 있음)
+	// --no-bindless : Bindless 를 지원해도 Instance stream 경로로 그림
+	// --frames N : N 프레임을 그린 뒤 종료함
+	// --record-benchmark : 시작할때 커맨드 버퍼 기록 시간을 작업 수 별로 측정함
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--frames-in-flight") && ((i + 1) < argc))
+			app.SetFramesInFlight(static_cast<uint32_t>(atoi(argv[++i])));
+		else if (!strcmp(argv[i], "--no-bindless"))
+			app.SetBindlessAllowed(false);
+		else if (!strcmp(argv[i], "--frames") && ((i + 1) < argc))
+			app.SetExitFrameCount(static_cast<uint32_t>(atoi(argv[++i])));
+		else if (!strcmp(argv[i], "--record-benchmark"))
+			app.SetRecordBenchmark(true);
+	}
+
 	try
 	{
 		app.Run();